@@ -0,0 +1,203 @@
+/*
+Texture atlas allocator
+
+Each page keeps its skyline: the top edge of the packed area as a list of
+horizontal segments. A new rectangle goes where its top ends lowest, ties
+broken by the narrower segment, which keeps the skyline flat and the waste
+low for the similar sized images of UI and sprite sets. A skyline cannot
+give back single rectangles, so eviction works on whole pages: the page
+drawn from longest ago is emptied and repacked.
+ */
+
+#include "atlas.h"
+#include <string.h>
+
+static void reset_page(struct atlas* atlas, struct atlas_page* page) {
+    page->nodes[0] = (struct atlas_node) { 0, 0, atlas->size };
+    page->num_nodes = 1;
+    page->entries = 0;
+}
+
+static unsigned int hash_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= UINT64_C(0xff51afd7ed558ccd);
+    key ^= key >> 33;
+    return key % (ATLAS_MAX_ENTRIES * 2);
+}
+
+static void rebuild_slots(struct atlas* atlas) {
+    memset(atlas->slots, 0xff, sizeof(atlas->slots));
+    for (int i = 0; i < atlas->num_entries; i++) {
+        unsigned int slot = hash_key(atlas->entries[i].key);
+
+        while (atlas->slots[slot] >= 0)
+            slot = (slot + 1) % (ATLAS_MAX_ENTRIES * 2);
+        atlas->slots[slot] = i;
+    }
+}
+
+void atlas_init(struct atlas* atlas, int size, int max_pages, int padding) {
+    memset(atlas, 0, sizeof(*atlas));
+    atlas->size = size;
+    atlas->padding = padding;
+    atlas->max_pages = max_pages > ATLAS_MAX_PAGES ? ATLAS_MAX_PAGES : max_pages;
+    memset(atlas->slots, 0xff, sizeof(atlas->slots));
+}
+
+void atlas_next_frame(struct atlas* atlas) {
+    atlas->frame++;
+}
+
+bool atlas_lookup(struct atlas* atlas, uint64_t key, struct atlas_rect* rect) {
+    unsigned int slot = hash_key(key);
+
+    for (; atlas->slots[slot] >= 0; slot = (slot + 1) % (ATLAS_MAX_ENTRIES * 2)) {
+        const struct atlas_entry* entry = &atlas->entries[atlas->slots[slot]];
+
+        if (entry->key == key) {
+            *rect = entry->rect;
+            atlas->pages[rect->page].last_used = atlas->frame;
+            atlas->hits++;
+            return true;
+        }
+    }
+    atlas->misses++;
+    return false;
+}
+
+/* Lowest y at which a w wide rectangle fits with its left edge on node i, -1 if it does not */
+static int skyline_fit(const struct atlas* atlas, const struct atlas_page* page, int i, int w, int h) {
+    int x = page->nodes[i].x, y = 0, left = w;
+
+    if (x + w > atlas->size)
+        return -1;
+    for (; left > 0; i++) {
+        if (page->nodes[i].y > y)
+            y = page->nodes[i].y;
+        if (y + h > atlas->size)
+            return -1;
+        left -= page->nodes[i].width;
+    }
+    return y;
+}
+
+static bool skyline_insert(struct atlas* atlas, struct atlas_page* page, int w, int h, int* out_x, int* out_y) {
+    int best = -1, best_y = atlas->size, best_width = atlas->size + 1;
+    struct atlas_node node;
+
+    if (page->num_nodes == ATLAS_MAX_NODES)
+        return false;
+    for (int i = 0; i < page->num_nodes; i++) {
+        int y = skyline_fit(atlas, page, i, w, h);
+
+        if (y >= 0 && (y < best_y || (y == best_y && page->nodes[i].width < best_width))) {
+            best = i;
+            best_y = y;
+            best_width = page->nodes[i].width;
+        }
+    }
+    if (best < 0)
+        return false;
+
+    /* the new segment covers the rectangle's top, shadowed segments shrink or go */
+    node = (struct atlas_node) { page->nodes[best].x, best_y + h, w };
+    memmove(&page->nodes[best + 1], &page->nodes[best], (page->num_nodes - best) * sizeof(node));
+    page->nodes[best] = node;
+    page->num_nodes++;
+    for (int i = best + 1; i < page->num_nodes; i++) {
+        struct atlas_node* prev = &page->nodes[i - 1];
+        struct atlas_node* cur = &page->nodes[i];
+        int shrink = prev->x + prev->width - cur->x;
+
+        if (shrink <= 0)
+            break;
+        cur->x += shrink;
+        cur->width -= shrink;
+        if (cur->width > 0)
+            break;
+        memmove(cur, cur + 1, (page->num_nodes - i - 1) * sizeof(node));
+        page->num_nodes--;
+        i--;
+    }
+    /* merge neighbours at the same height */
+    for (int i = 0; i + 1 < page->num_nodes; i++) {
+        if (page->nodes[i].y == page->nodes[i + 1].y) {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            memmove(&page->nodes[i + 1], &page->nodes[i + 2], (page->num_nodes - i - 2) * sizeof(node));
+            page->num_nodes--;
+            i--;
+        }
+    }
+    *out_x = node.x;
+    *out_y = best_y;
+    return true;
+}
+
+/* Empty the page drawn from longest ago, unless it is in use this frame */
+static int evict_page(struct atlas* atlas) {
+    int victim = -1, n = 0;
+
+    for (int i = 0; i < atlas->num_pages; i++) {
+        if (atlas->pages[i].last_used == atlas->frame)
+            continue;
+        if (victim < 0 || atlas->pages[i].last_used < atlas->pages[victim].last_used)
+            victim = i;
+    }
+    if (victim < 0)
+        return -1;
+
+    for (int i = 0; i < atlas->num_entries; i++) {
+        if (atlas->entries[i].rect.page != victim)
+            atlas->entries[n++] = atlas->entries[i];
+    }
+    atlas->num_entries = n;
+    rebuild_slots(atlas);
+    reset_page(atlas, &atlas->pages[victim]);
+    atlas->evictions++;
+    return victim;
+}
+
+int atlas_insert(struct atlas* atlas, uint64_t key, int w, int h, struct atlas_rect* rect) {
+    const int pw = w + 2 * atlas->padding, ph = h + 2 * atlas->padding;
+    int page = -1, x, y, evicted = 0;
+    unsigned int slot;
+
+    if (pw > atlas->size || ph > atlas->size)
+        return -1;
+    if (atlas->num_entries == ATLAS_MAX_ENTRIES && evict_page(atlas) < 0)
+        return -1;
+
+    for (int i = 0; i < atlas->num_pages && page < 0; i++) {
+        if (skyline_insert(atlas, &atlas->pages[i], pw, ph, &x, &y))
+            page = i;
+    }
+    if (page < 0 && atlas->num_pages < atlas->max_pages) {
+        page = atlas->num_pages++;
+        reset_page(atlas, &atlas->pages[page]);
+        skyline_insert(atlas, &atlas->pages[page], pw, ph, &x, &y);
+    }
+    if (page < 0) {
+        page = evict_page(atlas);
+        if (page < 0 || !skyline_insert(atlas, &atlas->pages[page], pw, ph, &x, &y))
+            return -1;
+        evicted = 1;
+    }
+
+    rect->page = page;
+    rect->x = x + atlas->padding;
+    rect->y = y + atlas->padding;
+    rect->w = w;
+    rect->h = h;
+    rect->u0 = (float) rect->x / atlas->size;
+    rect->v0 = (float) rect->y / atlas->size;
+    rect->u1 = (float) (rect->x + w) / atlas->size;
+    rect->v1 = (float) (rect->y + h) / atlas->size;
+    atlas->pages[page].last_used = atlas->frame;
+    atlas->pages[page].entries++;
+
+    atlas->entries[atlas->num_entries] = (struct atlas_entry) { key, *rect };
+    for (slot = hash_key(key); atlas->slots[slot] >= 0; slot = (slot + 1) % (ATLAS_MAX_ENTRIES * 2))
+        ;
+    atlas->slots[slot] = atlas->num_entries++;
+    return evicted;
+}
@@ -0,0 +1,68 @@
+/*
+Texture atlas allocator: packs many small images into a few square pages
+with a skyline bottom-left packer, finds them again by a 64-bit key and
+evicts the least recently used page when everything is full. Only the
+bookkeeping lives here; the GL side uploads into the rectangles it hands out.
+ */
+
+#ifndef _ATLAS_H
+#define _ATLAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ATLAS_MAX_PAGES 8
+#define ATLAS_MAX_ENTRIES 2048
+#define ATLAS_MAX_NODES 256     /* skyline segments per page */
+
+struct atlas_rect {
+    int page;
+    int x, y, w, h;             /* texels, excluding the padding */
+    float u0, v0, u1, v1;
+};
+
+struct atlas_entry {
+    uint64_t key;
+    struct atlas_rect rect;
+};
+
+struct atlas_node {
+    int x, y, width;
+};
+
+struct atlas_page {
+    struct atlas_node nodes[ATLAS_MAX_NODES];
+    int num_nodes;
+    unsigned int last_used;     /* frame the page was last drawn from */
+    unsigned int entries;
+};
+
+struct atlas {
+    int size;                   /* page width and height */
+    int padding;                /* empty texels around entries, against filtering bleed */
+    int num_pages, max_pages;
+    struct atlas_page pages[ATLAS_MAX_PAGES];
+    struct atlas_entry entries[ATLAS_MAX_ENTRIES];
+    int num_entries;
+    int slots[ATLAS_MAX_ENTRIES * 2];   /* open addressing hash of entries, -1 = empty */
+    unsigned int frame;
+    /* statistics */
+    unsigned int hits, misses, evictions;
+};
+
+void atlas_init(struct atlas* atlas, int size, int max_pages, int padding);
+
+/* Start a frame: pages used from now on are not evicted until the next one */
+void atlas_next_frame(struct atlas* atlas);
+
+/* Find an entry and mark its page as used this frame */
+bool atlas_lookup(struct atlas* atlas, uint64_t key, struct atlas_rect* rect);
+
+/* Allocate w x h texels for key. Returns 0, 1 if the least recently used page
+ * had to be emptied for it (its old entries are gone, the page gets reused),
+ * or negative if the image cannot be placed: too large, or every page in use
+ * this frame.
+ */
+int atlas_insert(struct atlas* atlas, uint64_t key, int w, int h, struct atlas_rect* rect);
+
+#endif /* _ATLAS_H */
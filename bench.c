@@ -0,0 +1,712 @@
+/*
+Benchmark: standardized scenes drawn for a fixed number of frames each, on a KMS output
+like the demos or headless into a pbuffer (llvmpipe works), with the results written as
+JSON: frame time, CPU time and GPU time percentiles per scene. Compare two result files
+with bench_compare.py.
+
+The scenes stress one thing each:
+    fill    blended full-screen layers, fill rate and bandwidth
+    draws   thousands of tiny draws with uniform changes, driver overhead per draw
+    upload  a 1024x1024 RGBA texture rewritten every frame
+    stream  vertex data regenerated and uploaded every frame
+    shader  an ALU bound fragment shader over the whole screen
+ */
+
+#include "kmsdrm.h"
+
+#define BENCH_WARMUP 10                 /* frames per scene left out of the statistics */
+#define BENCH_QUERIES 4                 /* timer queries in flight */
+#define BENCH_HEADLESS_SIZE "1280x720"
+#define FILL_LAYERS 8
+#define DRAWS 2000
+#define UPLOAD_SIZE 1024
+#define STREAM_TRIANGLES 20000
+#define SHADER_ITERATIONS "64"
+
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUI64VEXTPROC) (GLuint id, GLenum pname, GLuint64* params);
+
+/* GL_TIME_ELAPSED queries: GL_EXT_disjoint_timer_query on GLES, GL_ARB_timer_query on GL */
+struct gpu_timer {
+    bool supported;
+    bool disjoint;              /* GL_GPU_DISJOINT_EXT exists, GLES only */
+    GLuint queries[BENCH_QUERIES];
+    unsigned int frames[BENCH_QUERIES];     /* frame each query measured */
+    unsigned int issued, done;
+    PFNGLGENQUERIESPROC gen_queries;
+    PFNGLBEGINQUERYPROC begin_query;
+    PFNGLENDQUERYPROC end_query;
+    PFNGLGETQUERYOBJECTUIVPROC get_query_uiv;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_ui64v;
+};
+
+struct bench {
+    int width, height;
+    unsigned int frames;                /* measured frames per scene */
+    int scenes[8];                      /* selected scenes, in run order */
+    int num_scenes;
+    unsigned int frame, total;
+    /* per frame samples, -1 where there is none */
+    int64_t* frame_ns;                  /* start of this frame to start of the next */
+    int64_t* cpu_ns;                    /* time spent issuing the frame's GL calls */
+    int64_t* gpu_ns;
+    int64_t last_start;
+    struct gpu_timer timer;
+    const struct egl* egl;
+    bool depth;                         /* every draw writes depth */
+
+    GLuint color_program, texture_program, shader_program;
+    GLint color_transform, color_color, shader_time;
+    GLuint quad_vbo, stream_vbo, texture;
+    uint32_t* upload_pixels[2];
+    GLfloat* stream_base;
+    GLfloat* stream_vertices;
+};
+
+static struct bench bench;
+
+static const char* position_vs_src =
+"attribute vec2 a_Position;\n"
+"uniform vec4 u_Transform;\n"
+"void main() {\n"
+"    gl_Position = vec4(a_Position * u_Transform.xy + u_Transform.zw, 0.0, 1.0);\n"
+"}";
+
+static const char* color_fs_src =
+"#ifdef GL_ES\n"
+"precision mediump float;\n"
+"#endif\n"
+"uniform vec4 u_Color;\n"
+"void main() {\n"
+"    gl_FragColor = u_Color;\n"
+"}";
+
+static const char* texcoord_vs_src =
+"attribute vec2 a_Position;\n"
+"attribute vec2 a_TexCoord;\n"
+"varying vec2 v_TexCoord;\n"
+"void main() {\n"
+"    gl_Position = vec4(a_Position, 0.0, 1.0);\n"
+"    v_TexCoord = a_TexCoord;\n"
+"}";
+
+static const char* texture_fs_src =
+"#ifdef GL_ES\n"
+"precision mediump float;\n"
+"#endif\n"
+"varying vec2 v_TexCoord;\n"
+"uniform sampler2D u_Texture;\n"
+"void main() {\n"
+"    gl_FragColor = texture2D(u_Texture, v_TexCoord);\n"
+"}";
+
+/* Julia set with a fixed iteration count, so every pixel costs the same */
+static const char* shader_fs_src =
+"#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+"precision highp float;\n"
+"#elif defined(GL_ES)\n"
+"precision mediump float;\n"
+"#endif\n"
+"varying vec2 v_TexCoord;\n"
+"uniform float u_Time;\n"
+"void main() {\n"
+"    vec2 z = v_TexCoord * 3.0 - 1.5;\n"
+"    vec2 c = vec2(-0.8 + 0.05 * sin(u_Time), 0.156);\n"
+"    float n = 0.0;\n"
+"    for (int i = 0; i < " SHADER_ITERATIONS "; i++) {\n"
+"        z = vec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + c;\n"
+"        n += step(dot(z, z), 4.0);\n"
+"    }\n"
+"    gl_FragColor = vec4(vec3(n / " SHADER_ITERATIONS ".0), 1.0);\n"
+"}";
+
+#define BENCH_POSITION 0
+#define BENCH_TEXCOORD 1
+
+static GLuint bench_program(const char* vs_src, const char* fs_src) {
+    int program = create_program(vs_src, fs_src);
+
+    if (program < 0)
+        return 0;
+    glBindAttribLocation(program, BENCH_POSITION, "a_Position");
+    glBindAttribLocation(program, BENCH_TEXCOORD, "a_TexCoord");
+    if (link_program(program))
+        return 0;
+    return program;
+}
+
+static void bind_quad(struct bench* b, bool texcoord) {
+    glBindBuffer(GL_ARRAY_BUFFER, b->quad_vbo);
+    glVertexAttribPointer(BENCH_POSITION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) 0);
+    glEnableVertexAttribArray(BENCH_POSITION);
+    if (texcoord) {
+        glVertexAttribPointer(BENCH_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) (2 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(BENCH_TEXCOORD);
+    } else {
+        glDisableVertexAttribArray(BENCH_TEXCOORD);
+    }
+}
+
+// ============================================================================================
+// Scenes
+// ============================================================================================
+
+static void draw_fill(struct bench* b, unsigned int frame) {
+    (void) frame;
+    glUseProgram(b->color_program);
+    bind_quad(b, false);
+    glUniform4f(b->color_transform, 1.0f, 1.0f, 0.0f, 0.0f);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    for (int i = 0; i < FILL_LAYERS; i++) {
+        glUniform4f(b->color_color, (i & 1) ? 1.0f : 0.2f, (i & 2) ? 1.0f : 0.2f, (i & 4) ? 1.0f : 0.2f, 0.25f);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    glDisable(GL_BLEND);
+}
+
+static void draw_draws(struct bench* b, unsigned int frame) {
+    const int columns = 50;
+    const float size = 2.0f / columns;
+
+    glUseProgram(b->color_program);
+    bind_quad(b, false);
+    for (int i = 0; i < DRAWS; i++) {
+        int x = i % columns, y = i / columns;
+
+        /* the quad is -1..1: half a cell wide, centered in its cell */
+        glUniform4f(b->color_transform, size / 4, size / 4, -1.0f + (x + 0.5f) * size, -1.0f + (y + 0.5f) * size);
+        glUniform4f(b->color_color, ((i + frame) & 255) / 255.0f, 0.5f, 1.0f - (i & 255) / 255.0f, 1.0f);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+}
+
+static void draw_upload(struct bench* b, unsigned int frame) {
+    glUseProgram(b->texture_program);
+    bind_quad(b, true);
+    glBindTexture(GL_TEXTURE_2D, b->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, UPLOAD_SIZE, UPLOAD_SIZE, GL_RGBA, GL_UNSIGNED_BYTE,
+        b->upload_pixels[frame & 1]);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+static void draw_stream(struct bench* b, unsigned int frame) {
+    const int count = STREAM_TRIANGLES * 3 * 2;
+    const float dx = (frame % 64) / 320.0f;
+
+    /* regenerate like a particle system would, then hand the driver a new buffer */
+    for (int i = 0; i < count; i += 2) {
+        b->stream_vertices[i] = b->stream_base[i] + dx;
+        b->stream_vertices[i + 1] = b->stream_base[i + 1];
+    }
+    glUseProgram(b->color_program);
+    glUniform4f(b->color_transform, 1.0f, 1.0f, 0.0f, 0.0f);
+    glUniform4f(b->color_color, 1.0f, 1.0f, 0.0f, 1.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, b->stream_vbo);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(GLfloat), b->stream_vertices, GL_STREAM_DRAW);
+    glVertexAttribPointer(BENCH_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (void*) 0);
+    glEnableVertexAttribArray(BENCH_POSITION);
+    glDisableVertexAttribArray(BENCH_TEXCOORD);
+    glDrawArrays(GL_TRIANGLES, 0, STREAM_TRIANGLES * 3);
+}
+
+static void draw_shader(struct bench* b, unsigned int frame) {
+    glUseProgram(b->shader_program);
+    bind_quad(b, true);
+    glUniform1f(b->shader_time, frame / 60.0f);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+static const struct {
+    const char* name;
+    void (*draw)(struct bench* b, unsigned int frame);
+} scenes[] = {
+    { "fill", draw_fill },
+    { "draws", draw_draws },
+    { "upload", draw_upload },
+    { "stream", draw_stream },
+    { "shader", draw_shader },
+};
+
+static int init_scenes(struct bench* b) {
+    static const GLfloat quad[] = {
+        /* x, y, u, v */
+        -1.0f, -1.0f, 0.0f, 0.0f,
+        1.0f, -1.0f, 1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f,
+    };
+    const int count = STREAM_TRIANGLES * 3 * 2;
+
+    b->color_program = bench_program(position_vs_src, color_fs_src);
+    b->texture_program = bench_program(texcoord_vs_src, texture_fs_src);
+    b->shader_program = bench_program(texcoord_vs_src, shader_fs_src);
+    if (!b->color_program || !b->texture_program || !b->shader_program) {
+        printf("init_scenes: failed to build the shaders\n");
+        return -1;
+    }
+    if (b->depth) {
+        /* depth writes on every pixel drawn, without rejecting any */
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+    }
+    b->color_transform = glGetUniformLocation(b->color_program, "u_Transform");
+    b->color_color = glGetUniformLocation(b->color_program, "u_Color");
+    b->shader_time = glGetUniformLocation(b->shader_program, "u_Time");
+
+    glGenBuffers(1, &b->quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, b->quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glGenBuffers(1, &b->stream_vbo);
+
+    /* two frames of pixels, so every upload changes the texture */
+    for (int i = 0; i < 2; i++) {
+        b->upload_pixels[i] = malloc(UPLOAD_SIZE * UPLOAD_SIZE * 4);
+        if (!b->upload_pixels[i])
+            return -1;
+        for (int p = 0; p < UPLOAD_SIZE * UPLOAD_SIZE; p++)
+            b->upload_pixels[i][p] = ((p >> (4 + i)) & 1) ? 0xffffffff : 0xff804000;
+    }
+    glGenTextures(1, &b->texture);
+    glBindTexture(GL_TEXTURE_2D, b->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, UPLOAD_SIZE, UPLOAD_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, b->upload_pixels[0]);
+
+    /* small triangles scattered over the screen, the same every run */
+    b->stream_base = malloc(count * sizeof(GLfloat));
+    b->stream_vertices = malloc(count * sizeof(GLfloat));
+    if (!b->stream_base || !b->stream_vertices)
+        return -1;
+    for (int t = 0, seed = 1; t < STREAM_TRIANGLES; t++) {
+        float x, y;
+
+        seed = seed * 1103515245 + 12345;
+        x = ((seed >> 8) & 1023) / 512.0f - 1.0f;
+        seed = seed * 1103515245 + 12345;
+        y = ((seed >> 8) & 1023) / 512.0f - 1.0f;
+        GLfloat* v = &b->stream_base[t * 6];
+        v[0] = x;
+        v[1] = y;
+        v[2] = x + 0.02f;
+        v[3] = y;
+        v[4] = x;
+        v[5] = y + 0.02f;
+    }
+    glViewport(0, 0, b->width, b->height);
+    return 0;
+}
+
+static void destroy_scenes(struct bench* b) {
+    if (b->color_program)
+        glDeleteProgram(b->color_program);
+    if (b->texture_program)
+        glDeleteProgram(b->texture_program);
+    if (b->shader_program)
+        glDeleteProgram(b->shader_program);
+    if (b->quad_vbo)
+        glDeleteBuffers(1, &b->quad_vbo);
+    if (b->stream_vbo)
+        glDeleteBuffers(1, &b->stream_vbo);
+    if (b->texture)
+        glDeleteTextures(1, &b->texture);
+    free(b->upload_pixels[0]);
+    free(b->upload_pixels[1]);
+    free(b->stream_base);
+    free(b->stream_vertices);
+}
+
+// ============================================================================================
+// GPU timer
+// ============================================================================================
+
+static void init_gpu_timer(struct gpu_timer* timer, const struct egl* egl) {
+    const char* suffix = egl->api == GL_API_GL ? "" : "EXT";
+    char name[64];
+
+    if (!ext_set_has(&egl->gl_exts, egl->api == GL_API_GL ? "GL_ARB_timer_query" : "GL_EXT_disjoint_timer_query")) {
+        printf("init_gpu_timer: no timer queries, GPU times unavailable\n");
+        return;
+    }
+#define get_query_proc(field, base) do { \
+        snprintf(name, sizeof(name), "%s%s", base, suffix); \
+        timer->field = (void*) eglGetProcAddress(name); \
+    } while (0)
+    get_query_proc(gen_queries, "glGenQueries");
+    get_query_proc(begin_query, "glBeginQuery");
+    get_query_proc(end_query, "glEndQuery");
+    get_query_proc(get_query_uiv, "glGetQueryObjectuiv");
+    get_query_proc(get_query_ui64v, "glGetQueryObjectui64v");
+#undef get_query_proc
+    if (!timer->gen_queries || !timer->begin_query || !timer->end_query || !timer->get_query_uiv ||
+        !timer->get_query_ui64v)
+        return;
+    timer->gen_queries(BENCH_QUERIES, timer->queries);
+    timer->disjoint = egl->api == GL_API_GLES;
+    timer->supported = true;
+}
+
+/* Collect the oldest query: always if wait, else only once its result is in */
+static bool read_gpu_timer(struct gpu_timer* timer, int64_t* gpu_ns, bool wait) {
+    int slot = timer->done % BENCH_QUERIES;
+    GLuint available = 0;
+    GLuint64 elapsed = 0;
+    GLint disjoint = 0;
+
+    if (timer->done == timer->issued)
+        return false;
+    if (!wait) {
+        timer->get_query_uiv(timer->queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return false;
+    }
+    timer->get_query_ui64v(timer->queries[slot], GL_QUERY_RESULT, &elapsed);
+    /* a disjoint event (power state change, reset) makes the result meaningless */
+    if (timer->disjoint)
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    gpu_ns[timer->frames[slot]] = disjoint ? -1 : (int64_t) elapsed;
+    timer->done++;
+    return true;
+}
+
+// ============================================================================================
+// Frames and statistics
+// ============================================================================================
+
+static void bench_frame(struct bench* b) {
+    unsigned int frame = b->frame++;
+    int scene = b->scenes[frame / (BENCH_WARMUP + b->frames)];
+    struct gpu_timer* timer = &b->timer;
+    int64_t start = get_time_ns(), draw_start;
+
+    if (frame)
+        b->frame_ns[frame - 1] = start - b->last_start;
+    b->last_start = start;
+
+    if (timer->supported) {
+        /* results of earlier frames first, so polling does not flush this one */
+        while (read_gpu_timer(timer, b->gpu_ns, timer->issued - timer->done == BENCH_QUERIES))
+            ;
+        timer->frames[timer->issued % BENCH_QUERIES] = frame;
+        timer->begin_query(GL_TIME_ELAPSED_EXT, timer->queries[timer->issued % BENCH_QUERIES]);
+    }
+    draw_start = get_time_ns();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    gl_frame_begin(b->egl, GL_COLOR_BUFFER_BIT);
+    scenes[scene].draw(b, frame % (BENCH_WARMUP + b->frames));
+    if (timer->supported) {
+        timer->end_query(GL_TIME_ELAPSED_EXT);
+        timer->issued++;
+    }
+    b->cpu_ns[frame] = get_time_ns() - draw_start;
+}
+
+/* gl_client: the benchmark draws on the first output only */
+static int64_t draw_bench_frame(void* data, const struct egl* egl, struct drm* drm, int index) {
+    struct bench* b = data;
+
+    (void) egl, (void) drm;
+    if (index != 0)
+        return 0;
+    if (b->frame < b->total)
+        bench_frame(b);
+    else if (b->frame_ns[b->total - 1] < 0)
+        b->frame_ns[b->total - 1] = get_time_ns() - b->last_start;
+    return 0;
+}
+
+static int compare_int64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*) a, y = *(const int64_t*) b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* Percentiles of the samples >= 0 in ms, as a JSON object; null without samples */
+static void write_stats(FILE* out, const char* name, const int64_t* samples, int count) {
+    /* -n sets count: too much for the stack */
+    int64_t* sorted = malloc((count > 0 ? count : 1) * sizeof(int64_t));
+    int64_t sum = 0;
+    int n = 0;
+
+    if (!sorted) {
+        printf("write_stats: out of memory\n");
+        fprintf(out, "      \"%s\": null", name);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (samples[i] >= 0) {
+            sorted[n++] = samples[i];
+            sum += samples[i];
+        }
+    }
+    if (!n) {
+        fprintf(out, "      \"%s\": null", name);
+        free(sorted);
+        return;
+    }
+    qsort(sorted, n, sizeof(sorted[0]), compare_int64);
+    /* nearest rank */
+#define percentile(p) (sorted[(int) ((p) * n + 0.999999) - 1 > 0 ? (int) ((p) * n + 0.999999) - 1 : 0] / 1e6)
+    fprintf(out, "      \"%s\": { \"avg\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+        name, sum / 1e6 / n, sorted[0] / 1e6, percentile(0.5), percentile(0.9), percentile(0.99), sorted[n - 1] / 1e6);
+#undef percentile
+    free(sorted);
+}
+
+/* s as a JSON string */
+static void write_string(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; s && *s; s++) {
+        if (*s == '"' || *s == '\\')
+            fprintf(out, "\\%c", *s);
+        else if ((unsigned char) *s < 0x20)
+            fprintf(out, "\\u%04x", *s);
+        else
+            fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+static int write_results(const struct bench* b, const struct egl* egl, const char* path, bool headless,
+    unsigned int vrefresh) {
+    FILE* out = fopen(path, "w");
+
+    if (!out) {
+        printf("write_results: cannot write %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(out, "{\n  \"version\": 1,\n  \"profile\": \"%s\",\n  \"api\": \"%s\",\n  \"renderer\": ", PROFILE_NAME,
+        egl->api == GL_API_GL ? "gl" : "gles");
+    write_string(out, (const char*) glGetString(GL_RENDERER));
+    fprintf(out, ",\n  \"gl_version\": ");
+    write_string(out, (const char*) glGetString(GL_VERSION));
+    fprintf(out, ",\n  \"headless\": %s,\n  \"width\": %d,\n  \"height\": %d,\n  \"refresh\": %u,\n"
+        "  \"depth_size\": %d,\n  \"stencil_size\": %d,\n  \"invalidate\": %s,\n"
+        "  \"frames\": %u,\n  \"warmup\": %d,\n  \"scenes\": {\n",
+        headless ? "true" : "false", b->width, b->height, vrefresh, egl->depth_size, egl->stencil_size,
+        egl->discard_depth_stencil ? "true" : "false", b->frames, BENCH_WARMUP);
+    for (int i = 0; i < b->num_scenes; i++) {
+        /* the measured frames of the scene; the last frame has no successor to end its frame time */
+        unsigned int first = i * (BENCH_WARMUP + b->frames) + BENCH_WARMUP;
+        unsigned int count = b->frames;
+        int64_t sum = 0;
+        int n = 0;
+
+        for (unsigned int f = first; f < first + count; f++) {
+            if (b->frame_ns[f] >= 0) {
+                sum += b->frame_ns[f];
+                n++;
+            }
+        }
+        fprintf(out, "    \"%s\": {\n      \"fps\": %.2f,\n", scenes[b->scenes[i]].name, sum ? n * 1e9 / sum : 0.0);
+        write_stats(out, "frame_ms", &b->frame_ns[first], count);
+        fprintf(out, ",\n");
+        write_stats(out, "cpu_ms", &b->cpu_ns[first], count);
+        fprintf(out, ",\n");
+        write_stats(out, "gpu_ms", &b->gpu_ns[first], count);
+        fprintf(out, "\n    }%s\n", i + 1 < b->num_scenes ? "," : "");
+    }
+    fprintf(out, "  }\n}\n");
+    fclose(out);
+    printf("Results written to %s\n", path);
+    return 0;
+}
+
+// ============================================================================================
+// main
+// ============================================================================================
+
+static const char* api_names[] = { "auto", "gles", "gl" };
+
+static const struct option longopts[] = {
+    {"device",      required_argument, 0, 'D'},
+    {"headless",    no_argument,       0, 'H'},
+    {"mode",        required_argument, 0, 'm'},
+    {"frames",      required_argument, 0, 'n'},
+    {"output",      required_argument, 0, 'o'},
+    {"scenes",      required_argument, 0, 'S'},
+    {"api",         required_argument, 0, 'A'},
+    {"depth",       no_argument,       0, 'z'},
+    {"keep-depth",  no_argument,       0, 'K'},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+static void usage(const char* name) {
+    printf("Usage: %s [-DHmnoSAzKh]\n"
+        "\n"
+        "options:\n"
+        "    -D, --device=DEVICE      use the given device\n"
+        "    -H, --headless           render into a pbuffer, no display (LIBGL_ALWAYS_SOFTWARE=1\n"
+        "                             for llvmpipe)\n"
+        "    -m, --mode=MODE          video mode, or the pbuffer size headless (default " BENCH_HEADLESS_SIZE ")\n"
+        "    -n, --frames=N           measured frames per scene (default 300)\n"
+        "    -o, --output=FILE        JSON results (default bench.json)\n"
+        "    -S, --scenes=LIST        comma separated: fill,draws,upload,stream,shader (default all)\n"
+        "    -A, --api=API            auto, gles or gl (default auto)\n"
+        "    -z, --depth              render with a 24 bit depth and 8 bit stencil buffer\n"
+        "    -K, --keep-depth         with --depth, do not invalidate them at the end of the frame\n"
+        "    -h, --help               show this help\n",
+        name);
+}
+
+static int select_scenes(struct bench* b, const char* list) {
+    b->num_scenes = 0;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        unsigned int i = 0;
+
+        while (i < ARRAY_SIZE(scenes) && (strlen(scenes[i].name) != len || strncmp(list, scenes[i].name, len)))
+            i++;
+        if (i == ARRAY_SIZE(scenes) || b->num_scenes == (int) ARRAY_SIZE(b->scenes)) {
+            printf("unknown scene %.*s\n", (int) len, list);
+            return -1;
+        }
+        b->scenes[b->num_scenes++] = i;
+        list += len;
+        if (*list == ',')
+            list++;
+    }
+    return b->num_scenes ? 0 : -1;
+}
+
+int main(int argc, char* argv[]) {
+    static struct gbm gbm;
+    static struct drm drm;
+    static struct egl egl;
+    const struct gl_client client = { &bench, draw_bench_frame, NULL };
+    struct bench* b = &bench;
+    const char* device = NULL;
+    const char* mode = NULL;
+    const char* output = "bench.json";
+    enum gl_api api = GL_API_AUTO;
+    bool headless = false, keep_depth = false;
+    unsigned int vrefresh = 0;
+    int opt, ret;
+
+    b->frames = 300;
+    select_scenes(b, "fill,draws,upload,stream,shader");
+    while ((opt = getopt_long(argc, argv, "D:Hm:n:o:S:A:zKh", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'D':
+            device = optarg;
+            break;
+        case 'H':
+            headless = true;
+            break;
+        case 'm':
+            mode = optarg;
+            break;
+        case 'n':
+            b->frames = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'S':
+            if (select_scenes(b, optarg))
+                return -1;
+            break;
+        case 'A': {
+            unsigned int i = 0;
+
+            while (i < ARRAY_SIZE(api_names) && strcmp(optarg, api_names[i]))
+                i++;
+            if (i == ARRAY_SIZE(api_names)) {
+                printf("unknown api %s, use auto, gles or gl\n", optarg);
+                return -1;
+            }
+            api = i;
+            break;
+        }
+        case 'z':
+            b->depth = true;
+            break;
+        case 'K':
+            keep_depth = true;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    b->total = b->num_scenes * (BENCH_WARMUP + b->frames);
+    b->frame_ns = malloc(b->total * sizeof(int64_t));
+    b->cpu_ns = malloc(b->total * sizeof(int64_t));
+    b->gpu_ns = malloc(b->total * sizeof(int64_t));
+    if (!b->frame_ns || !b->cpu_ns || !b->gpu_ns)
+        return -1;
+    for (unsigned int i = 0; i < b->total; i++)
+        b->frame_ns[i] = b->cpu_ns[i] = b->gpu_ns[i] = -1;
+
+    gbm.format = DRM_FORMAT_XRGB8888;
+    if (headless) {
+        if (sscanf(mode ? mode : BENCH_HEADLESS_SIZE, "%dx%d", &gbm.width, &gbm.height) != 2) {
+            printf("headless size must be WxH\n");
+            return -1;
+        }
+    } else {
+        char mode_str[DRM_DISPLAY_MODE_LEN] = "";
+
+        if (mode)
+            snprintf(mode_str, sizeof(mode_str), "%s", mode);
+        ret = init_drm(&drm, device, mode_str, -1, 0, b->total + 1, false);
+        if (ret)
+            return ret;
+        ret = init_gbm(&gbm, &drm, drm.mode->hdisplay, drm.mode->vdisplay, DRM_FORMAT_XRGB8888, false);
+        if (ret)
+            return ret;
+        vrefresh = drm.mode->vrefresh;
+    }
+    ret = init_egl(&egl, &gbm, 0, b->depth ? 24 : 0, b->depth ? 8 : 0, api);
+    if (ret)
+        return ret;
+    if (keep_depth)
+        egl.discard_depth_stencil = false;
+    b->egl = &egl;
+    if (!headless && init_output_surfaces(&gbm, &egl, &drm))
+        return -1;
+    b->width = gbm.width;
+    b->height = gbm.height;
+
+    ret = init_scenes(b);
+    if (!ret) {
+        init_gpu_timer(&b->timer, &egl);
+        printf("Benchmark: %d scene(s), %u frames each after %d warmup frames, %dx%d%s\n", b->num_scenes,
+            b->frames, BENCH_WARMUP, b->width, b->height, headless ? " headless" : "");
+        if (headless) {
+            /* no vsync to wait for: a frame is done when the GPU is done with it */
+            while (b->frame < b->total) {
+                bench_frame(b);
+                gl_frame_end(&egl);
+                eglSwapBuffers(egl.display, egl.surface);
+                glFinish();
+                startup_trace_first_frame();
+            }
+            b->frame_ns[b->total - 1] = get_time_ns() - b->last_start;
+        } else {
+            ret = run_gl_loop(&gbm, &egl, &drm, &client);
+            restore_drm(&drm);
+        }
+        while (b->timer.supported && read_gpu_timer(&b->timer, b->gpu_ns, true))
+            ;
+        if (!ret && b->frame == b->total)
+            ret = write_results(b, &egl, output, headless, vrefresh);
+        else if (!ret)
+            printf("Benchmark interrupted after %u of %u frames, no results\n", b->frame, b->total);
+    }
+    destroy_scenes(b);
+    destroy_kmsdrm(&gbm, &egl, &drm);
+    free(b->frame_ns);
+    free(b->cpu_ns);
+    free(b->gpu_ns);
+    return ret;
+}
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Compare two kmsdrm_bench JSON results: bench_compare.py OLD.json NEW.json
+
+Prints every scene and metric of both runs with the change in percent; for the
+times lower is better, for fps higher is. Exits 1 when a time metric got worse
+by more than --threshold percent, so a script can gate on it.
+"""
+
+import argparse
+import json
+import sys
+
+METRICS = ("frame_ms", "cpu_ms", "gpu_ms")
+STATS = ("avg", "p50", "p90", "p99")
+
+
+def delta(old, new):
+    if old is None or new is None or old == 0:
+        return None
+    return (new - old) / old * 100.0
+
+
+def row(name, old, new, worse_if_higher=True):
+    d = delta(old, new)
+    fmt = lambda v: "-" if v is None else "%.3f" % v
+    mark = ""
+    if d is not None:
+        mark = "%+.1f%%" % d
+    print("  %-16s %12s %12s %9s" % (name, fmt(old), fmt(new), mark))
+    if d is None:
+        return 0.0
+    return d if worse_if_higher else -d
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="regression limit for the time percentiles in percent (default 5)")
+    args = parser.parse_args()
+
+    with open(args.old) as f:
+        old = json.load(f)
+    with open(args.new) as f:
+        new = json.load(f)
+
+    for key in ("renderer", "api", "profile", "width", "height", "headless"):
+        if old.get(key) != new.get(key):
+            print("note: %s differs: %s vs %s" % (key, old.get(key), new.get(key)))
+
+    regressions = []
+    for scene, new_scene in new["scenes"].items():
+        old_scene = old["scenes"].get(scene)
+        if old_scene is None:
+            print("%s: not in %s" % (scene, args.old))
+            continue
+        print("%s" % scene)
+        row("fps", old_scene["fps"], new_scene["fps"], worse_if_higher=False)
+        for metric in METRICS:
+            old_stats, new_stats = old_scene.get(metric), new_scene.get(metric)
+            for stat in STATS:
+                worse = row("%s %s" % (metric, stat),
+                            old_stats and old_stats[stat], new_stats and new_stats[stat])
+                if worse > args.threshold:
+                    regressions.append("%s %s %s %+.1f%%" % (scene, metric, stat, worse))
+
+    if regressions:
+        print("\nregressions over %.1f%%:" % args.threshold)
+        for r in regressions:
+            print("  " + r)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
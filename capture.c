@@ -0,0 +1,340 @@
+/*
+Frame capture writer
+
+Frames arrive as mapped pixel-pack buffers: bottom-up rows of RGBA or BGRA.
+The worker flips them top-down, swizzles BGRA with SSE2 or NEON kernels and
+streams each scanline straight into the file, so no full frame copy is
+made. PNGs use stored (uncompressed) deflate blocks: bigger files, but the
+encoder keeps up with the frame rate without a zlib dependency.
+ */
+
+#include "capture.h"
+#include "kmsdrm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// ============================================================================================
+// pixel kernels
+// ============================================================================================
+
+/* RGBA -> RGBA with alpha forced opaque: scanout ignores alpha, so should screenshots */
+static void convert_rgba(uint32_t* dst, const uint32_t* src, int n) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_or_si128(_mm_loadu_si128((const __m128i*) (src + i)), alpha));
+#elif defined(__ARM_NEON)
+    const uint32x4_t alpha = vdupq_n_u32(0xff000000);
+    for (; i + 4 <= n; i += 4)
+        vst1q_u32(dst + i, vorrq_u32(vld1q_u32(src + i), alpha));
+#endif
+    for (; i < n; i++)
+        dst[i] = src[i] | 0xff000000;
+}
+
+/* BGRA -> RGBA (swap the bytes 0 and 2 of every pixel), alpha forced opaque */
+static void convert_bgra(uint32_t* dst, const uint32_t* src, int n) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i ga = _mm_set1_epi32((int) 0xff00ff00);
+    const __m128i rb = _mm_set1_epi32(0x000000ff);
+    const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), rb);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(p, rb), 16);
+        p = _mm_or_si128(_mm_or_si128(_mm_and_si128(p, ga), alpha), _mm_or_si128(r, b));
+        _mm_storeu_si128((__m128i*) (dst + i), p);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t p = vld4q_u8((const uint8_t*) (src + i));
+        uint8x16_t t = p.val[0];
+        p.val[0] = p.val[2];
+        p.val[2] = t;
+        p.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8((uint8_t*) (dst + i), p);
+    }
+#endif
+    for (; i < n; i++) {
+        uint32_t p = src[i];
+        dst[i] = 0xff000000 | (p & 0x0000ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+    }
+}
+
+// ============================================================================================
+// PNG writer (stored deflate)
+// ============================================================================================
+
+#define DEFLATE_BLOCK 65535
+
+static uint32_t crc_table[256];
+
+static void init_crc_table(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t* buf, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        crc = crc_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static uint32_t adler_update(uint32_t adler, const uint8_t* buf, size_t len) {
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+
+    while (len) {
+        /* 5552 bytes is the most that can be summed before b overflows */
+        size_t n = len < 5552 ? len : 5552;
+
+        len -= n;
+        while (n--) {
+            a += *buf++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+static void put_be32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+/* Streams the zlib data of an IDAT chunk whose total length is known up front */
+struct png_stream {
+    FILE* file;
+    uint32_t crc, adler;
+    size_t block_left;          /* bytes left in the current stored block */
+    size_t data_left;           /* uncompressed bytes still to come */
+};
+
+static void png_write(struct png_stream* png, const void* data, size_t len) {
+    png->crc = crc_update(png->crc, data, len);
+    fwrite(data, 1, len, png->file);
+}
+
+static void png_data(struct png_stream* png, const uint8_t* data, size_t len) {
+    png->adler = adler_update(png->adler, data, len);
+    while (len) {
+        size_t n;
+
+        if (!png->block_left) {
+            size_t block = png->data_left < DEFLATE_BLOCK ? png->data_left : DEFLATE_BLOCK;
+            uint8_t header[5] = { block == png->data_left, block & 0xff, block >> 8, ~block & 0xff, (~block >> 8) & 0xff };
+
+            png_write(png, header, sizeof(header));
+            png->block_left = block;
+        }
+        n = len < png->block_left ? len : png->block_left;
+        png_write(png, data, n);
+        png->block_left -= n;
+        png->data_left -= n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void png_chunk(FILE* file, const char* type, const uint8_t* data, uint32_t len) {
+    uint8_t buf[8];
+    uint32_t crc;
+
+    put_be32(buf, len);
+    memcpy(buf + 4, type, 4);
+    fwrite(buf, 1, 8, file);
+    fwrite(data, 1, len, file);
+    crc = crc_update(0xffffffff, (const uint8_t*) type, 4);
+    crc = crc_update(crc, data, len) ^ 0xffffffff;
+    put_be32(buf, crc);
+    fwrite(buf, 1, 4, file);
+}
+
+// ============================================================================================
+// worker
+// ============================================================================================
+
+static void write_frame(struct capture* cap, const uint8_t* pixels, unsigned int number) {
+    const size_t stride = (size_t) cap->width * 4;
+    const size_t raw_len = (stride + 1) * cap->height;
+    const size_t num_blocks = (raw_len + DEFLATE_BLOCK - 1) / DEFLATE_BLOCK;
+    struct png_stream png = { 0 };
+    int64_t convert_ns = 0, start = get_time_ns(), t;
+    char path[300];
+    FILE* file;
+
+    snprintf(path, sizeof(path), "%s-%05u.%s", cap->prefix, number, cap->raw ? "rgba" : "png");
+    file = fopen(path, "wb");
+    if (!file) {
+        printf("capture: cannot write %s\n", path);
+        return;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    if (!cap->raw) {
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        uint8_t ihdr[13] = { 0 };
+        uint8_t buf[4];
+
+        fwrite(signature, 1, sizeof(signature), file);
+        put_be32(ihdr, cap->width);
+        put_be32(ihdr + 4, cap->height);
+        ihdr[8] = 8;            /* bit depth */
+        ihdr[9] = 6;            /* RGBA */
+        png_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+
+        /* IDAT: zlib header, stored blocks, adler32 */
+        put_be32(buf, 2 + num_blocks * 5 + raw_len + 4);
+        fwrite(buf, 1, 4, file);
+        png.file = file;
+        png.crc = 0xffffffff;
+        png.adler = 1;
+        png.data_left = raw_len;
+        png_write(&png, "IDAT", 4);
+        png_write(&png, (const uint8_t[]) { 0x78, 0x01 }, 2);
+    }
+
+    for (int y = 0; y < cap->height; y++) {
+        /* glReadPixels rows are bottom-up */
+        const uint32_t* src = (const uint32_t*) (pixels + (cap->height - 1 - y) * stride);
+
+        t = get_time_ns();
+        if (cap->bgra)
+            convert_bgra((uint32_t*) (cap->row + 1), src, cap->width);
+        else
+            convert_rgba((uint32_t*) (cap->row + 1), src, cap->width);
+        convert_ns += get_time_ns() - t;
+
+        if (cap->raw) {
+            fwrite(cap->row + 1, 1, stride, file);
+        } else {
+            cap->row[0] = 0;    /* filter: none */
+            png_data(&png, cap->row, stride + 1);
+        }
+    }
+
+    if (!cap->raw) {
+        uint8_t buf[4];
+
+        put_be32(buf, png.adler);
+        png_write(&png, buf, 4);
+        put_be32(buf, png.crc ^ 0xffffffff);
+        fwrite(buf, 1, 4, file);
+        png_chunk(file, "IEND", NULL, 0);
+    }
+    fclose(file);
+
+    cap->convert_ns += convert_ns;
+    cap->write_ns += get_time_ns() - start - convert_ns;
+    cap->written++;
+}
+
+static void* capture_thread(void* data) {
+    struct capture* cap = data;
+
+    pthread_mutex_lock(&cap->lock);
+    while (true) {
+        int slot;
+
+        while (!cap->queue_len && !cap->quit)
+            pthread_cond_wait(&cap->cond, &cap->lock);
+        if (!cap->queue_len)
+            break;
+        slot = cap->queue[cap->queue_head];
+        pthread_mutex_unlock(&cap->lock);
+
+        write_frame(cap, cap->pixels[slot], cap->numbers[slot]);
+
+        pthread_mutex_lock(&cap->lock);
+        cap->queue_head = (cap->queue_head + 1) % CAPTURE_SLOTS;
+        cap->queue_len--;
+        cap->busy[slot] = false;
+        pthread_cond_broadcast(&cap->cond);
+    }
+    pthread_mutex_unlock(&cap->lock);
+    return NULL;
+}
+
+int capture_start(struct capture* cap, const char* prefix, bool raw, int width, int height, bool bgra) {
+    memset(cap, 0, sizeof(*cap));
+    snprintf(cap->prefix, sizeof(cap->prefix), "%s", prefix);
+    cap->raw = raw;
+    cap->bgra = bgra;
+    cap->width = width;
+    cap->height = height;
+    /* filter byte + pixels, so PNG rows need no extra copy */
+    cap->row = malloc((size_t) width * 4 + 4);
+    if (!cap->row)
+        return -1;
+    init_crc_table();
+    pthread_mutex_init(&cap->lock, NULL);
+    pthread_cond_init(&cap->cond, NULL);
+    if (pthread_create(&cap->thread, NULL, capture_thread, cap)) {
+        printf("capture_start: failed to create worker thread\n");
+        free(cap->row);
+        cap->row = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void capture_stop(struct capture* cap) {
+    if (!cap->row)
+        return;
+    pthread_mutex_lock(&cap->lock);
+    cap->quit = true;
+    pthread_cond_broadcast(&cap->cond);
+    pthread_mutex_unlock(&cap->lock);
+    pthread_join(cap->thread, NULL);
+    pthread_cond_destroy(&cap->cond);
+    pthread_mutex_destroy(&cap->lock);
+    free(cap->row);
+    cap->row = NULL;
+
+    if (cap->written)
+        printf("capture: %u frames written, convert %.3f ms/frame, write %.3f ms/frame (worker thread)\n",
+            cap->written, cap->convert_ns / 1e6 / cap->written, cap->write_ns / 1e6 / cap->written);
+}
+
+bool capture_busy(struct capture* cap, int slot) {
+    bool busy;
+
+    pthread_mutex_lock(&cap->lock);
+    busy = cap->busy[slot];
+    pthread_mutex_unlock(&cap->lock);
+    return busy;
+}
+
+void capture_submit(struct capture* cap, int slot, const void* pixels, unsigned int number) {
+    pthread_mutex_lock(&cap->lock);
+    cap->pixels[slot] = pixels;
+    cap->numbers[slot] = number;
+    cap->busy[slot] = true;
+    cap->queue[(cap->queue_head + cap->queue_len) % CAPTURE_SLOTS] = slot;
+    cap->queue_len++;
+    pthread_cond_broadcast(&cap->cond);
+    pthread_mutex_unlock(&cap->lock);
+}
+
+void capture_drain(struct capture* cap) {
+    pthread_mutex_lock(&cap->lock);
+    while (cap->queue_len)
+        pthread_cond_wait(&cap->cond, &cap->lock);
+    pthread_mutex_unlock(&cap->lock);
+}
@@ -0,0 +1,57 @@
+/*
+Frame capture writer: converts read back frames and writes them as PNG or
+raw RGBA files on a worker thread, so the render loop never waits on disk
+ */
+
+#ifndef _CAPTURE_H
+#define _CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* one slot per pixel-pack buffer of the readback ring */
+#define CAPTURE_SLOTS 4
+
+struct capture {
+    char prefix[256];           /* files are <prefix>-<frame>.png or .rgba */
+    bool raw;
+    bool bgra;                  /* pixels are BGRA instead of RGBA */
+    int width, height;
+    uint8_t* row;               /* one converted, top-down scanline */
+
+    /* slots handed to the worker; their pixels stay mapped until it is done */
+    const void* pixels[CAPTURE_SLOTS];
+    unsigned int numbers[CAPTURE_SLOTS];
+    bool busy[CAPTURE_SLOTS];
+    int queue[CAPTURE_SLOTS];
+    int queue_head, queue_len;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool quit;
+
+    /* statistics, written by the worker */
+    unsigned int written;
+    int64_t convert_ns, write_ns;
+};
+
+int capture_start(struct capture* cap, const char* prefix, bool raw, int width, int height, bool bgra);
+
+/* Write out everything queued, stop the worker and print statistics */
+void capture_stop(struct capture* cap);
+
+/* Whether the worker still reads the slot's pixels */
+bool capture_busy(struct capture* cap, int slot);
+
+/* Queue frame number from pixels (bottom-up rows as glReadPixels returns
+ * them, width * 4 bytes each). The memory must stay valid until
+ * capture_busy() turns false for the slot.
+ */
+void capture_submit(struct capture* cap, int slot, const void* pixels, unsigned int number);
+
+/* Block until the worker is done with every queued slot */
+void capture_drain(struct capture* cap);
+
+#endif /* _CAPTURE_H */
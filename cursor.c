@@ -0,0 +1,132 @@
+/*
+Hardware cursor
+
+The image is written once into a dumb buffer of the size the driver asks
+for (DRM_CAP_CURSOR_WIDTH/HEIGHT) and handed to the CRTC with
+drmModeSetCursor2(), which also tells virtual drivers the hotspot. After
+that a pointer move is a single drmModeMoveCursor(): no GL, no page flip,
+and the scene underneath is never redrawn. The legacy calls work on every
+driver, and on atomic drivers they go to the cursor plane anyway.
+ */
+
+#include "cursor.h"
+#include "kmsdrm.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+#define ARROW_SIZE 20
+
+/* Triangle (0, 0), (0, 17), (12, 12) */
+static bool in_arrow(int x, int y) {
+    return x >= 0 && x <= y && 12 * y + 5 * x <= 204;
+}
+
+/* White arrow with a black outline, hotspot at its tip */
+static void draw_arrow(uint32_t* row0, uint32_t pitch) {
+    for (int y = 0; y < ARROW_SIZE; y++) {
+        uint32_t* row = (uint32_t*) ((uint8_t*) row0 + y * pitch);
+
+        for (int x = 0; x < ARROW_SIZE; x++) {
+            if (!in_arrow(x, y))
+                continue;
+            bool edge = !in_arrow(x - 1, y) || !in_arrow(x + 1, y) || !in_arrow(x, y - 1) || !in_arrow(x, y + 1);
+
+            row[x] = edge ? 0xff000000 : 0xffffffff;
+        }
+    }
+}
+
+int cursor_init(struct cursor* cursor, int fd, uint32_t crtc_id, const uint32_t* image, int w, int h,
+    int hot_x, int hot_y) {
+    struct drm_mode_create_dumb create = { 0 };
+    struct drm_mode_map_dumb map = { 0 };
+    uint64_t cap_width = 64, cap_height = 64;
+    uint8_t* pixels;
+
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->fd = fd;
+    cursor->crtc_id = crtc_id;
+    drmGetCap(fd, DRM_CAP_CURSOR_WIDTH, &cap_width);
+    drmGetCap(fd, DRM_CAP_CURSOR_HEIGHT, &cap_height);
+    cursor->width = cap_width;
+    cursor->height = cap_height;
+    if (!image) {
+        w = h = ARROW_SIZE;
+        hot_x = hot_y = 0;
+    }
+    if ((uint32_t) w > cursor->width || (uint32_t) h > cursor->height) {
+        printf("cursor_init: %dx%d image, the cursor is %ux%u\n", w, h, cursor->width, cursor->height);
+        return -1;
+    }
+    cursor->hot_x = hot_x;
+    cursor->hot_y = hot_y;
+
+    /* drivers scan out the whole cursor buffer: it has to be exactly their size */
+    create.width = cursor->width;
+    create.height = cursor->height;
+    create.bpp = 32;
+    if (drmIoctl(fd, DRM_IOCTL_MODE_CREATE_DUMB, &create)) {
+        printf("cursor_init: DRM_IOCTL_MODE_CREATE_DUMB failed: %s\n", strerror(errno));
+        return -1;
+    }
+    cursor->handle = create.handle;
+    map.handle = create.handle;
+    if (drmIoctl(fd, DRM_IOCTL_MODE_MAP_DUMB, &map)) {
+        printf("cursor_init: DRM_IOCTL_MODE_MAP_DUMB failed: %s\n", strerror(errno));
+        goto fail;
+    }
+    pixels = mmap(NULL, create.size, PROT_WRITE, MAP_SHARED, fd, map.offset);
+    if (pixels == MAP_FAILED) {
+        printf("cursor_init: mmap failed: %s\n", strerror(errno));
+        goto fail;
+    }
+    memset(pixels, 0, create.size);
+    if (image) {
+        for (int y = 0; y < h; y++)
+            memcpy(pixels + y * create.pitch, image + y * w, w * 4);
+    } else {
+        draw_arrow((uint32_t*) pixels, create.pitch);
+    }
+    munmap(pixels, create.size);
+
+    if (drmModeSetCursor2(fd, crtc_id, cursor->handle, cursor->width, cursor->height, hot_x, hot_y) &&
+        drmModeSetCursor(fd, crtc_id, cursor->handle, cursor->width, cursor->height)) {
+        printf("cursor_init: crtc %u has no cursor: %s\n", crtc_id, strerror(errno));
+        goto fail;
+    }
+    cursor->visible = true;
+    printf("cursor_init: %ux%u cursor on crtc %u\n", cursor->width, cursor->height, crtc_id);
+    return 0;
+
+fail:
+    drmIoctl(fd, DRM_IOCTL_MODE_DESTROY_DUMB, &(struct drm_mode_destroy_dumb) { .handle = cursor->handle });
+    cursor->handle = 0;
+    return -1;
+}
+
+void cursor_destroy(struct cursor* cursor) {
+    if (!cursor->handle)
+        return;
+    if (cursor->visible)
+        drmModeSetCursor(cursor->fd, cursor->crtc_id, 0, 0, 0);
+    drmIoctl(cursor->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &(struct drm_mode_destroy_dumb) { .handle = cursor->handle });
+    if (cursor->moves)
+        printf("Cursor: %u moves, %.1f us each, no frames rendered for them\n", cursor->moves,
+            cursor->move_ns / 1e3 / cursor->moves);
+    memset(cursor, 0, sizeof(*cursor));
+}
+
+int cursor_move(struct cursor* cursor, int x, int y) {
+    int64_t start = get_time_ns();
+    int ret;
+
+    /* the position is the image's top left corner, whatever hotspot SetCursor2 was given */
+    ret = drmModeMoveCursor(cursor->fd, cursor->crtc_id, x - cursor->hot_x, y - cursor->hot_y);
+    cursor->move_ns += get_time_ns() - start;
+    cursor->moves++;
+    return ret;
+}
@@ -0,0 +1,39 @@
+/*
+Hardware cursor: the pointer image sits in a small dumb buffer on the CRTC's
+cursor plane and moves with one ioctl, without rendering a frame
+ */
+
+#ifndef _CURSOR_H
+#define _CURSOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct cursor {
+    int fd;
+    uint32_t crtc_id;
+    uint32_t handle;            /* ARGB8888 dumb buffer */
+    uint32_t width, height;     /* what the driver wants, usually 64x64 */
+    int hot_x, hot_y;
+    bool visible;
+    /* statistics */
+    unsigned int moves;
+    int64_t move_ns;
+};
+
+/* Put image (w x h ARGB8888 pixels, premultiplied, at most the driver's
+ * cursor size) on the CRTC with its hotspot at hot_x, hot_y. A NULL image
+ * shows a built-in arrow. Returns negative if the CRTC has no cursor.
+ */
+int cursor_init(struct cursor* cursor, int fd, uint32_t crtc_id, const uint32_t* image, int w, int h,
+    int hot_x, int hot_y);
+
+/* Hide the cursor and free its buffer */
+void cursor_destroy(struct cursor* cursor);
+
+/* Put the hotspot at x, y. Safe to call from any thread, and at any rate:
+ * the position latches at the next vblank.
+ */
+int cursor_move(struct cursor* cursor, int x, int y);
+
+#endif /* _CURSOR_H */
@@ -0,0 +1,2119 @@
+/*
+Demos and benchmarks run by the basic_opengles and basic_opengl apps on libkmsdrm, with
+OpenGL ES or OpenGL: the shaders are written for both
+ */
+
+#include "demo.h"
+
+/* Damage demo: only a small square changes color every frame */
+static void draw_damage_scene(const struct egl* egl, struct output* output) {
+    const int size = 64, x = 32, y = 32;
+    const int height = output->mode->vdisplay;
+    int box[4];
+
+    damage_begin(output);
+    damage_add(output, x, y, size, size);
+    if (damage_repaint_region(egl, output, box)) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(box[0], height - box[1] - box[3], box[2], box[3]);
+    }
+
+    glClearColor(0.0f, 0.5f, 1.0f, 1.0f); // Blue background
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x, height - y - size, size, size);
+    glClearColor((output->damage_frame % 60) / 60.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+// ============================================================================================
+// dma-buf import demo (-i): a GBM buffer exported as dma-buf and sampled through an
+// EGLImage, the same path taken by frames from a V4L2 decoder, a camera or another process
+// ============================================================================================
+
+struct import_demo {
+    struct dmabuf_importer importer;
+    struct gbm_bo* bo;
+    int bo_fd;                  /* dma-buf of bo, desc may hold a video frame instead */
+    struct dmabuf_desc desc;
+    GLuint program, vbo;
+};
+
+static struct import_demo import_demo;
+
+static const char* import_vs_src =
+"attribute vec2 a_Position;\n"
+"attribute vec2 a_TexCoord;\n"
+"varying vec2 v_TexCoord;\n"
+"void main() {\n"
+"    gl_Position = vec4(a_Position, 0.0, 1.0);\n"
+"    v_TexCoord = a_TexCoord;\n"
+"}";
+
+static const char* import_fs_src =
+"#extension GL_OES_EGL_image_external : require\n"
+"precision mediump float;\n"
+"varying vec2 v_TexCoord;\n"
+"uniform samplerExternalOES u_Texture;\n"
+"void main() {\n"
+"    gl_FragColor = texture2D(u_Texture, v_TexCoord);\n"
+"}";
+
+/* attribute locations kept clear of the triangle program's, so both can share
+ * the default vertex array state
+ */
+#define IMPORT_POSITION 1
+#define IMPORT_TEXCOORD 2
+
+static int init_import_demo(struct import_demo* demo, const struct egl* egl) {
+    static const GLfloat quad[] = {
+        /* x, y, u, v: top right corner of the screen */
+        0.5f, 0.5f, 0.0f, 1.0f,
+        0.9f, 0.5f, 1.0f, 1.0f,
+        0.5f, 0.9f, 0.0f, 0.0f,
+        0.9f, 0.9f, 1.0f, 0.0f,
+    };
+    int program;
+
+    if (egl->api != GL_API_GLES) {
+        /* desktop GL has no external textures */
+        printf("init_import_demo: dma-buf import needs OpenGL ES\n");
+        return -1;
+    }
+    if (init_dmabuf_importer(&demo->importer, egl->display, &egl->display_exts, &egl->gl_exts,
+        egl->modifiers_supported))
+        return -1;
+
+    program = create_program(import_vs_src, import_fs_src);
+    if (program < 0)
+        return -1;
+    demo->program = program;
+    glBindAttribLocation(demo->program, IMPORT_POSITION, "a_Position");
+    glBindAttribLocation(demo->program, IMPORT_TEXCOORD, "a_TexCoord");
+    if (link_program(demo->program))
+        return -1;
+
+    glGenBuffers(1, &demo->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, demo->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    return 0;
+}
+
+/* Stand-in for a decoder frame: a linear checkerboard written by the CPU */
+static int create_import_frame(struct import_demo* demo, const struct gbm* gbm) {
+    const int size = 256;
+    uint32_t stride;
+    void* map_data = NULL;
+    uint32_t* pixels;
+    int fd;
+
+    demo->bo = gbm_bo_create(gbm->dev, size, size, DRM_FORMAT_ARGB8888, GBM_BO_USE_LINEAR | GBM_BO_USE_RENDERING);
+    if (!demo->bo) {
+        printf("create_import_frame: failed to create bo\n");
+        return -1;
+    }
+    pixels = gbm_bo_map(demo->bo, 0, 0, size, size, GBM_BO_TRANSFER_WRITE, &stride, &map_data);
+    if (!pixels) {
+        printf("create_import_frame: failed to map bo\n");
+        return -1;
+    }
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++)
+            pixels[y * (stride / 4) + x] = ((x ^ y) & 32) ? 0xffffffff : 0xffff8000;
+    }
+    gbm_bo_unmap(demo->bo, map_data);
+
+    fd = gbm_bo_get_fd(demo->bo);
+    if (fd < 0) {
+        printf("create_import_frame: failed to export bo\n");
+        return -1;
+    }
+    demo->bo_fd = fd;
+    demo->desc.width = size;
+    demo->desc.height = size;
+    demo->desc.format = DRM_FORMAT_ARGB8888;
+    demo->desc.modifier = gbm_bo_get_modifier(demo->bo);
+    demo->desc.num_planes = gbm_bo_get_plane_count(demo->bo);
+    for (int i = 0; i < demo->desc.num_planes && i < DMABUF_MAX_PLANES; i++) {
+        demo->desc.fds[i] = fd;
+        demo->desc.offsets[i] = gbm_bo_get_offset(demo->bo, i);
+        demo->desc.pitches[i] = gbm_bo_get_stride_for_plane(demo->bo, i);
+    }
+    return 0;
+}
+
+static void draw_import_demo(struct import_demo* demo) {
+    GLint program, vbo;
+    /* a producer hands us the same few buffers over and over: after the first
+     * frame this is a cache hit and costs no EGLImage creation
+     */
+    GLuint texture = dmabuf_import(&demo->importer, &demo->desc);
+
+    if (!texture)
+        return;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &vbo);
+
+    glUseProgram(demo->program);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture);
+    glBindBuffer(GL_ARRAY_BUFFER, demo->vbo);
+    glVertexAttribPointer(IMPORT_POSITION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) 0);
+    glVertexAttribPointer(IMPORT_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) (2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(IMPORT_POSITION);
+    glEnableVertexAttribArray(IMPORT_TEXCOORD);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(IMPORT_POSITION);
+    glDisableVertexAttribArray(IMPORT_TEXCOORD);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glUseProgram(program);
+}
+
+static void destroy_import_demo(struct import_demo* demo) {
+    destroy_dmabuf_importer(&demo->importer);
+    /* only the checkerboard frame is ours, video frames belong to video_demo */
+    if (demo->bo_fd > 0)
+        close(demo->bo_fd);
+    if (demo->bo)
+        gbm_bo_destroy(demo->bo);
+    if (demo->program)
+        glDeleteProgram(demo->program);
+    if (demo->vbo)
+        glDeleteBuffers(1, &demo->vbo);
+}
+
+// ============================================================================================
+// Video scanout demo (-V): NV12 frames from a "decoder" go straight to a KMS overlay plane,
+// the GPU only draws the UI below them. Without a suitable plane the frames take the
+// dma-buf import path and are composed by GL.
+// ============================================================================================
+
+#define VIDEO_FRAMES 2
+#define VIDEO_WIDTH 640
+#define VIDEO_HEIGHT 360
+
+struct video_demo {
+    bool active;
+    bool scanout;
+    int producer_fd;            /* own DRM file, like a decoder sharing buffers by PRIME */
+    uint32_t handles[VIDEO_FRAMES];
+    struct dmabuf_desc frames[VIDEO_FRAMES];
+    struct video_plane plane;
+    int shown;
+};
+
+static struct video_demo video_demo;
+
+/* An NV12 dumb buffer: full resolution Y plane followed by the interleaved,
+ * half resolution CbCr plane
+ */
+static int create_nv12_frame(int fd, uint8_t luma, uint8_t cb, uint8_t cr, uint32_t* handle, struct dmabuf_desc* desc) {
+    struct drm_mode_create_dumb create = { .width = VIDEO_WIDTH, .height = VIDEO_HEIGHT * 3 / 2, .bpp = 8 };
+    struct drm_mode_map_dumb map = { 0 };
+    uint8_t* pixels;
+    int prime_fd;
+
+    if (drmIoctl(fd, DRM_IOCTL_MODE_CREATE_DUMB, &create)) {
+        printf("create_nv12_frame: DRM_IOCTL_MODE_CREATE_DUMB failed: %s\n", strerror(errno));
+        return -1;
+    }
+    *handle = create.handle;
+    map.handle = create.handle;
+    if (drmIoctl(fd, DRM_IOCTL_MODE_MAP_DUMB, &map))
+        return -1;
+    pixels = mmap(NULL, create.size, PROT_WRITE, MAP_SHARED, fd, map.offset);
+    if (pixels == MAP_FAILED)
+        return -1;
+    for (int y = 0; y < VIDEO_HEIGHT; y++)
+        memset(pixels + y * create.pitch, luma + y * 64 / VIDEO_HEIGHT, VIDEO_WIDTH);
+    for (int y = 0; y < VIDEO_HEIGHT / 2; y++) {
+        uint8_t* row = pixels + (VIDEO_HEIGHT + y) * create.pitch;
+
+        for (int x = 0; x < VIDEO_WIDTH; x += 2) {
+            row[x] = cb;
+            row[x + 1] = cr;
+        }
+    }
+    munmap(pixels, create.size);
+
+    if (drmPrimeHandleToFD(fd, create.handle, DRM_CLOEXEC, &prime_fd)) {
+        printf("create_nv12_frame: failed to export buffer: %s\n", strerror(errno));
+        return -1;
+    }
+    desc->width = VIDEO_WIDTH;
+    desc->height = VIDEO_HEIGHT;
+    desc->format = DRM_FORMAT_NV12;
+    desc->modifier = DRM_FORMAT_MOD_LINEAR;
+    desc->num_planes = 2;
+    desc->fds[0] = desc->fds[1] = prime_fd;
+    desc->offsets[0] = 0;
+    desc->offsets[1] = create.pitch * VIDEO_HEIGHT;
+    desc->pitches[0] = desc->pitches[1] = create.pitch;
+    return 0;
+}
+
+static int init_video_demo(struct video_demo* demo, const struct drm* drm) {
+    demo->shown = -1;
+    demo->producer_fd = open(drm->device_path, O_RDWR | O_CLOEXEC);
+    if (demo->producer_fd < 0) {
+        printf("init_video_demo: failed to open %s\n", drm->device_path);
+        return -1;
+    }
+    /* two frames told apart by brightness and tint */
+    if (create_nv12_frame(demo->producer_fd, 64, 96, 160, &demo->handles[0], &demo->frames[0]) ||
+        create_nv12_frame(demo->producer_fd, 128, 160, 96, &demo->handles[1], &demo->frames[1]))
+        return -1;
+
+    /* the primary plane stays with GL, which draws the rest of the screen */
+    demo->scanout = !init_video_plane(&demo->plane, drm->fd, drm->crtc_id, drm->crtc_index,
+        DRM_FORMAT_NV12, DRM_FORMAT_MOD_LINEAR, false);
+    if (!demo->scanout)
+        printf("init_video_demo: no plane for NV12, composing video with GL\n");
+    demo->active = true;
+    return 0;
+}
+
+static void update_video_demo(struct video_demo* demo, const struct egl* egl, const struct output* output) {
+    /* a new video frame every 30 display frames */
+    int n = (output->frames / 30) % VIDEO_FRAMES;
+
+    if (demo->scanout) {
+        int x = output->mode->hdisplay > VIDEO_WIDTH ? (output->mode->hdisplay - VIDEO_WIDTH) / 2 : 0;
+        int y = output->mode->vdisplay > VIDEO_HEIGHT ? (output->mode->vdisplay - VIDEO_HEIGHT) / 2 : 0;
+
+        if (n == demo->shown)
+            return;
+        if (!video_plane_show(&demo->plane, &demo->frames[n], x, y, VIDEO_WIDTH, VIDEO_HEIGHT)) {
+            demo->shown = n;
+            return;
+        }
+        printf("update_video_demo: scanout failed, composing video with GL\n");
+        demo->scanout = false;
+    }
+
+    if (!import_demo.program && init_import_demo(&import_demo, egl)) {
+        printf("update_video_demo: dma-buf import unavailable, video disabled\n");
+        demo->active = false;
+        return;
+    }
+    import_demo.desc = demo->frames[n];
+}
+
+static void destroy_video_demo(struct video_demo* demo) {
+    if (demo->scanout)
+        destroy_video_plane(&demo->plane);
+    for (int i = 0; i < VIDEO_FRAMES; i++) {
+        if (demo->frames[i].num_planes)
+            close(demo->frames[i].fds[0]);
+        if (demo->handles[i])
+            drmIoctl(demo->producer_fd, DRM_IOCTL_MODE_DESTROY_DUMB,
+                &(struct drm_mode_destroy_dumb) { .handle = demo->handles[i] });
+    }
+    if (demo->producer_fd > 0)
+        close(demo->producer_fd);
+}
+
+/* Internal format for RGBA8 pixels: OpenGL ES 2 has no sized formats, only GL_RGBA */
+static GLint rgba8_internal_format(const struct egl* egl, bool srgb) {
+    if (egl->api == GL_API_GLES && egl->gl_major < 3)
+        return GL_RGBA;
+    return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+}
+
+// ============================================================================================
+// Background uploads: a loader thread owns a second context sharing objects with the render
+// context, current without a surface (EGL_KHR_surfaceless_context). Every job ends with a
+// fence, and the render thread only touches the new texture or buffer once it has signaled,
+// so uploads never block a frame and never show half-written data.
+// ============================================================================================
+
+enum upload_state {
+    UPLOAD_IDLE,
+    UPLOAD_QUEUED,
+    UPLOAD_DONE,
+    UPLOAD_FAILED,
+};
+
+struct upload_job {
+    /* runs on the loader thread, returns the texture or buffer, 0 on failure */
+    GLuint (*load)(const struct egl* egl, struct upload_job* job);
+    const char* path;
+    const void* data;
+    int width, height;
+    size_t size;                /* bytes uploaded */
+    bool alpha;
+    enum upload_state state;    /* guarded by the uploader lock */
+    bool pending;               /* render thread: submitted, upload_ready() has not reported it */
+    GLuint name;
+    GLsync fence;
+    struct upload_job* next;
+};
+
+struct uploader {
+    const struct egl* egl;
+    bool running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct upload_job* head, * tail;
+    bool quit;
+    /* statistics, written by the loader thread */
+    unsigned int jobs;
+    uint64_t bytes;
+    int64_t busy_ns;
+};
+
+static struct uploader uploader;
+
+/* Fence after the job's commands: signals once the GPU has the data */
+static void fence_insert(const struct egl* egl, struct upload_job* job) {
+    if (!egl->sync) {
+        /* no fences (OpenGL ES 2, GL without GL_ARB_sync): the data is in place once glFinish() returns */
+        glFinish();
+        return;
+    }
+    job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    /* a fence only signals once it has been submitted */
+    glFlush();
+}
+
+/* Poll the job's fence without blocking, deleting it once signaled */
+static bool fence_signaled(const struct egl* egl, struct upload_job* job) {
+    (void) egl;
+    if (!job->fence)
+        return true;
+    if (glClientWaitSync(job->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+    glDeleteSync(job->fence);
+    job->fence = NULL;
+    return true;
+}
+/* RGBA8 pixels in data, width x height */
+static GLuint upload_rgba_texture(const struct egl* egl, struct upload_job* job) {
+    GLuint texture;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, rgba8_internal_format(egl, false), job->width, job->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, job->data);
+    job->size = (size_t) job->width * job->height * 4;
+    return texture;
+}
+
+/* size bytes of vertex data */
+static GLuint upload_buffer(const struct egl* egl, struct upload_job* job) {
+    GLuint buffer;
+
+    (void) egl;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, job->size, job->data, GL_STATIC_DRAW);
+    return buffer;
+}
+
+static void* upload_thread(void* data) {
+    struct uploader* up = data;
+    const struct egl* egl = up->egl;
+    bool current = eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl->loader_context);
+
+    if (!current)
+        printf("upload_thread: eglMakeCurrent failed: 0x%x\n", eglGetError());
+
+    pthread_mutex_lock(&up->lock);
+    while (true) {
+        struct upload_job* job;
+        int64_t start;
+
+        while (!up->head && !up->quit)
+            pthread_cond_wait(&up->cond, &up->lock);
+        job = up->head;
+        if (!job)
+            break;
+        up->head = job->next;
+        if (!up->head)
+            up->tail = NULL;
+        pthread_mutex_unlock(&up->lock);
+
+        start = get_time_ns();
+        if (current) {
+            job->name = job->load(egl, job);
+            fence_insert(egl, job);
+        }
+        up->busy_ns += get_time_ns() - start;
+
+        pthread_mutex_lock(&up->lock);
+        job->state = job->name ? UPLOAD_DONE : UPLOAD_FAILED;
+        if (job->name) {
+            up->jobs++;
+            up->bytes += job->size;
+        }
+    }
+    pthread_mutex_unlock(&up->lock);
+    eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return NULL;
+}
+
+static int init_uploader(struct uploader* up, const struct egl* egl) {
+    if (egl->loader_context == EGL_NO_CONTEXT)
+        return -1;
+    up->egl = egl;
+    pthread_mutex_init(&up->lock, NULL);
+    pthread_cond_init(&up->cond, NULL);
+    if (pthread_create(&up->thread, NULL, upload_thread, up)) {
+        printf("init_uploader: failed to create loader thread\n");
+        return -1;
+    }
+    up->running = true;
+    return 0;
+}
+
+static void upload_submit(struct uploader* up, struct upload_job* job) {
+    job->state = UPLOAD_QUEUED;
+    job->pending = true;
+    job->name = 0;
+    job->fence = NULL;
+    job->next = NULL;
+    pthread_mutex_lock(&up->lock);
+    if (up->tail)
+        up->tail->next = job;
+    else
+        up->head = job;
+    up->tail = job;
+    pthread_cond_signal(&up->cond);
+    pthread_mutex_unlock(&up->lock);
+}
+
+/* 1 once job->name may be used by the render thread, 0 while the upload is
+ * in flight, negative if it failed
+ */
+static int upload_ready(struct uploader* up, struct upload_job* job) {
+    enum upload_state state;
+
+    pthread_mutex_lock(&up->lock);
+    state = job->state;
+    pthread_mutex_unlock(&up->lock);
+    if (state == UPLOAD_FAILED) {
+        job->pending = false;
+        return -1;
+    }
+    if (state != UPLOAD_DONE || !fence_signaled(up->egl, job))
+        return 0;
+    job->pending = false;
+    return 1;
+}
+
+/* Wait for a submitted job and return its name, 0 if it failed or was not
+ * pending. Before destroy_uploader(), which stops answering.
+ */
+static GLuint upload_wait(struct uploader* up, struct upload_job* job) {
+    const struct timespec pause = { 0, 1000000 };
+    int ready;
+
+    if (!job->pending)
+        return 0;
+    while (!(ready = upload_ready(up, job)))
+        nanosleep(&pause, NULL);
+    return ready > 0 ? job->name : 0;
+}
+
+/* Finish the queued jobs and stop the loader thread */
+static void destroy_uploader(struct uploader* up) {
+    if (!up->running)
+        return;
+    pthread_mutex_lock(&up->lock);
+    up->quit = true;
+    pthread_cond_signal(&up->cond);
+    pthread_mutex_unlock(&up->lock);
+    pthread_join(up->thread, NULL);
+    pthread_cond_destroy(&up->cond);
+    pthread_mutex_destroy(&up->lock);
+    up->running = false;
+    if (up->jobs)
+        printf("Uploader: %u jobs, %.1f MB, %.3f ms/job on the loader thread\n", up->jobs,
+            up->bytes / 1e6, up->busy_ns / 1e6 / up->jobs);
+}
+
+// ============================================================================================
+// Upload stress benchmark (--upload-stress=SIZE): a SIZExSIZE RGBA texture is uploaded every
+// frame, through the loader thread or, with --upload-sync, on the render thread, to show
+// what uploads cost the frame time
+// ============================================================================================
+
+#define UPLOAD_STRESS_JOBS 4
+
+struct upload_stress {
+    int size;
+    bool sync;
+    uint8_t* pixels;
+    struct upload_job jobs[UPLOAD_STRESS_JOBS];
+    unsigned int uploads, skipped;
+    int64_t last_frame, max_interval, total_interval;
+    unsigned int intervals;
+    int64_t render_ns;          /* spent on uploads by the render thread */
+};
+
+static struct upload_stress upload_stress;
+
+static int init_upload_stress(struct upload_stress* st, const struct uploader* up) {
+    if (!up->running)
+        st->sync = true;
+    st->pixels = malloc((size_t) st->size * st->size * 4);
+    if (!st->pixels)
+        return -1;
+    for (size_t i = 0; i < (size_t) st->size * st->size * 4; i++)
+        st->pixels[i] = i * 7;
+    for (int i = 0; i < UPLOAD_STRESS_JOBS; i++) {
+        st->jobs[i].load = upload_rgba_texture;
+        st->jobs[i].data = st->pixels;
+        st->jobs[i].width = st->size;
+        st->jobs[i].height = st->size;
+    }
+    return 0;
+}
+
+static void upload_stress_frame(struct upload_stress* st, const struct egl* egl, struct uploader* up) {
+    int64_t start = get_time_ns();
+
+    if (st->last_frame) {
+        int64_t interval = start - st->last_frame;
+
+        st->total_interval += interval;
+        st->intervals++;
+        if (interval > st->max_interval)
+            st->max_interval = interval;
+    }
+    st->last_frame = start;
+
+    if (st->sync) {
+        GLuint texture = upload_rgba_texture(egl, &st->jobs[0]);
+
+        glDeleteTextures(1, &texture);
+        st->uploads++;
+    } else {
+        struct upload_job* idle = NULL;
+
+        for (int i = 0; i < UPLOAD_STRESS_JOBS; i++) {
+            struct upload_job* job = &st->jobs[i];
+
+            if (job->pending && upload_ready(up, job)) {
+                if (job->name)
+                    glDeleteTextures(1, &job->name);
+                st->uploads++;
+            }
+            if (!job->pending && !idle)
+                idle = job;
+        }
+        /* the loader is behind: skip rather than queue without bound */
+        if (idle)
+            upload_submit(up, idle);
+        else
+            st->skipped++;
+    }
+    st->render_ns += get_time_ns() - start;
+}
+
+static void finish_upload_stress(struct upload_stress* st) {
+    if (!st->pixels)
+        return;
+    /* the loader thread still runs: wait for the jobs in flight and their fences */
+    for (int i = 0; i < UPLOAD_STRESS_JOBS; i++) {
+        GLuint texture = upload_wait(&uploader, &st->jobs[i]);
+
+        if (texture)
+            glDeleteTextures(1, &texture);
+    }
+    free(st->pixels);
+    printf("Upload stress: %u %dx%d uploads (%s), %u skipped, frame interval avg %.2f ms max %.2f ms, %.3f ms/frame on the render thread\n",
+        st->uploads, st->size, st->size, st->sync ? "render thread" : "loader thread", st->skipped,
+        st->intervals ? st->total_interval / 1e6 / st->intervals : 0.0, st->max_interval / 1e6,
+        st->render_ns / 1e6 / (st->intervals + 1));
+}
+
+// ============================================================================================
+// Compressed texture demo (-t): a KTX/KTX2 file uploaded mip level by mip level straight
+// from its mapping. ETC2 stays compressed in video memory where the driver supports it
+// (GLES 3.0 core, GL_ARB_ES3_compatibility), ASTC when GL_KHR_texture_compression_astc_ldr
+// is present; otherwise ETC is decoded on the CPU and uploaded as RGBA8. With a loader
+// context the upload runs on the loader thread and the quad appears once it is done.
+// ============================================================================================
+
+struct texture_demo {
+    GLuint texture, program, vbo;
+    bool blend;
+    struct upload_job job;
+};
+
+static struct texture_demo texture_demo;
+
+static const char* texture_vs_src =
+"attribute vec2 a_Position;\n"
+"attribute vec2 a_TexCoord;\n"
+"varying vec2 v_TexCoord;\n"
+"void main() {\n"
+"    gl_Position = vec4(a_Position, 0.0, 1.0);\n"
+"    v_TexCoord = a_TexCoord;\n"
+"}";
+
+static const char* texture_fs_src =
+"#ifdef GL_ES\n"
+"precision mediump float;\n"
+"#endif\n"
+"varying vec2 v_TexCoord;\n"
+"uniform sampler2D u_Texture;\n"
+"void main() {\n"
+"    gl_FragColor = texture2D(u_Texture, v_TexCoord);\n"
+"}";
+
+#define TEXTURE_POSITION 1
+#define TEXTURE_TEXCOORD 2
+
+/* Returns the texture, 0 on failure */
+static GLuint load_ktx_texture(const struct egl* egl, const char* path, bool* alpha) {
+    int64_t start = get_time_ns();
+    size_t uploaded = 0;
+    uint8_t* rgba = NULL;
+    struct ktx ktx;
+    GLuint texture;
+    GLenum internal_format, error;
+    bool decode, mipmaps;
+
+    if (ktx_open(&ktx, path))
+        return 0;
+    if (ktx_is_astc(ktx.internal_format) && !egl->astc) {
+        printf("load_ktx_texture: %s is ASTC, but GL_KHR_texture_compression_astc_ldr is missing\n", path);
+        ktx_close(&ktx);
+        return 0;
+    }
+    decode = ktx_is_etc(ktx.internal_format) && !egl->etc2;
+    /* ETC1 is a subset of ETC2 */
+    internal_format = ktx.internal_format == GL_ETC1_RGB8_OES ? GL_COMPRESSED_RGB8_ETC2 : ktx.internal_format;
+    *alpha = ktx.internal_format != GL_ETC1_RGB8_OES && ktx.internal_format != GL_COMPRESSED_RGB8_ETC2 &&
+        ktx.internal_format != GL_COMPRESSED_SRGB8_ETC2;
+
+    while (glGetError() != GL_NO_ERROR)
+        ;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (int i = 0; i < ktx.num_levels; i++) {
+        const struct ktx_level* level = &ktx.levels[i];
+
+        if (decode) {
+            if (!rgba)
+                rgba = malloc((size_t) ktx.width * ktx.height * 4);
+            if (!rgba)
+                break;
+            ktx_decode_etc(&ktx, i, rgba);
+            /* sRGB decoding is lost on OpenGL ES 2 */
+            glTexImage2D(GL_TEXTURE_2D, i, rgba8_internal_format(egl, ktx_is_srgb(ktx.internal_format)),
+                level->width, level->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+            uploaded += (size_t) level->width * level->height * 4;
+        } else if (ktx.format) {
+            glTexImage2D(GL_TEXTURE_2D, i, internal_format, level->width, level->height, 0, ktx.format, ktx.type, level->data);
+            uploaded += level->size;
+        } else {
+            /* the driver reads the level straight out of the page cache */
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format, level->width, level->height, 0, level->size, level->data);
+            uploaded += level->size;
+        }
+        ktx_release_level(&ktx, i);
+    }
+    free(rgba);
+
+    /* compressed formats cannot be rendered to, so their chain must come from the file */
+    mipmaps = ktx.num_levels > 1;
+    if (ktx.generate_mipmaps && (decode || ktx.format)) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        mipmaps = true;
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ktx.num_levels - 1);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    error = glGetError();
+    if (error != GL_NO_ERROR) {
+        printf("load_ktx_texture: upload of %s (format 0x%x) failed: 0x%x\n", path, ktx.internal_format, error);
+        glDeleteTextures(1, &texture);
+        ktx_close(&ktx);
+        return 0;
+    }
+    printf("Texture %s: KTX%d %dx%d format 0x%x, %d level(s), %zu bytes uploaded in %.3f ms%s\n", path,
+        ktx.version, ktx.width, ktx.height, ktx.internal_format, ktx.num_levels, uploaded,
+        (get_time_ns() - start) / 1e6, decode ? " (decoded on the CPU)" : "");
+    ktx_close(&ktx);
+    return texture;
+}
+
+static GLuint upload_ktx(const struct egl* egl, struct upload_job* job) {
+    return load_ktx_texture(egl, job->path, &job->alpha);
+}
+
+static int init_texture_demo(struct texture_demo* demo, const struct egl* egl, const char* path) {
+    static const GLfloat quad[] = {
+        /* x, y, u, v: top left corner of the screen */
+        -0.9f, 0.5f, 0.0f, 1.0f,
+        -0.5f, 0.5f, 1.0f, 1.0f,
+        -0.9f, 0.9f, 0.0f, 0.0f,
+        -0.5f, 0.9f, 1.0f, 0.0f,
+    };
+    int program;
+
+    if (uploader.running) {
+        demo->job.load = upload_ktx;
+        demo->job.path = path;
+        upload_submit(&uploader, &demo->job);
+    } else {
+        demo->texture = load_ktx_texture(egl, path, &demo->blend);
+        if (!demo->texture)
+            return -1;
+    }
+
+    program = create_program(texture_vs_src, texture_fs_src);
+    if (program < 0)
+        return -1;
+    demo->program = program;
+    glBindAttribLocation(demo->program, TEXTURE_POSITION, "a_Position");
+    glBindAttribLocation(demo->program, TEXTURE_TEXCOORD, "a_TexCoord");
+    if (link_program(demo->program))
+        return -1;
+
+    glGenBuffers(1, &demo->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, demo->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    return 0;
+}
+
+static void draw_texture_demo(struct texture_demo* demo) {
+    GLint program, vbo;
+
+    if (!demo->texture) {
+        /* still on the loader thread, or its GPU work has not landed yet */
+        if (upload_ready(&uploader, &demo->job) <= 0)
+            return;
+        demo->texture = demo->job.name;
+        demo->blend = demo->job.alpha;
+    }
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &vbo);
+
+    glUseProgram(demo->program);
+    glBindTexture(GL_TEXTURE_2D, demo->texture);
+    glBindBuffer(GL_ARRAY_BUFFER, demo->vbo);
+    glVertexAttribPointer(TEXTURE_POSITION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) 0);
+    glVertexAttribPointer(TEXTURE_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) (2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(TEXTURE_POSITION);
+    glEnableVertexAttribArray(TEXTURE_TEXCOORD);
+    if (demo->blend) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisable(GL_BLEND);
+    glDisableVertexAttribArray(TEXTURE_POSITION);
+    glDisableVertexAttribArray(TEXTURE_TEXCOORD);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glUseProgram(program);
+}
+
+static void destroy_texture_demo(struct texture_demo* demo) {
+    if (!demo->texture)
+        demo->texture = upload_wait(&uploader, &demo->job);
+    if (demo->texture)
+        glDeleteTextures(1, &demo->texture);
+    if (demo->program)
+        glDeleteProgram(demo->program);
+    if (demo->vbo)
+        glDeleteBuffers(1, &demo->vbo);
+}
+
+// ============================================================================================
+// Atlas demo (--atlas=N): N sprites drawn every frame from atlas pages, one texture bind and
+// one draw per page instead of one per sprite. The visible set slowly scrolls through a larger
+// one, so new images stream in through a staging buffer and full pages get recycled.
+// ============================================================================================
+
+#define ATLAS_PAGE_SIZE 512
+#define ATLAS_DEMO_PAGES 2
+#define ATLAS_STAGING_SIZE (1 << 20)
+#define SPRITE_CELL 40
+
+struct atlas_demo {
+    struct atlas atlas;
+    GLuint textures[ATLAS_DEMO_PAGES];
+    GLuint staging;             /* GL_PIXEL_UNPACK_BUFFER, filled front to back then orphaned */
+    size_t staging_offset;
+    GLuint program, vbo;
+    int sprites, columns;
+    int width, height;
+    struct atlas_rect* rects;
+    GLfloat* vertices;
+    unsigned int frames, draws, uploads;
+    uint64_t uploaded_bytes;
+};
+
+static struct atlas_demo atlas_demo;
+
+static int init_atlas_demo(struct atlas_demo* demo, const struct egl* egl, int width, int height) {
+    int program;
+
+    if (egl->gl_major < 3) {
+        /* pixel unpack buffers and glMapBufferRange() */
+        printf("init_atlas_demo: needs OpenGL ES 3.0 or OpenGL 3.0\n");
+        return -1;
+    }
+    atlas_init(&demo->atlas, ATLAS_PAGE_SIZE, ATLAS_DEMO_PAGES, 1);
+    demo->width = width;
+    demo->height = height;
+    demo->columns = width / SPRITE_CELL;
+    if (demo->sprites > demo->columns * (height / SPRITE_CELL))
+        demo->sprites = demo->columns * (height / SPRITE_CELL);
+    demo->rects = calloc(demo->sprites, sizeof(*demo->rects));
+    demo->vertices = malloc(demo->sprites * 6 * 4 * sizeof(GLfloat));
+    if (!demo->rects || !demo->vertices)
+        return -1;
+
+    glGenTextures(ATLAS_DEMO_PAGES, demo->textures);
+    for (int i = 0; i < ATLAS_DEMO_PAGES; i++) {
+        glBindTexture(GL_TEXTURE_2D, demo->textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glGenBuffers(1, &demo->staging);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, demo->staging);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, ATLAS_STAGING_SIZE, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    program = create_program(texture_vs_src, texture_fs_src);
+    if (program < 0)
+        return -1;
+    demo->program = program;
+    glBindAttribLocation(demo->program, TEXTURE_POSITION, "a_Position");
+    glBindAttribLocation(demo->program, TEXTURE_TEXCOORD, "a_TexCoord");
+    if (link_program(demo->program))
+        return -1;
+    glGenBuffers(1, &demo->vbo);
+    return 0;
+}
+
+static void sprite_size(unsigned int id, int* w, int* h) {
+    *w = 8 + id * 13 % 29;
+    *h = 8 + id * 7 % 27;
+}
+
+/* Write sprite id into its atlas rectangle through the staging buffer */
+static void stream_sprite(struct atlas_demo* demo, unsigned int id, const struct atlas_rect* rect) {
+    const size_t size = (size_t) rect->w * rect->h * 4;
+    const uint32_t color = 0xff000000 | (id * 0x9e3779b1u >> 8);
+    uint32_t* pixels;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, demo->staging);
+    if (demo->staging_offset + size > ATLAS_STAGING_SIZE) {
+        /* orphan: the driver hands out fresh storage while the GPU still reads the old one */
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, ATLAS_STAGING_SIZE, NULL, GL_STREAM_DRAW);
+        demo->staging_offset = 0;
+    }
+    /* never rewrites a range of this storage, so no need to sync with the GPU */
+    pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, demo->staging_offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (pixels) {
+        for (int y = 0; y < rect->h; y++) {
+            for (int x = 0; x < rect->w; x++) {
+                bool border = !x || !y || x == rect->w - 1 || y == rect->h - 1;
+
+                pixels[y * rect->w + x] = border ? 0xffffffff : color;
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindTexture(GL_TEXTURE_2D, demo->textures[rect->page]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect->x, rect->y, rect->w, rect->h, GL_RGBA, GL_UNSIGNED_BYTE,
+            (void*) demo->staging_offset);
+        demo->uploads++;
+        demo->uploaded_bytes += size;
+    }
+    /* 64 byte aligned, a cache line for every upload */
+    demo->staging_offset += (size + 63) & ~(size_t) 63;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+static void draw_atlas_demo(struct atlas_demo* demo) {
+    /* the visible set moves on by one sprite every fourth frame */
+    const unsigned int first = demo->frames++ / 4;
+    int counts[ATLAS_DEMO_PAGES] = { 0 }, starts[ATLAS_DEMO_PAGES];
+    GLint program, vbo;
+    int n = 0;
+
+    atlas_next_frame(&demo->atlas);
+    for (int i = 0; i < demo->sprites; i++) {
+        struct atlas_rect* rect = &demo->rects[i];
+        unsigned int id = first + i;
+        int w, h;
+
+        if (!atlas_lookup(&demo->atlas, id, rect)) {
+            sprite_size(id, &w, &h);
+            if (atlas_insert(&demo->atlas, id, w, h, rect) < 0) {
+                rect->page = -1;
+                continue;
+            }
+            stream_sprite(demo, id, rect);
+        }
+        counts[rect->page]++;
+    }
+
+    /* one batch per page */
+    for (int p = 0; p < ATLAS_DEMO_PAGES; p++) {
+        starts[p] = n;
+        n += counts[p];
+        counts[p] = 0;
+    }
+    for (int i = 0; i < demo->sprites; i++) {
+        const struct atlas_rect* r = &demo->rects[i];
+        float x0, y0, x1, y1;
+        GLfloat* v;
+
+        if (r->page < 0)
+            continue;
+        x0 = -1.0f + 2.0f * (i % demo->columns) * SPRITE_CELL / demo->width;
+        y1 = 1.0f - 2.0f * (i / demo->columns) * SPRITE_CELL / demo->height;
+        x1 = x0 + 2.0f * r->w / demo->width;
+        y0 = y1 - 2.0f * r->h / demo->height;
+        v = &demo->vertices[(starts[r->page] + counts[r->page]++) * 6 * 4];
+        const GLfloat quad[6 * 4] = {
+            x0, y1, r->u0, r->v0, x0, y0, r->u0, r->v1, x1, y1, r->u1, r->v0,
+            x1, y1, r->u1, r->v0, x0, y0, r->u0, r->v1, x1, y0, r->u1, r->v1,
+        };
+        memcpy(v, quad, sizeof(quad));
+    }
+
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &vbo);
+    glUseProgram(demo->program);
+    glBindBuffer(GL_ARRAY_BUFFER, demo->vbo);
+    glBufferData(GL_ARRAY_BUFFER, n * 6 * 4 * sizeof(GLfloat), demo->vertices, GL_STREAM_DRAW);
+    glVertexAttribPointer(TEXTURE_POSITION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) 0);
+    glVertexAttribPointer(TEXTURE_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) (2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(TEXTURE_POSITION);
+    glEnableVertexAttribArray(TEXTURE_TEXCOORD);
+    for (int p = 0; p < ATLAS_DEMO_PAGES; p++) {
+        if (!counts[p])
+            continue;
+        glBindTexture(GL_TEXTURE_2D, demo->textures[p]);
+        glDrawArrays(GL_TRIANGLES, starts[p] * 6, counts[p] * 6);
+        demo->draws++;
+    }
+    glDisableVertexAttribArray(TEXTURE_POSITION);
+    glDisableVertexAttribArray(TEXTURE_TEXCOORD);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glUseProgram(program);
+}
+
+static void destroy_atlas_demo(struct atlas_demo* demo) {
+    const struct atlas* atlas = &demo->atlas;
+
+    if (demo->frames)
+        printf("Atlas: %d sprites in %.2f draws per frame (instead of %d), %u uploads (%.1f MB) streamed, "
+            "hit rate %.1f%%, %u page evictions\n", demo->sprites, (double) demo->draws / demo->frames,
+            demo->sprites, demo->uploads, demo->uploaded_bytes / 1e6,
+            100.0 * atlas->hits / (atlas->hits + atlas->misses ? atlas->hits + atlas->misses : 1), atlas->evictions);
+    if (demo->textures[0])
+        glDeleteTextures(ATLAS_DEMO_PAGES, demo->textures);
+    if (demo->staging)
+        glDeleteBuffers(1, &demo->staging);
+    if (demo->vbo)
+        glDeleteBuffers(1, &demo->vbo);
+    if (demo->program)
+        glDeleteProgram(demo->program);
+    free(demo->rects);
+    free(demo->vertices);
+}
+
+// ============================================================================================
+// Text (--text): glyphs are rendered from the font's outlines into signed distance fields
+// the first time they are drawn and cached in atlas pages. One distance field serves every
+// text size. Shaped runs, meaning glyph ids and pen positions, are cached per string, so
+// unchanged text costs one lookup per frame. Everything is drawn with one call per atlas page.
+// ============================================================================================
+
+#define TEXT_PAGE_SIZE 512
+#define TEXT_PAGES 2
+#define TEXT_GLYPH_SIZE 32      /* em size of the cached distance fields, pixels */
+#define TEXT_SPREAD 4           /* distance range, pixels either side of the outline */
+#define TEXT_MAX_RUNS 64
+#define TEXT_MAX_QUADS 8192     /* per page and frame */
+
+struct text_run {
+    char* string;
+    uint64_t hash;
+    int length;
+    uint16_t* glyphs;
+    int* pens;                  /* font units */
+    unsigned int last_used;
+};
+
+struct text {
+    const char* font_path;
+    struct font font;
+    struct atlas atlas;
+    GLuint textures[TEXT_PAGES];
+    GLenum format;              /* of the pages: GL_RED, GL_LUMINANCE before OpenGL (ES) 3.0 */
+    GLuint program, vbo;
+    GLint color_location, smoothing_location;
+    struct font_glyph* metrics; /* per glyph id, at TEXT_GLYPH_SIZE */
+    uint8_t* known;
+    uint8_t scratch[TEXT_PAGE_SIZE * TEXT_PAGE_SIZE / 16];
+    struct text_run runs[TEXT_MAX_RUNS];
+    GLfloat* vertices[TEXT_PAGES];
+    int quads[TEXT_PAGES];
+    int width, height;
+    bool enabled;
+    /* statistics */
+    unsigned int frames, draws, rasterized, run_hits, run_misses;
+    uint64_t glyphs_drawn;
+    int64_t time, raster_time;
+};
+
+static struct text text;
+
+static const char* text_vs_src =
+"attribute vec2 a_Position;\n"
+"attribute vec2 a_TexCoord;\n"
+"varying vec2 v_TexCoord;\n"
+"void main() {\n"
+"    gl_Position = vec4(a_Position, 0.0, 1.0);\n"
+"    v_TexCoord = a_TexCoord;\n"
+"}";
+
+/* u_Smoothing: half the width of the antialiased edge, in distance field units */
+static const char* text_fs_src =
+"#ifdef GL_ES\n"
+"precision mediump float;\n"
+"#endif\n"
+"varying vec2 v_TexCoord;\n"
+"uniform sampler2D u_Texture;\n"
+"uniform vec4 u_Color;\n"
+"uniform float u_Smoothing;\n"
+"void main() {\n"
+"    float distance = texture2D(u_Texture, v_TexCoord).r;\n"
+"    float alpha = smoothstep(0.5 - u_Smoothing, 0.5 + u_Smoothing, distance);\n"
+"    gl_FragColor = vec4(u_Color.rgb, u_Color.a * alpha);\n"
+"}";
+
+static int init_text(struct text* t, const struct egl* egl, int width, int height) {
+    int program;
+
+    if (font_open(&t->font, t->font_path ? t->font_path : FONT_DEFAULT_PATH))
+        return -1;
+    t->metrics = calloc(t->font.num_glyphs, sizeof(*t->metrics));
+    t->known = calloc(t->font.num_glyphs, 1);
+    if (!t->metrics || !t->known)
+        return -1;
+    for (int p = 0; p < TEXT_PAGES; p++) {
+        t->vertices[p] = malloc(TEXT_MAX_QUADS * 6 * 4 * sizeof(GLfloat));
+        if (!t->vertices[p])
+            return -1;
+    }
+    atlas_init(&t->atlas, TEXT_PAGE_SIZE, TEXT_PAGES, 1);
+    t->width = width;
+    t->height = height;
+
+    /* OpenGL ES 2 and OpenGL 2.1 have no GL_RED textures; luminance samples the same into .r */
+    t->format = egl->gl_major < 3 ? GL_LUMINANCE : GL_RED;
+    glGenTextures(TEXT_PAGES, t->textures);
+    for (int p = 0; p < TEXT_PAGES; p++) {
+        glBindTexture(GL_TEXTURE_2D, t->textures[p]);
+        glTexImage2D(GL_TEXTURE_2D, 0, t->format == GL_RED ? GL_R8 : GL_LUMINANCE, TEXT_PAGE_SIZE, TEXT_PAGE_SIZE, 0,
+            t->format, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    program = create_program(text_vs_src, text_fs_src);
+    if (program < 0)
+        return -1;
+    t->program = program;
+    glBindAttribLocation(t->program, TEXTURE_POSITION, "a_Position");
+    glBindAttribLocation(t->program, TEXTURE_TEXCOORD, "a_TexCoord");
+    if (link_program(t->program))
+        return -1;
+    t->color_location = glGetUniformLocation(t->program, "u_Color");
+    t->smoothing_location = glGetUniformLocation(t->program, "u_Smoothing");
+    glGenBuffers(1, &t->vbo);
+    return 0;
+}
+
+static uint32_t utf8_next(const char** s) {
+    const uint8_t* p = (const uint8_t*) *s;
+    uint32_t c = *p++;
+    int extra = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+
+    if (extra)
+        c &= 0x3f >> extra;
+    for (; extra && (*p & 0xc0) == 0x80; extra--)
+        c = c << 6 | (*p++ & 0x3f);
+    *s = (const char*) p;
+    return extra ? 0xfffd : c;
+}
+
+/* Glyph ids and pen positions of string, from the cache or shaped now */
+static const struct text_run* shape_text(struct text* t, const char* string) {
+    uint64_t hash = 0xcbf29ce484222325;
+    struct text_run* run = &t->runs[0];
+    int pen = 0;
+
+    for (const char* s = string; *s; s++)
+        hash = (hash ^ (uint8_t) *s) * 0x100000001b3;
+    for (int i = 0; i < TEXT_MAX_RUNS; i++) {
+        struct text_run* r = &t->runs[i];
+
+        if (r->string && r->hash == hash && !strcmp(r->string, string)) {
+            r->last_used = t->frames;
+            t->run_hits++;
+            return r;
+        }
+        if (r->last_used < run->last_used || (run->string && !r->string))
+            run = r;
+    }
+    t->run_misses++;
+
+    /* replace the least recently used run */
+    free(run->string);
+    free(run->glyphs);
+    free(run->pens);
+    run->string = strdup(string);
+    run->glyphs = malloc(strlen(string) * sizeof(*run->glyphs));
+    run->pens = malloc(strlen(string) * sizeof(*run->pens));
+    run->hash = hash;
+    run->length = 0;
+    run->last_used = t->frames;
+    if (!run->string || !run->glyphs || !run->pens)
+        return run;
+    for (const char* s = string; *s;) {
+        int glyph = font_glyph_index(&t->font, utf8_next(&s));
+
+        run->glyphs[run->length] = glyph;
+        run->pens[run->length++] = pen;
+        pen += font_glyph_advance(&t->font, glyph);
+    }
+    return run;
+}
+
+/* Atlas rectangle of glyph, rendering its distance field on a miss. False for blank glyphs. */
+static bool text_glyph(struct text* t, int glyph, struct atlas_rect* rect) {
+    struct font_glyph* m = &t->metrics[glyph];
+    int64_t start;
+
+    if (t->known[glyph] && !m->width)
+        return false;
+    if (atlas_lookup(&t->atlas, glyph, rect))
+        return true;
+
+    start = get_time_ns();
+    if (font_glyph_sdf(&t->font, glyph, (float) TEXT_GLYPH_SIZE / t->font.units_per_em, TEXT_SPREAD,
+        t->scratch, TEXT_PAGE_SIZE / 4, m)) {
+        m->width = 0;
+    }
+    t->known[glyph] = 1;
+    t->rasterized++;
+    t->raster_time += get_time_ns() - start;
+    if (!m->width || atlas_insert(&t->atlas, glyph, m->width, m->height, rect) < 0)
+        return false;
+
+    glBindTexture(GL_TEXTURE_2D, t->textures[rect->page]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect->x, rect->y, rect->w, rect->h, t->format, GL_UNSIGNED_BYTE, t->scratch);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return true;
+}
+
+/* Queue string with its baseline starting at x, y (pixels from the top left), size pixels per em */
+static void draw_text(struct text* t, const char* string, float x, float y, float size) {
+    const float k = size / TEXT_GLYPH_SIZE, em = size / t->font.units_per_em;
+    const float sx = 2.0f / t->width, sy = 2.0f / t->height;
+    int64_t start = get_time_ns();
+    const struct text_run* run = shape_text(t, string);
+
+    for (int i = 0; i < run->length; i++) {
+        const struct font_glyph* m = &t->metrics[run->glyphs[i]];
+        struct atlas_rect r;
+        float x0, y0, x1, y1;
+
+        if (!text_glyph(t, run->glyphs[i], &r) || t->quads[r.page] == TEXT_MAX_QUADS)
+            continue;
+        x0 = -1.0f + (x + run->pens[i] * em + m->left * k) * sx;
+        y1 = 1.0f - (y - m->top * k) * sy;
+        x1 = x0 + m->width * k * sx;
+        y0 = y1 - m->height * k * sy;
+        const GLfloat quad[6 * 4] = {
+            x0, y1, r.u0, r.v0, x0, y0, r.u0, r.v1, x1, y1, r.u1, r.v0,
+            x1, y1, r.u1, r.v0, x0, y0, r.u0, r.v1, x1, y0, r.u1, r.v1,
+        };
+        memcpy(&t->vertices[r.page][t->quads[r.page]++ * 6 * 4], quad, sizeof(quad));
+        t->glyphs_drawn++;
+    }
+    t->time += get_time_ns() - start;
+}
+
+/* Draw everything queued this frame, one call per atlas page */
+static void flush_text(struct text* t, float size) {
+    int64_t start = get_time_ns();
+    GLint program, vbo;
+
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &vbo);
+    glUseProgram(t->program);
+    glUniform4f(t->color_location, 1.0f, 1.0f, 1.0f, 1.0f);
+    /* about one screen pixel of edge, whatever the magnification */
+    glUniform1f(t->smoothing_location, 0.5f * TEXT_GLYPH_SIZE / (size * 2 * TEXT_SPREAD));
+    glBindBuffer(GL_ARRAY_BUFFER, t->vbo);
+    glVertexAttribPointer(TEXTURE_POSITION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) 0);
+    glVertexAttribPointer(TEXTURE_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*) (2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(TEXTURE_POSITION);
+    glEnableVertexAttribArray(TEXTURE_TEXCOORD);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    for (int p = 0; p < TEXT_PAGES; p++) {
+        if (!t->quads[p])
+            continue;
+        glBufferData(GL_ARRAY_BUFFER, t->quads[p] * 6 * 4 * sizeof(GLfloat), t->vertices[p], GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_2D, t->textures[p]);
+        glDrawArrays(GL_TRIANGLES, 0, t->quads[p] * 6);
+        t->quads[p] = 0;
+        t->draws++;
+    }
+    glDisable(GL_BLEND);
+    glDisableVertexAttribArray(TEXTURE_POSITION);
+    glDisableVertexAttribArray(TEXTURE_TEXCOORD);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glUseProgram(program);
+    t->time += get_time_ns() - start;
+}
+
+/* A screen of text: mostly static lines, which hit the run cache, and a counter, which does not */
+static void draw_text_demo(struct text* t) {
+    static const char* lines[] = {
+        "The quick brown fox jumps over the lazy dog.",
+        "Pack my box with five dozen liquor jugs!",
+        "Sphinx of black quartz, judge my vow. 0123456789",
+        "Zwölf Boxkämpfer jagen Viktor quer über den großen Sylter Deich.",
+    };
+    const float size = 20.0f, line_height = 1.25f * size;
+    char counter[64];
+
+    atlas_next_frame(&t->atlas);
+    snprintf(counter, sizeof(counter), "frame %u, %u glyphs rendered", t->frames, t->rasterized);
+    draw_text(t, counter, 16.0f, 2.0f * size, 2.0f * size);
+    for (int i = 0; 3.5f * size + (i + 1) * line_height < t->height; i++)
+        draw_text(t, lines[(i + t->frames / 60) % ARRAY_SIZE(lines)], 16.0f, 3.5f * size + (i + 1) * line_height, size);
+    flush_text(t, size);
+    t->frames++;
+}
+
+static void destroy_text(struct text* t) {
+    const struct atlas* atlas = &t->atlas;
+
+    if (t->frames)
+        printf("Text: %llu glyphs in %u frames, %.2f Mglyphs/s on the render thread, %.2f draws per frame, "
+            "%u glyphs rendered (%.3f ms each), glyph hit rate %.1f%%, run hit rate %.1f%%\n",
+            (unsigned long long) t->glyphs_drawn, t->frames, t->glyphs_drawn * 1e3 / (t->time ? t->time : 1),
+            (double) t->draws / t->frames, t->rasterized, t->raster_time / 1e6 / (t->rasterized ? t->rasterized : 1),
+            100.0 * atlas->hits / (atlas->hits + atlas->misses ? atlas->hits + atlas->misses : 1),
+            100.0 * t->run_hits / (t->run_hits + t->run_misses ? t->run_hits + t->run_misses : 1));
+    for (int i = 0; i < TEXT_MAX_RUNS; i++) {
+        free(t->runs[i].string);
+        free(t->runs[i].glyphs);
+        free(t->runs[i].pens);
+    }
+    for (int p = 0; p < TEXT_PAGES; p++)
+        free(t->vertices[p]);
+    if (t->textures[0])
+        glDeleteTextures(TEXT_PAGES, t->textures);
+    if (t->vbo)
+        glDeleteBuffers(1, &t->vbo);
+    if (t->program)
+        glDeleteProgram(t->program);
+    free(t->metrics);
+    free(t->known);
+    font_close(&t->font);
+}
+
+// ============================================================================================
+// Fill rate benchmark (-o): full-screen blended layers drawn over the scene, to compare
+// scanout layouts (-L linear vs the negotiated modifiers) where bandwidth matters
+// ============================================================================================
+
+struct overdraw {
+    int layers;
+    GLuint vbo, scene_vbo;
+    GLint position, color;
+};
+
+static struct overdraw overdraw;
+
+static void init_overdraw(struct overdraw* od, GLuint program, GLuint scene_vbo) {
+    static const GLfloat quad[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+    od->scene_vbo = scene_vbo;
+    od->position = glGetAttribLocation(program, "a_Position");
+    od->color = glGetUniformLocation(program, "u_Color");
+    glGenBuffers(1, &od->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, od->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, scene_vbo);
+}
+
+static void draw_overdraw(const struct overdraw* od) {
+    glBindBuffer(GL_ARRAY_BUFFER, od->vbo);
+    glVertexAttribPointer(od->position, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*) 0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUniform4f(od->color, 1.0f, 1.0f, 1.0f, 0.02f);
+    for (int i = 0; i < od->layers; i++)
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glUniform4f(od->color, 0.0f, 0.0f, 0.0f, 0.0f);
+    glDisable(GL_BLEND);
+    glBindBuffer(GL_ARRAY_BUFFER, od->scene_vbo);
+    glVertexAttribPointer(od->position, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*) 0);
+    /* wait for the GPU so "GL render+swap time" measures the fill, not the submission */
+    glFinish();
+}
+
+// ============================================================================================
+// Frame capture (-C) and streaming (--stream): glReadPixels into a ring of pixel-pack buffers.
+// A buffer is mapped READBACK_DELAY captures after its read was issued, when the GPU has long
+// finished it, and handed to the capture or encoder thread, so neither the GPU copy nor the
+// file writing or encoding stalls a frame
+// ============================================================================================
+
+#define READBACK_DELAY 2
+
+enum readback_state {
+    READBACK_FREE,
+    READBACK_READING,           /* glReadPixels issued into the buffer */
+    READBACK_MAPPED,            /* mapped and owned by the capture worker */
+};
+
+struct readback {
+    bool streaming;             /* feed the stream instead of the capture writer */
+    struct capture capture;
+    struct stream stream;
+    GLuint pbos[CAPTURE_SLOTS];
+    enum readback_state state[CAPTURE_SLOTS];
+    unsigned int numbers[CAPTURE_SLOTS];
+    GLenum format;
+    int width, height;
+    unsigned int every;         /* capture every Nth frame */
+    unsigned int issued, dropped;
+    int64_t time;               /* spent on the render thread */
+};
+
+static struct readback readback;
+
+static int init_readback(struct readback* rb, const struct egl* egl, const char* target, bool raw, int width, int height,
+    unsigned int vrefresh) {
+    GLint format = 0, type = 0;
+
+    if (egl->gl_major < 3) {
+        /* pixel pack buffers and glMapBufferRange() */
+        printf("init_readback: needs OpenGL ES 3.0 or OpenGL 3.0\n");
+        return -1;
+    }
+    if (egl->api == GL_API_GL) {
+        /* desktop GL reads BGRA natively, matching the XRGB8888 scanout layout */
+        rb->format = GL_BGRA_EXT;
+    } else {
+        /* read in the layout the driver stores, swizzling on the worker is cheaper */
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &format);
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &type);
+        rb->format = format == GL_BGRA_EXT && type == GL_UNSIGNED_BYTE ? GL_BGRA_EXT : GL_RGBA;
+    }
+    rb->width = width;
+    rb->height = height;
+    if (!rb->every)
+        rb->every = 1;
+
+    if (rb->streaming) {
+        if (stream_start(&rb->stream, target, width, height, vrefresh / rb->every, rb->format == GL_BGRA_EXT))
+            return -1;
+    } else if (capture_start(&rb->capture, target, raw, width, height, rb->format == GL_BGRA_EXT)) {
+        return -1;
+    }
+    glGenBuffers(CAPTURE_SLOTS, rb->pbos);
+    for (int i = 0; i < CAPTURE_SLOTS; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) width * height * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (rb->streaming)
+        printf("Streaming every %u frame(s) to %s, reading %s\n", rb->every, target,
+            rb->format == GL_BGRA_EXT ? "BGRA" : "RGBA");
+    else
+        printf("Capturing every %u frame(s) to %s-*.%s, reading %s\n", rb->every, target,
+            raw ? "rgba" : "png", rb->format == GL_BGRA_EXT ? "BGRA" : "RGBA");
+    return 0;
+}
+
+/* Hand a read buffer to the worker; the pixel pack buffer must be bound */
+static void readback_map(struct readback* rb, int slot) {
+    const void* pixels;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[slot]);
+    pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr) rb->width * rb->height * 4, GL_MAP_READ_BIT);
+    if (!pixels) {
+        printf("readback_map: glMapBufferRange failed: 0x%x\n", glGetError());
+        rb->state[slot] = READBACK_FREE;
+        return;
+    }
+    rb->state[slot] = READBACK_MAPPED;
+    if (!rb->streaming) {
+        capture_submit(&rb->capture, slot, pixels, rb->numbers[slot]);
+    } else if (!stream_push(&rb->stream, slot, pixels, rb->numbers[slot])) {
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        rb->state[slot] = READBACK_FREE;
+    }
+}
+
+static bool readback_busy(struct readback* rb, int slot) {
+    return rb->streaming ? stream_busy(&rb->stream, slot) : capture_busy(&rb->capture, slot);
+}
+
+/* Capture the back buffer of the current surface before it is swapped */
+static void readback_frame(struct readback* rb, unsigned int number) {
+    int64_t start = get_time_ns();
+    int slot = rb->issued % CAPTURE_SLOTS;
+
+    if (number % rb->every)
+        return;
+
+    if (rb->state[slot] == READBACK_MAPPED) {
+        /* the worker still writes out this buffer: skip the frame rather than wait */
+        if (readback_busy(rb, slot)) {
+            rb->dropped++;
+            if (rb->streaming)
+                stream_skip(&rb->stream);
+            rb->time += get_time_ns() - start;
+            return;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[slot]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        rb->state[slot] = READBACK_FREE;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[slot]);
+    glReadPixels(0, 0, rb->width, rb->height, rb->format, GL_UNSIGNED_BYTE, (void*) 0);
+    rb->state[slot] = READBACK_READING;
+    rb->numbers[slot] = number;
+    rb->issued++;
+
+    if (rb->issued > READBACK_DELAY) {
+        int ready = (rb->issued - 1 - READBACK_DELAY) % CAPTURE_SLOTS;
+
+        if (rb->state[ready] == READBACK_READING)
+            readback_map(rb, ready);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    rb->time += get_time_ns() - start;
+}
+
+/* Write out the reads still in flight, then release the buffers */
+static void finish_readback(struct readback* rb) {
+    unsigned int first = rb->issued > READBACK_DELAY ? rb->issued - READBACK_DELAY : 0;
+
+    if (!rb->pbos[0])
+        return;
+    for (unsigned int i = first; i < rb->issued; i++) {
+        if (rb->state[i % CAPTURE_SLOTS] == READBACK_READING)
+            readback_map(rb, i % CAPTURE_SLOTS);
+    }
+    if (rb->streaming)
+        stream_drain(&rb->stream);
+    else
+        capture_drain(&rb->capture);
+    for (int i = 0; i < CAPTURE_SLOTS; i++) {
+        if (rb->state[i] == READBACK_MAPPED) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[i]);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteBuffers(CAPTURE_SLOTS, rb->pbos);
+    if (rb->streaming)
+        stream_stop(&rb->stream);
+    else
+        capture_stop(&rb->capture);
+    printf("Readback: %u frames read back, %u dropped, %.3f ms/frame on the render thread\n",
+        rb->issued, rb->dropped, rb->time / 1e6 / (rb->issued + rb->dropped ? rb->issued + rb->dropped : 1));
+}
+
+// ============================================================================================
+// Input (--input): evdev events arrive from the reader thread with their kernel timestamps.
+// Each frame on the first output takes what queued up since the last one: keys and buttons
+// held down light up the background, Esc quits. The oldest event a frame reacts to travels
+// with its flip, and the page flip event turns it into the input-to-scanout latency.
+// With --cursor, pointer motion moves the hardware cursor right on the reader thread.
+// ============================================================================================
+
+struct input_sampler {
+    struct input input;
+    const char* device;         /* NULL: all devices */
+    bool enabled, quit;
+    int held;                   /* keys and buttons down */
+    /* reader thread only */
+    struct cursor cursor;
+    bool use_cursor, pointer_moved;
+    int pointer_x, pointer_y;
+    int width, height;
+};
+
+static struct input_sampler input_sampler;
+
+/* Reader thread: motion goes to the cursor plane once per report, no frame is drawn for it */
+static void move_pointer(void* data, const struct input_record* record) {
+    struct input_sampler* sampler = data;
+    const int* min = sampler->input.abs_min[record->device];
+    const int* max = sampler->input.abs_max[record->device];
+
+    if (record->type == EV_REL && record->code == REL_X) {
+        sampler->pointer_x += record->value;
+    } else if (record->type == EV_REL && record->code == REL_Y) {
+        sampler->pointer_y += record->value;
+    } else if (record->type == EV_ABS && record->code == ABS_X && max[0] > min[0]) {
+        sampler->pointer_x = (int64_t) (record->value - min[0]) * (sampler->width - 1) / (max[0] - min[0]);
+    } else if (record->type == EV_ABS && record->code == ABS_Y && max[1] > min[1]) {
+        sampler->pointer_y = (int64_t) (record->value - min[1]) * (sampler->height - 1) / (max[1] - min[1]);
+    } else {
+        if (record->type == EV_SYN && record->code == SYN_REPORT && sampler->pointer_moved) {
+            cursor_move(&sampler->cursor, sampler->pointer_x, sampler->pointer_y);
+            sampler->pointer_moved = false;
+        }
+        return;
+    }
+    if (sampler->pointer_x < 0)
+        sampler->pointer_x = 0;
+    if (sampler->pointer_x >= sampler->width)
+        sampler->pointer_x = sampler->width - 1;
+    if (sampler->pointer_y < 0)
+        sampler->pointer_y = 0;
+    if (sampler->pointer_y >= sampler->height)
+        sampler->pointer_y = sampler->height - 1;
+    sampler->pointer_moved = true;
+}
+
+/* Apply the queued events, returns the timestamp of the oldest one that changes the frame, 0 if none */
+static int64_t sample_input(struct input_sampler* sampler) {
+    struct input_record record;
+    int64_t oldest = 0;
+
+    while (input_poll(&sampler->input, &record)) {
+        /* autorepeat changes nothing on screen */
+        if (record.type != EV_KEY || record.value == 2)
+            continue;
+        if (record.code == KEY_ESC)
+            sampler->quit = true;
+        sampler->held += record.value ? 1 : -1;
+        if (sampler->held < 0)
+            sampler->held = 0;
+        if (!oldest)
+            oldest = record.time;
+    }
+    return oldest;
+}
+
+static void draw_output(const struct egl* egl, const struct drm* drm, struct output* output) {
+    /* one context shared by all outputs: only switch surfaces if needed */
+    if (drm->num_outputs > 1) {
+        eglMakeCurrent(egl->display, output->egl_surface, output->egl_surface, egl->context);
+        glViewport(0, 0, output->mode->hdisplay, output->mode->vdisplay);
+    }
+    if (drm->damage) {
+        draw_damage_scene(egl, output);
+        return;
+    }
+
+    if (input_sampler.held)
+        glClearColor(1.0f, 0.5f, 0.0f, 1.0f); // Orange while a key is down
+    else
+        glClearColor(0.0f, 0.5f, 1.0f, 1.0f); // Blue background
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    if (overdraw.layers)
+        draw_overdraw(&overdraw);
+    if (video_demo.active)
+        update_video_demo(&video_demo, egl, output);
+    if (import_demo.program)
+        draw_import_demo(&import_demo);
+    if (texture_demo.program)
+        draw_texture_demo(&texture_demo);
+    if (atlas_demo.program)
+        draw_atlas_demo(&atlas_demo);
+    if (text.program)
+        draw_text_demo(&text);
+}
+
+/* gl_client: input and the per-frame work of the first output around its frame */
+static int64_t draw_frame(void* data, const struct egl* egl, struct drm* drm, int index) {
+    struct output* output = &drm->outputs[index];
+    int64_t input_time = 0;
+
+    (void) data;
+    if (input_sampler.input.running && index == 0)
+        input_time = sample_input(&input_sampler);
+    if (upload_stress.size && index == 0)
+        upload_stress_frame(&upload_stress, egl, &uploader);
+    draw_output(egl, drm, output);
+    if (readback.pbos[0] && index == 0)
+        readback_frame(&readback, output->frames);
+    return input_time;
+}
+
+static bool quit_requested(void* data) {
+    (void) data;
+    return input_sampler.quit;
+}
+
+/* The demo scene (blue background, black triangle) drawn by the CPU rasterizer */
+static void draw_sw_scene(struct swrender* sw) {
+    const float w = sw->width, h = sw->height;
+    /* same vertices as the GL vertex buffer, NDC -> pixels */
+    const float triangle[6] = {
+        0.5f * w, 0.25f * h,    // Top
+        0.25f * w, 0.75f * h,   // Bottom left
+        0.75f * w, 0.75f * h,   // Bottom right
+    };
+
+    sw_fill_rect(sw, 0, 0, sw->width, sw->height, 0xff0080ff); // Blue background
+    sw_fill_triangle(sw, triangle, 0xff000000);
+}
+
+
+static struct gbm gbm;
+static struct drm drm;
+static struct egl egl;
+static struct swrender sw;
+
+// Vertex Shader Source Code, create_program() adds the #version
+static const char* vertexShaderSource =
+"#if __VERSION__ >= 130\n"
+"#define COMPAT_VARYING out\n"
+"#define COMPAT_ATTRIBUTE in\n"
+"#define COMPAT_TEXTURE texture\n"
+"#else\n"
+"#define COMPAT_VARYING varying \n"
+"#define COMPAT_ATTRIBUTE attribute \n"
+"#define COMPAT_TEXTURE texture2D\n"
+"#endif\n"
+"COMPAT_ATTRIBUTE vec4 a_Position;\n"
+"void main() {\n"
+"    gl_Position = a_Position;\n"
+"}";
+
+// Fragment Shader Source Code
+static const char* fragmentShaderSource =
+"#ifdef GL_ES\n"
+"precision mediump float;\n"
+"#endif\n"
+"#if __VERSION__ >= 130\n"
+"#define COMPAT_VARYING in\n"
+"#define COMPAT_TEXTURE texture\n"
+"out vec4 FragColor;\n"
+"#else\n"
+"#define COMPAT_VARYING varying\n"
+"#define FragColor gl_FragColor\n"
+"#define COMPAT_TEXTURE texture2D\n"
+"#endif\n"
+"uniform vec4 u_Color;\n"
+"void main(void) {\n"
+"    FragColor = u_Color;\n"
+"}\n";
+
+/* long options without a short form */
+enum {
+    OPT_CAPTURE_EVERY = 0x100,
+    OPT_CAPTURE_RAW,
+    OPT_STREAM,
+    OPT_UPLOAD_STRESS,
+    OPT_UPLOAD_SYNC,
+    OPT_ATLAS,
+    OPT_TEXT,
+    OPT_FONT,
+    OPT_INPUT,
+    OPT_CURSOR,
+    OPT_API,
+};
+
+static const struct option longopts[] = {
+    {"all-outputs", no_argument,       0, 'a'},
+    {"connector",   required_argument, 0, 'c'},
+    {"capture",     required_argument, 0, 'C'},
+    {"capture-every", required_argument, 0, OPT_CAPTURE_EVERY},
+    {"capture-raw", no_argument,       0, OPT_CAPTURE_RAW},
+    {"stream",      required_argument, 0, OPT_STREAM},
+    {"damage",      no_argument,       0, 'd'},
+    {"device",      required_argument, 0, 'D'},
+    {"format",      required_argument, 0, 'f'},
+    {"import",      no_argument,       0, 'i'},
+    {"linear",      no_argument,       0, 'L'},
+    {"mode",        required_argument, 0, 'm'},
+    {"frames",      required_argument, 0, 'n'},
+    {"overdraw",    required_argument, 0, 'o'},
+    {"samples",     required_argument, 0, 's'},
+    {"software",    no_argument,       0, 'S'},
+    {"texture",     required_argument, 0, 't'},
+    {"upload-stress", required_argument, 0, OPT_UPLOAD_STRESS},
+    {"upload-sync", no_argument,       0, OPT_UPLOAD_SYNC},
+    {"atlas",       required_argument, 0, OPT_ATLAS},
+    {"text",        no_argument,       0, OPT_TEXT},
+    {"font",        required_argument, 0, OPT_FONT},
+    {"input",       optional_argument, 0, OPT_INPUT},
+    {"cursor",      no_argument,       0, OPT_CURSOR},
+    {"video",       no_argument,       0, 'V'},
+    {"api",         required_argument, 0, OPT_API},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+static const char* api_names[] = { "auto", "gles", "gl" };
+
+static void usage(const char* name, enum gl_api api) {
+    printf("Usage: %s [-acCdDfiLmnosStVh]\n"
+        "\n"
+        "options:\n"
+        "    -a, --all-outputs        render on every connected connector\n"
+        "    -c, --connector=N        use the Nth connector\n"
+        "    -C, --capture=PREFIX     write the frames to PREFIX-<frame>.png\n"
+        "        --capture-every=N    only capture every Nth frame\n"
+        "        --capture-raw        write raw RGBA files instead of PNG\n"
+        "        --stream=TARGET      stream the frames as YUV4MPEG2 to a file, or to\n"
+        "                             an encoder given as '|command'\n"
+        "    -d, --damage             only redraw and scan out what changed\n"
+        "    -D, --device=DEVICE      use the given device\n"
+        "    -f, --format=FORMAT      scanout format: %s\n"
+        "    -i, --import             show a dma-buf imported through EGLImage\n"
+        "    -L, --linear             scan out linear buffers, no modifier negotiation\n"
+        "    -m, --mode=MODE          specify the video mode in the format\n"
+        "                             <mode>[-<vrefresh>]\n"
+        "    -n, --frames=N           run for the given number of frames and exit\n"
+        "    -o, --overdraw=N         fill rate test: blend N full-screen layers per frame\n"
+        "    -s, --samples=N          use MSAA\n"
+        "    -S, --software           render with the CPU into dumb buffers (no GPU)\n"
+        "    -t, --texture=FILE       show a KTX/KTX2 texture (ETC1/ETC2/ASTC/RGBA8)\n"
+        "        --upload-stress=SIZE upload a SIZExSIZE texture every frame\n"
+        "        --upload-sync        do the uploads on the render thread\n"
+        "        --atlas=N            draw N sprites streamed into a texture atlas\n"
+        "        --text               draw a screen of text from an SDF glyph atlas\n"
+        "        --font=FILE          TrueType font for --text (default " FONT_DEFAULT_PATH ")\n"
+        "        --input[=DEVICE]     read evdev input (all devices by default), measure\n"
+        "                             input to scanout latency; keys light up, Esc quits\n"
+        "        --cursor             hardware cursor moved by the --input pointer devices\n"
+        "    -V, --video              show NV12 video frames on an overlay plane\n"
+        "        --api=API            auto, gles or gl (default %s)\n"
+        "    -h, --help               show this help\n",
+        name, pixel_format_names(), api_names[api]);
+}
+
+int demo_main(int argc, char* argv[], enum gl_api api, const char* mode, unsigned int count) {
+    const struct gl_client client = { NULL, draw_frame, quit_requested };
+    const char* device = NULL;
+    char mode_str[DRM_DISPLAY_MODE_LEN];
+    char* p;
+    uint32_t format = PROFILE_FORMAT;
+    bool force_linear = false;
+    int samples = 0;
+    int connector_id = -1;
+    unsigned int vrefresh = 0;
+    bool nonblocking = false;
+    bool all_outputs = false;
+    bool software = false;
+    const char* capture = NULL;
+    const char* texture = NULL;
+    bool capture_raw = false;
+    bool damage = false;
+    bool import = false;
+    bool video = false;
+    int opt, ret;
+
+    snprintf(mode_str, sizeof(mode_str), "%s", mode);
+    while ((opt = getopt_long(argc, argv, "ac:C:dD:f:iLm:n:o:s:St:Vh", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'a':
+            all_outputs = true;
+            break;
+        case 'c':
+            connector_id = strtol(optarg, NULL, 0);
+            break;
+        case 'C':
+            capture = optarg;
+            readback.streaming = false;
+            break;
+        case OPT_CAPTURE_EVERY:
+            readback.every = strtoul(optarg, NULL, 0);
+            break;
+        case OPT_CAPTURE_RAW:
+            capture_raw = true;
+            break;
+        case OPT_UPLOAD_STRESS:
+            upload_stress.size = strtoul(optarg, NULL, 0);
+            break;
+        case OPT_UPLOAD_SYNC:
+            upload_stress.sync = true;
+            break;
+        case OPT_ATLAS:
+            atlas_demo.sprites = strtoul(optarg, NULL, 0);
+            break;
+        case OPT_TEXT:
+            text.enabled = true;
+            break;
+        case OPT_FONT:
+            text.font_path = optarg;
+            break;
+        case OPT_INPUT:
+            input_sampler.enabled = true;
+            input_sampler.device = optarg;
+            break;
+        case OPT_CURSOR:
+            input_sampler.use_cursor = true;
+            input_sampler.enabled = true;
+            break;
+        case OPT_STREAM:
+            capture = optarg;
+            readback.streaming = true;
+            break;
+        case 'd':
+            damage = true;
+            break;
+        case 'D':
+            device = optarg;
+            break;
+        case 'f': {
+            const struct pixel_format* pixel_format = pixel_format_by_name(optarg);
+
+            if (!pixel_format) {
+                printf("unknown format %s, use one of %s\n", optarg, pixel_format_names());
+                return -1;
+            }
+            format = pixel_format->fourcc;
+            break;
+        }
+        case 'i':
+            import = true;
+            break;
+        case 'L':
+            force_linear = true;
+            break;
+        case 'm': {
+            size_t len;
+            p = strchr(optarg, '-');
+            if (p == NULL) {
+                len = strlen(optarg);
+            } else {
+                vrefresh = strtoul(p + 1, NULL, 0);
+                len = p - optarg;
+            }
+            if (len > sizeof(mode_str) - 1)
+                len = sizeof(mode_str) - 1;
+            strncpy(mode_str, optarg, len);
+            mode_str[len] = '\0';
+            break;
+        }
+        case 'n':
+            count = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            overdraw.layers = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            samples = strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            software = true;
+            break;
+        case 't':
+            texture = optarg;
+            break;
+        case 'V':
+            video = true;
+            break;
+        case OPT_API: {
+            unsigned int i = 0;
+
+            while (i < ARRAY_SIZE(api_names) && strcmp(optarg, api_names[i]))
+                i++;
+            if (i == ARRAY_SIZE(api_names)) {
+                printf("unknown api %s, use auto, gles or gl\n", optarg);
+                return -1;
+            }
+            api = i;
+            break;
+        }
+        case 'h':
+        default:
+            usage(argv[0], api);
+            return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    ret = init_drm(&drm, device, mode_str, connector_id, vrefresh, count, nonblocking);
+    if (ret) {
+        debug_printf("failed to initialize DRM. Code %d\n", ret);
+        return ret;
+    } else {
+        debug_printf("Initializing DRM fullscreen %dx%d [OK]\n", drm.mode->hdisplay, drm.mode->vdisplay);
+    }
+
+    if (all_outputs && init_drm_outputs(&drm)) {
+        debug_printf("failed to probe extra outputs\n");
+        return -1;
+    }
+
+    if (software) {
+        ret = run_sw_loop(&drm, &sw, draw_sw_scene);
+        /* a no-op once run_sw_loop() has given the CRTCs back; gbm and egl were never set up */
+        restore_drm(&drm);
+        destroy_kmsdrm(&gbm, &egl, &drm);
+        return ret;
+    }
+
+    if (damage)
+        init_damage(&drm);
+
+    ret = init_gbm(&gbm, &drm, drm.mode->hdisplay, drm.mode->vdisplay, format, force_linear);
+    if (ret) {
+        debug_printf("failed to initialize GBM. Code %d\n", ret);
+        return ret;
+    } else {
+        debug_printf("Initializing GBM [OK]\n");
+    }
+
+    /* the demos draw without depth or stencil testing */
+    ret = init_egl(&egl, &gbm, samples, 0, 0, api);
+    if (ret) {
+        debug_printf("failed to initialize EGL. Code %d\n", ret);
+        return ret;
+    } else {
+        debug_printf("Initializing EGL [OK]\n");
+    }
+
+    ret = init_output_surfaces(&gbm, &egl, &drm);
+    if (ret) {
+        debug_printf("failed to initialize output surfaces. Code %d\n", ret);
+        return ret;
+    }
+
+    int phase = startup_trace_begin("demo setup");
+    GLuint program = create_program(vertexShaderSource, fragmentShaderSource);
+    if (program < 0) { // return program negative = ERROR
+        debug_printf("failed to compile shader. Code %d\n", program);
+        return program;
+    }
+    ret = link_program(program);
+    if (ret) {
+        debug_printf("failed to link shader. Code %d\n", ret);
+        return ret;
+    }
+    glUseProgram(program);
+
+    // ============================================================================================
+    // GL init setup
+    // ============================================================================================
+    GLfloat vertices[] = {
+        0.0f, 0.5f,   // Top
+        -0.5f, -0.5f, // Bottom left
+        0.5f, -0.5f   // Bottom right
+    };
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    GLint position = glGetAttribLocation(program, "a_Position");
+    glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*) 0);
+    glEnableVertexAttribArray(position);
+    glViewport(0, 0, gbm.width, gbm.height);
+    if (overdraw.layers)
+        init_overdraw(&overdraw, program, vbo);
+    if ((texture || upload_stress.size) && !upload_stress.sync && init_uploader(&uploader, &egl))
+        printf("no loader context, uploading on the render thread\n");
+    if (upload_stress.size && init_upload_stress(&upload_stress, &uploader)) {
+        printf("upload stress unavailable, continuing without it\n");
+        upload_stress.size = 0;
+    }
+    if (texture && init_texture_demo(&texture_demo, &egl, texture)) {
+        printf("texture unavailable, continuing without it\n");
+        destroy_texture_demo(&texture_demo);
+        memset(&texture_demo, 0, sizeof(texture_demo));
+    }
+    if (atlas_demo.sprites && init_atlas_demo(&atlas_demo, &egl, drm.mode->hdisplay, drm.mode->vdisplay)) {
+        printf("atlas unavailable, continuing without it\n");
+        destroy_atlas_demo(&atlas_demo);
+        memset(&atlas_demo, 0, sizeof(atlas_demo));
+    }
+    if (text.enabled && init_text(&text, &egl, drm.mode->hdisplay, drm.mode->vdisplay)) {
+        printf("text unavailable, continuing without it\n");
+        destroy_text(&text);
+        memset(&text, 0, sizeof(text));
+    }
+    if (input_sampler.use_cursor) {
+        input_sampler.width = drm.mode->hdisplay;
+        input_sampler.height = drm.mode->vdisplay;
+        input_sampler.pointer_x = input_sampler.width / 2;
+        input_sampler.pointer_y = input_sampler.height / 2;
+        if (cursor_init(&input_sampler.cursor, drm.fd, drm.crtc_id, NULL, 0, 0, 0, 0))
+            printf("cursor unavailable, continuing without it\n");
+        else
+            cursor_move(&input_sampler.cursor, input_sampler.pointer_x, input_sampler.pointer_y);
+    }
+    if (input_sampler.enabled && input_start(&input_sampler.input, input_sampler.device,
+        input_sampler.cursor.handle ? move_pointer : NULL, &input_sampler))
+        printf("input unavailable, continuing without it\n");
+    if (capture && init_readback(&readback, &egl, capture, capture_raw, drm.mode->hdisplay, drm.mode->vdisplay, drm.mode->vrefresh)) {
+        printf("frame capture unavailable, continuing without it\n");
+        memset(&readback, 0, sizeof(readback));
+    }
+    if (import && (init_import_demo(&import_demo, &egl) || create_import_frame(&import_demo, &gbm))) {
+        printf("dma-buf import unavailable, continuing without it\n");
+        destroy_import_demo(&import_demo);
+        memset(&import_demo, 0, sizeof(import_demo));
+    }
+    if (video && init_video_demo(&video_demo, &drm)) {
+        printf("video frames unavailable, continuing without them\n");
+        destroy_video_demo(&video_demo);
+        memset(&video_demo, 0, sizeof(video_demo));
+    }
+    startup_trace_end(phase);
+    debug_puts("Initializing OpenGL(ES) [OK]");
+
+    // ============================================================================================
+    // GL drawing loop
+    // ============================================================================================
+    run_gl_loop(&gbm, &egl, &drm, &client);
+    input_stop(&input_sampler.input);
+    cursor_destroy(&input_sampler.cursor);
+    finish_readback(&readback);
+    finish_upload_stress(&upload_stress);
+    destroy_texture_demo(&texture_demo);
+    destroy_uploader(&uploader);
+    /* take the video off its plane before the CRTC goes back to its old owner */
+    destroy_video_demo(&video_demo);
+    restore_drm(&drm);
+
+    destroy_import_demo(&import_demo);
+
+    destroy_atlas_demo(&atlas_demo);
+    destroy_text(&text);
+
+    // if (program > 0) {
+    glDeleteProgram(program);
+    // }
+
+    destroy_kmsdrm(&gbm, &egl, &drm);
+    return 0;
+}
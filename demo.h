@@ -0,0 +1,16 @@
+/*
+Demos and benchmarks on libkmsdrm, shared by the basic_opengles and basic_opengl apps
+ */
+
+#ifndef _DEMO_H
+#define _DEMO_H
+
+#include "kmsdrm.h"
+
+/* Parse the command line and run the demos. api, mode and count are the
+ * app's defaults for --api, --mode and --frames; an empty mode is the
+ * connector's preferred one.
+ */
+int demo_main(int argc, char* argv[], enum gl_api api, const char* mode, unsigned int count);
+
+#endif /* _DEMO_H */
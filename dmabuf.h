@@ -0,0 +1,26 @@
+/*
+Description of a dma-buf frame shared by the GL import and the direct
+scanout paths
+ */
+
+#ifndef _DMABUF_H
+#define _DMABUF_H
+
+#include <stdint.h>
+
+#define DMABUF_MAX_PLANES 4
+
+/* A dma-buf frame as handed out by its producer. The fds stay owned by the
+ * caller; planes of one buffer may share the same fd at different offsets.
+ */
+struct dmabuf_desc {
+    int width, height;
+    uint32_t format;            /* DRM_FORMAT_* fourcc */
+    uint64_t modifier;          /* DRM_FORMAT_MOD_INVALID for an implicit layout */
+    int num_planes;
+    int fds[DMABUF_MAX_PLANES];
+    uint32_t offsets[DMABUF_MAX_PLANES];
+    uint32_t pitches[DMABUF_MAX_PLANES];
+};
+
+#endif /* _DMABUF_H */
@@ -0,0 +1,183 @@
+/*
+Zero-copy import of dma-buf frames as GL_TEXTURE_EXTERNAL_OES textures
+
+Each frame becomes an EGLImage (EGL_LINUX_DMA_BUF_EXT) bound to an external
+texture, so the GPU samples the producer's memory directly and YUV formats
+are converted by the sampler. Decoders and cameras cycle through a small
+pool of buffers, so imports are cached by dma-buf inode and a frame seen
+before costs one fstat() instead of an EGLImage creation.
+ */
+
+#include "dmabuf_import.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
+#endif
+
+int init_dmabuf_importer(struct dmabuf_importer* importer, EGLDisplay display, const struct ext_set* egl_exts,
+    const struct ext_set* gl_exts, bool modifiers_supported) {
+    memset(importer, 0, sizeof(*importer));
+    importer->display = display;
+    importer->modifiers_supported = modifiers_supported;
+
+    if (!ext_set_has(egl_exts, "EGL_EXT_image_dma_buf_import") || !ext_set_has(egl_exts, "EGL_KHR_image_base")) {
+        printf("init_dmabuf_importer: EGL_EXT_image_dma_buf_import not supported\n");
+        return -1;
+    }
+    if (!ext_set_has(gl_exts, "GL_OES_EGL_image_external")) {
+        printf("init_dmabuf_importer: GL_OES_EGL_image_external not supported\n");
+        return -1;
+    }
+    importer->eglCreateImageKHR = (void*) eglGetProcAddress("eglCreateImageKHR");
+    importer->eglDestroyImageKHR = (void*) eglGetProcAddress("eglDestroyImageKHR");
+    importer->glEGLImageTargetTexture2DOES = (void*) eglGetProcAddress("glEGLImageTargetTexture2DOES");
+    if (!importer->eglCreateImageKHR || !importer->eglDestroyImageKHR || !importer->glEGLImageTargetTexture2DOES)
+        return -1;
+    return 0;
+}
+
+static void release_image(struct dmabuf_importer* importer, struct dmabuf_image* entry) {
+    if (entry->texture)
+        glDeleteTextures(1, &entry->texture);
+    if (entry->image != EGL_NO_IMAGE_KHR)
+        importer->eglDestroyImageKHR(importer->display, entry->image);
+    memset(entry, 0, sizeof(*entry));
+}
+
+void destroy_dmabuf_importer(struct dmabuf_importer* importer) {
+    for (int i = 0; i < DMABUF_CACHE_SIZE; i++) {
+        if (importer->cache[i].texture)
+            release_image(importer, &importer->cache[i]);
+    }
+    if (importer->imports)
+        printf("dmabuf_import: %u imports, %u cache hits\n", importer->imports, importer->hits);
+}
+
+static EGLImageKHR create_image(const struct dmabuf_importer* importer, const struct dmabuf_desc* desc) {
+    static const EGLint plane_attribs[DMABUF_MAX_PLANES][5] = {
+        { EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+          EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT },
+        { EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+          EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT },
+        { EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+          EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT },
+        { EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT, EGL_DMA_BUF_PLANE3_PITCH_EXT,
+          EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT },
+    };
+    EGLint attribs[7 + DMABUF_MAX_PLANES * 10 + 1];
+    bool modifier = importer->modifiers_supported && desc->modifier != DRM_FORMAT_MOD_INVALID;
+    int n = 0;
+
+    attribs[n++] = EGL_WIDTH;
+    attribs[n++] = desc->width;
+    attribs[n++] = EGL_HEIGHT;
+    attribs[n++] = desc->height;
+    attribs[n++] = EGL_LINUX_DRM_FOURCC_EXT;
+    attribs[n++] = desc->format;
+    for (int i = 0; i < desc->num_planes && i < DMABUF_MAX_PLANES; i++) {
+        attribs[n++] = plane_attribs[i][0];
+        attribs[n++] = desc->fds[i];
+        attribs[n++] = plane_attribs[i][1];
+        attribs[n++] = desc->offsets[i];
+        attribs[n++] = plane_attribs[i][2];
+        attribs[n++] = desc->pitches[i];
+        if (modifier) {
+            attribs[n++] = plane_attribs[i][3];
+            attribs[n++] = desc->modifier & 0xffffffff;
+            attribs[n++] = plane_attribs[i][4];
+            attribs[n++] = desc->modifier >> 32;
+        }
+    }
+    attribs[n] = EGL_NONE;
+
+    /* no client buffer: everything comes from the attributes */
+    return importer->eglCreateImageKHR(importer->display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+}
+
+static struct dmabuf_image* lookup(struct dmabuf_importer* importer, const struct stat* st,
+    const struct dmabuf_desc* desc) {
+    for (int i = 0; i < DMABUF_CACHE_SIZE; i++) {
+        struct dmabuf_image* entry = &importer->cache[i];
+
+        if (entry->texture && entry->dev == st->st_dev && entry->ino == st->st_ino &&
+            entry->offset == desc->offsets[0] && entry->format == desc->format &&
+            entry->width == desc->width && entry->height == desc->height)
+            return entry;
+    }
+    return NULL;
+}
+
+static struct dmabuf_image* evict(struct dmabuf_importer* importer) {
+    struct dmabuf_image* victim = &importer->cache[0];
+
+    for (int i = 0; i < DMABUF_CACHE_SIZE; i++) {
+        struct dmabuf_image* entry = &importer->cache[i];
+
+        if (!entry->texture)
+            return entry;
+        if (entry->last_used < victim->last_used)
+            victim = entry;
+    }
+    release_image(importer, victim);
+    return victim;
+}
+
+GLuint dmabuf_import(struct dmabuf_importer* importer, const struct dmabuf_desc* desc) {
+    struct dmabuf_image* entry;
+    struct stat st;
+
+    if (desc->num_planes < 1 || fstat(desc->fds[0], &st)) {
+        printf("dmabuf_import: invalid dma-buf\n");
+        return 0;
+    }
+
+    importer->clock++;
+    entry = lookup(importer, &st, desc);
+    if (entry) {
+        importer->hits++;
+        entry->last_used = importer->clock;
+        return entry->texture;
+    }
+
+    entry = evict(importer);
+    entry->image = create_image(importer, desc);
+    if (entry->image == EGL_NO_IMAGE_KHR) {
+        printf("dmabuf_import: eglCreateImageKHR failed for %.4s %dx%d: 0x%x\n",
+            (const char*) &desc->format, desc->width, desc->height, eglGetError());
+        return 0;
+    }
+    importer->imports++;
+
+    glGenTextures(1, &entry->texture);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, entry->texture);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    importer->glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, entry->image);
+
+    entry->dev = st.st_dev;
+    entry->ino = st.st_ino;
+    entry->width = desc->width;
+    entry->height = desc->height;
+    entry->format = desc->format;
+    entry->offset = desc->offsets[0];
+    entry->last_used = importer->clock;
+    return entry->texture;
+}
+
+void dmabuf_forget(struct dmabuf_importer* importer, int fd) {
+    struct stat st;
+
+    if (fstat(fd, &st))
+        return;
+    for (int i = 0; i < DMABUF_CACHE_SIZE; i++) {
+        struct dmabuf_image* entry = &importer->cache[i];
+
+        if (entry->texture && entry->dev == st.st_dev && entry->ino == st.st_ino)
+            release_image(importer, entry);
+    }
+}
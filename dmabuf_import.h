@@ -0,0 +1,73 @@
+/*
+Zero-copy import of dma-buf frames (V4L2 decoders, cameras, other processes)
+as GL_TEXTURE_EXTERNAL_OES textures through EGL_EXT_image_dma_buf_import
+ */
+
+#ifndef _DMABUF_IMPORT_H
+#define _DMABUF_IMPORT_H
+
+#include "gles/glad.h"
+#include "dmabuf.h"
+#include "ext_set.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#define DMABUF_CACHE_SIZE 16
+
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
+#ifndef GL_OES_EGL_image
+typedef void (APIENTRYP PFNGLEGLIMAGETARGETTEXTURE2DOESPROC) (GLenum target, GLeglImageOES image);
+#endif
+
+/* An imported frame. The dma-buf inode identifies the buffer however the fd
+ * reached us (dup, SCM_RIGHTS, V4L2 re-export). The EGLImage keeps the buffer
+ * alive, so its inode cannot be recycled while the entry is cached.
+ */
+struct dmabuf_image {
+    dev_t dev;
+    ino_t ino;
+    int width, height;
+    uint32_t format;
+    uint32_t offset;            /* plane 0 offset: one buffer can hold several frames */
+    EGLImageKHR image;
+    GLuint texture;
+    unsigned int last_used;
+};
+
+struct dmabuf_importer {
+    EGLDisplay display;
+    bool modifiers_supported;
+    PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR;
+    PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES;
+    struct dmabuf_image cache[DMABUF_CACHE_SIZE];
+    unsigned int clock;
+    unsigned int imports, hits;
+};
+
+/* Needs a current context, egl_exts and gl_exts are its display's and its own
+ * extensions. Returns a negative value if they lack EGL_EXT_image_dma_buf_import
+ * or GL_OES_EGL_image_external.
+ */
+int init_dmabuf_importer(struct dmabuf_importer* importer, EGLDisplay display, const struct ext_set* egl_exts,
+    const struct ext_set* gl_exts, bool modifiers_supported);
+void destroy_dmabuf_importer(struct dmabuf_importer* importer);
+
+/* Texture (GL_TEXTURE_EXTERNAL_OES) showing the frame, 0 on failure. Frames
+ * seen before are served from the cache; the least recently used entry is
+ * dropped when it is full.
+ */
+GLuint dmabuf_import(struct dmabuf_importer* importer, const struct dmabuf_desc* desc);
+
+/* Drop the cached import of the buffer behind fd, e.g. when the producer
+ * frees or reallocates it, so its memory can be released
+ */
+void dmabuf_forget(struct dmabuf_importer* importer, int fd);
+
+#endif /* _DMABUF_IMPORT_H */
@@ -0,0 +1,171 @@
+/*
+KMS plane and property helpers shared by the render loops
+ */
+
+#include "drm_plane.h"
+#include <string.h>
+#include <libdrm/drm_fourcc.h>
+
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
+#endif
+
+uint32_t get_prop_id(int fd, uint32_t obj_id, uint32_t obj_type, const char* name) {
+    drmModeObjectProperties* props = drmModeObjectGetProperties(fd, obj_id, obj_type);
+    uint32_t prop_id = 0;
+
+    if (!props)
+        return 0;
+    for (uint32_t i = 0; i < props->count_props && !prop_id; i++) {
+        drmModePropertyRes* prop = drmModeGetProperty(fd, props->props[i]);
+
+        if (prop && strcmp(prop->name, name) == 0)
+            prop_id = prop->prop_id;
+        drmModeFreeProperty(prop);
+    }
+    drmModeFreeObjectProperties(props);
+    return prop_id;
+}
+
+bool get_prop_value(int fd, uint32_t obj_id, uint32_t obj_type, const char* name, uint64_t* value) {
+    drmModeObjectProperties* props = drmModeObjectGetProperties(fd, obj_id, obj_type);
+    bool found = false;
+
+    if (!props)
+        return false;
+    for (uint32_t i = 0; i < props->count_props && !found; i++) {
+        drmModePropertyRes* prop = drmModeGetProperty(fd, props->props[i]);
+
+        if (prop && strcmp(prop->name, name) == 0) {
+            *value = props->prop_values[i];
+            found = true;
+        }
+        drmModeFreeProperty(prop);
+    }
+    drmModeFreeObjectProperties(props);
+    return found;
+}
+
+uint32_t find_plane(int fd, uint32_t crtc_id, int crtc_index, uint64_t type) {
+    drmModePlaneRes* plane_resources = drmModeGetPlaneResources(fd);
+    uint32_t plane_id = 0;
+    bool active = false;
+
+    if (!plane_resources)
+        return 0;
+    for (uint32_t i = 0; i < plane_resources->count_planes && !active; i++) {
+        drmModePlane* plane = drmModeGetPlane(fd, plane_resources->planes[i]);
+        uint64_t plane_type;
+
+        if (plane && (plane->possible_crtcs & (1 << crtc_index)) &&
+            get_prop_value(fd, plane->plane_id, DRM_MODE_OBJECT_PLANE, "type", &plane_type) &&
+            plane_type == type) {
+            /* prefer the plane already bound to the CRTC */
+            active = plane->crtc_id == crtc_id;
+            if (active || !plane_id)
+                plane_id = plane->plane_id;
+        }
+        drmModeFreePlane(plane);
+    }
+    drmModeFreePlaneResources(plane_resources);
+    return plane_id;
+}
+
+int add_fb(int fd, uint32_t width, uint32_t height, uint32_t format, const uint32_t handles[4],
+    const uint32_t pitches[4], const uint32_t offsets[4], uint64_t modifier, uint32_t* fb_id) {
+    uint64_t modifiers[4] = { 0 };
+    uint32_t flags = 0;
+
+    /* the kernel wants the modifier repeated for every plane in use */
+    for (int i = 0; i < 4 && handles[i]; i++)
+        modifiers[i] = modifier;
+    if (modifier && modifier != DRM_FORMAT_MOD_INVALID)
+        flags = DRM_MODE_FB_MODIFIERS;
+
+    return drmModeAddFB2WithModifiers(fd, width, height, format, handles, pitches, offsets,
+        flags ? modifiers : NULL, fb_id, flags);
+}
+
+int plane_format_modifiers(int fd, uint32_t plane_id, uint32_t format, uint64_t* modifiers, int max) {
+    drmModePropertyBlobRes* blob = NULL;
+    uint64_t blob_id;
+    int count = 0;
+
+    if (get_prop_value(fd, plane_id, DRM_MODE_OBJECT_PLANE, "IN_FORMATS", &blob_id) && blob_id)
+        blob = drmModeGetPropertyBlob(fd, blob_id);
+
+    if (blob) {
+        const struct drm_format_modifier_blob* header = blob->data;
+        const uint32_t* formats = (const uint32_t*) ((const char*) header + header->formats_offset);
+        const struct drm_format_modifier* mods =
+            (const struct drm_format_modifier*) ((const char*) header + header->modifiers_offset);
+
+        for (uint32_t i = 0; i < header->count_formats; i++) {
+            if (formats[i] != format)
+                continue;
+            /* each modifier lists the formats it applies to as a 64 bit window
+             * into the format array starting at mods[j].offset
+             */
+            for (uint32_t j = 0; j < header->count_modifiers && count < max; j++) {
+                if (i >= mods[j].offset && i < mods[j].offset + 64 &&
+                    (mods[j].formats & (1ULL << (i - mods[j].offset))))
+                    modifiers[count++] = mods[j].modifier;
+            }
+            break;
+        }
+        drmModeFreePropertyBlob(blob);
+        return count;
+    }
+
+    /* no IN_FORMATS: the driver only knows the implicit layout */
+    drmModePlane* plane = drmModeGetPlane(fd, plane_id);
+    if (!plane)
+        return 0;
+    for (uint32_t i = 0; i < plane->count_formats && count < max; i++) {
+        if (plane->formats[i] == format)
+            modifiers[count++] = DRM_FORMAT_MOD_INVALID;
+    }
+    drmModeFreePlane(plane);
+    return count;
+}
+
+bool plane_supports(int fd, uint32_t plane_id, uint32_t format, uint64_t modifier) {
+    uint64_t modifiers[MAX_PLANE_MODIFIERS];
+    int count = plane_format_modifiers(fd, plane_id, format, modifiers, MAX_PLANE_MODIFIERS);
+
+    for (int i = 0; i < count; i++) {
+        if (modifier == DRM_FORMAT_MOD_INVALID || modifiers[i] == modifier)
+            return true;
+        /* implicit layout: linear is the only safe guess */
+        if (modifiers[i] == DRM_FORMAT_MOD_INVALID && modifier == DRM_FORMAT_MOD_LINEAR)
+            return true;
+    }
+    return false;
+}
+
+uint32_t find_plane_for_format(int fd, uint32_t crtc_id, int crtc_index, uint32_t format, uint64_t modifier,
+    bool allow_primary) {
+    static const uint64_t types[] = { DRM_PLANE_TYPE_OVERLAY, DRM_PLANE_TYPE_PRIMARY };
+    drmModePlaneRes* plane_resources = drmModeGetPlaneResources(fd);
+    uint32_t plane_id = 0;
+
+    if (!plane_resources)
+        return 0;
+    /* overlays first so the GL output can stay on the primary plane */
+    for (unsigned t = 0; t < (allow_primary ? 2u : 1u) && !plane_id; t++) {
+        for (uint32_t i = 0; i < plane_resources->count_planes && !plane_id; i++) {
+            drmModePlane* plane = drmModeGetPlane(fd, plane_resources->planes[i]);
+            uint64_t plane_type;
+
+            /* a plane another CRTC shows cannot move here in our commit */
+            if (plane && (plane->possible_crtcs & (1 << crtc_index)) &&
+                (plane->crtc_id == 0 || plane->crtc_id == crtc_id) &&
+                get_prop_value(fd, plane->plane_id, DRM_MODE_OBJECT_PLANE, "type", &plane_type) &&
+                plane_type == types[t] && plane_supports(fd, plane->plane_id, format, modifier))
+                plane_id = plane->plane_id;
+            drmModeFreePlane(plane);
+        }
+    }
+    drmModeFreePlaneResources(plane_resources);
+    return plane_id;
+}
@@ -0,0 +1,50 @@
+/*
+KMS plane and property helpers shared by the render loops
+ */
+
+#ifndef _DRM_PLANE_H
+#define _DRM_PLANE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xf86drmMode.h>
+
+#define MAX_PLANE_MODIFIERS 64
+
+/* Property id of name on a KMS object, 0 if the object has no such property */
+uint32_t get_prop_id(int fd, uint32_t obj_id, uint32_t obj_type, const char* name);
+
+/* Value of a property, returns false if the object has no such property */
+bool get_prop_value(int fd, uint32_t obj_id, uint32_t obj_type, const char* name, uint64_t* value);
+
+/* Plane of the given DRM_PLANE_TYPE_* usable on the CRTC, preferring the one
+ * currently bound to it; 0 if none. Needs DRM_CLIENT_CAP_UNIVERSAL_PLANES to
+ * see primary and cursor planes.
+ */
+uint32_t find_plane(int fd, uint32_t crtc_id, int crtc_index, uint64_t type);
+
+/* drmModeAddFB2WithModifiers() for a buffer of up to 4 planes (unused
+ * handles 0), passing the modifier only if it is an explicit one
+ */
+int add_fb(int fd, uint32_t width, uint32_t height, uint32_t format, const uint32_t handles[4],
+    const uint32_t pitches[4], const uint32_t offsets[4], uint64_t modifier, uint32_t* fb_id);
+
+/* Modifiers the plane can scan out format with, from its IN_FORMATS blob.
+ * Without the blob a supported format yields DRM_FORMAT_MOD_INVALID (implicit
+ * layout). Returns the number stored, at most max.
+ */
+int plane_format_modifiers(int fd, uint32_t plane_id, uint32_t format, uint64_t* modifiers, int max);
+
+/* Whether the plane can scan out format/modifier; DRM_FORMAT_MOD_INVALID
+ * accepts any layout
+ */
+bool plane_supports(int fd, uint32_t plane_id, uint32_t format, uint64_t modifier);
+
+/* A free overlay plane of the CRTC that can scan out format/modifier, else
+ * (with allow_primary) a primary plane that is free or already on this CRTC,
+ * if one can; 0 if none
+ */
+uint32_t find_plane_for_format(int fd, uint32_t crtc_id, int crtc_index, uint32_t format, uint64_t modifier,
+    bool allow_primary);
+
+#endif /* _DRM_PLANE_H */
@@ -0,0 +1,61 @@
+/*
+Extension sets
+
+Drivers report a few hundred extensions in one string of several KB; a strstr()
+per check walks most of it and has to reject names that merely start with the
+one asked for. The set copies the string once, cuts it at the spaces and sorts
+the names, about 8 strcmp() per lookup after that.
+ */
+
+#include "ext_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*) a, *(const char* const*) b);
+}
+
+int ext_set_init(struct ext_set* set, const char* extension_list) {
+    int max = 1;
+    char* name, * save;
+
+    memset(set, 0, sizeof(*set));
+    if (!extension_list || !*extension_list)
+        return 0;
+    for (const char* c = extension_list; *c; c++)
+        max += *c == ' ';
+    set->names = strdup(extension_list);
+    set->sorted = malloc(max * sizeof(set->sorted[0]));
+    if (!set->names || !set->sorted) {
+        ext_set_free(set);
+        return -1;
+    }
+    /* strtok() state is global, and the loader and capture threads may parse too */
+    for (name = strtok_r(set->names, " ", &save); name; name = strtok_r(NULL, " ", &save))
+        set->sorted[set->count++] = name;
+    qsort(set->sorted, set->count, sizeof(set->sorted[0]), compare_names);
+    return 0;
+}
+
+void ext_set_free(struct ext_set* set) {
+    free(set->names);
+    free(set->sorted);
+    memset(set, 0, sizeof(*set));
+}
+
+bool ext_set_has(const struct ext_set* set, const char* ext) {
+    int lo = 0, hi = set->count - 1;
+
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(ext, set->sorted[mid]);
+
+        if (!cmp)
+            return true;
+        if (cmp < 0)
+            hi = mid - 1;
+        else
+            lo = mid + 1;
+    }
+    return false;
+}
@@ -0,0 +1,24 @@
+/*
+Extension sets: an EGL or GL extension string split once into a sorted array,
+so every later check is a binary search instead of a scan of the whole string
+ */
+
+#ifndef _EXT_SET_H
+#define _EXT_SET_H
+
+#include <stdbool.h>
+
+struct ext_set {
+    char* names;                /* copy of the string, split in place */
+    const char** sorted;
+    int count;
+};
+
+/* Parse the space separated extension_list, NULL gives an empty set */
+int ext_set_init(struct ext_set* set, const char* extension_list);
+void ext_set_free(struct ext_set* set);
+
+/* ext is one of the set's names, a whole name, not a prefix */
+bool ext_set_has(const struct ext_set* set, const char* ext);
+
+#endif /* _EXT_SET_H */
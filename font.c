@@ -0,0 +1,544 @@
+/*
+Minimal TrueType reader
+
+Only what text drawing needs: cmap formats 4 and 12, hmtx, and glyf
+outlines including composites. Hinting, kerning and CFF outlines are out of
+scope. Outlines are flattened to line segments in pixel space; every pixel
+of the distance field then takes the distance to the nearest segment, signed
+by the nonzero winding rule. That is exact for the flattened outline and,
+at glyph cache sizes, cheaper than rasterizing at high resolution and
+running a distance transform.
+ */
+
+#include "font.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CURVE_STEPS 6
+#define MAX_COMPOSITE_DEPTH 4
+
+static uint16_t u16(const uint8_t* p) {
+    return p[0] << 8 | p[1];
+}
+
+static int16_t s16(const uint8_t* p) {
+    return (int16_t) u16(p);
+}
+
+static uint32_t u32(const uint8_t* p) {
+    return (uint32_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint32_t find_table(const struct font* font, const char* tag, uint32_t* length) {
+    int num_tables = u16(font->data + 4);
+
+    for (int i = 0; i < num_tables && 12 + (size_t) i * 16 + 16 <= font->size; i++) {
+        const uint8_t* record = font->data + 12 + i * 16;
+        uint32_t offset = u32(record + 8), size = u32(record + 12);
+
+        if (!memcmp(record, tag, 4) && offset <= font->size && size <= font->size - offset) {
+            if (length)
+                *length = size;
+            return offset;
+        }
+    }
+    return 0;
+}
+
+static int find_cmap(struct font* font, uint32_t cmap) {
+    int num_tables = u16(font->data + cmap + 2);
+    uint32_t best = 0;
+
+    for (int i = 0; i < num_tables; i++) {
+        const uint8_t* record = font->data + cmap + 4 + i * 8;
+        int platform = u16(record), encoding = u16(record + 2);
+        uint32_t offset = cmap + u32(record + 4);
+        int format;
+
+        if (offset + 4 > font->size)
+            continue;
+        format = u16(font->data + offset);
+        /* Unicode full repertoire beats BMP only */
+        if (format == 12 && (platform == 0 || (platform == 3 && encoding == 10))) {
+            font->cmap = offset;
+            font->cmap_format = 12;
+            return 0;
+        }
+        if (format == 4 && (platform == 0 || (platform == 3 && encoding == 1)) && !best)
+            best = offset;
+    }
+    if (!best)
+        return -1;
+    font->cmap = best;
+    font->cmap_format = 4;
+    return 0;
+}
+
+int font_open(struct font* font, const char* path) {
+    uint32_t head, hhea, maxp;
+    struct stat st;
+    int fd;
+
+    memset(font, 0, sizeof(*font));
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("font_open: cannot open %s\n", path);
+        return -1;
+    }
+    if (fstat(fd, &st) || st.st_size < 12) {
+        close(fd);
+        return -1;
+    }
+    font->size = st.st_size;
+    font->map = mmap(NULL, font->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (font->map == MAP_FAILED) {
+        font->map = NULL;
+        return -1;
+    }
+    font->data = font->map;
+
+    if (u32(font->data) != 0x00010000 && memcmp(font->data, "true", 4)) {
+        printf("font_open: %s is not a TrueType font\n", path);
+        goto fail;
+    }
+    head = find_table(font, "head", NULL);
+    hhea = find_table(font, "hhea", NULL);
+    maxp = find_table(font, "maxp", NULL);
+    font->cmap = find_table(font, "cmap", NULL);
+    font->loca = find_table(font, "loca", NULL);
+    font->glyf = find_table(font, "glyf", &font->glyf_size);
+    font->hmtx = find_table(font, "hmtx", NULL);
+    if (!head || !hhea || !maxp || !font->cmap || !font->loca || !font->glyf || !font->hmtx) {
+        printf("font_open: %s lacks TrueType outlines\n", path);
+        goto fail;
+    }
+    font->units_per_em = u16(font->data + head + 18);
+    font->loca_long = s16(font->data + head + 50) != 0;
+    font->ascent = s16(font->data + hhea + 4);
+    font->descent = s16(font->data + hhea + 6);
+    font->line_gap = s16(font->data + hhea + 8);
+    font->num_hmetrics = u16(font->data + hhea + 34);
+    font->num_glyphs = u16(font->data + maxp + 4);
+    if (find_cmap(font, font->cmap)) {
+        printf("font_open: %s has no Unicode character map\n", path);
+        goto fail;
+    }
+    return 0;
+
+fail:
+    font_close(font);
+    return -1;
+}
+
+void font_close(struct font* font) {
+    if (font->map)
+        munmap(font->map, font->size);
+    font->map = NULL;
+}
+
+static int valid_glyph(const struct font* font, uint32_t glyph) {
+    return glyph < (uint32_t) font->num_glyphs ? (int) glyph : 0;
+}
+
+int font_glyph_index(const struct font* font, uint32_t codepoint) {
+    const uint8_t* cmap = font->data + font->cmap;
+
+    if (font->cmap_format == 12) {
+        uint32_t groups = u32(cmap + 12);
+
+        for (uint32_t i = 0; i < groups; i++) {
+            const uint8_t* group = cmap + 16 + i * 12;
+
+            if (codepoint >= u32(group) && codepoint <= u32(group + 4))
+                return valid_glyph(font, u32(group + 8) + codepoint - u32(group));
+        }
+        return 0;
+    }
+
+    if (codepoint > 0xffff)
+        return 0;
+    int segments = u16(cmap + 6) / 2;
+    const uint8_t* ends = cmap + 14;
+    const uint8_t* starts = ends + segments * 2 + 2;
+    const uint8_t* deltas = starts + segments * 2;
+    const uint8_t* range_offsets = deltas + segments * 2;
+
+    for (int i = 0; i < segments; i++) {
+        int start = u16(starts + i * 2), range_offset = u16(range_offsets + i * 2);
+
+        if (codepoint > u16(ends + i * 2))
+            continue;
+        if (codepoint < (uint32_t) start)
+            return 0;
+        if (!range_offset)
+            return valid_glyph(font, (codepoint + u16(deltas + i * 2)) & 0xffff);
+        /* the offset is relative to its own slot in idRangeOffset */
+        int glyph = u16(range_offsets + i * 2 + range_offset + (codepoint - start) * 2);
+        return glyph ? valid_glyph(font, (glyph + u16(deltas + i * 2)) & 0xffff) : 0;
+    }
+    return 0;
+}
+
+int font_glyph_advance(const struct font* font, int glyph) {
+    int metric = glyph < font->num_hmetrics ? glyph : font->num_hmetrics - 1;
+
+    return u16(font->data + font->hmtx + metric * 4);
+}
+
+/* glyf data of glyph, NULL for blank glyphs */
+static const uint8_t* glyph_data(const struct font* font, int glyph) {
+    uint32_t start, end;
+
+    if (glyph < 0 || glyph >= font->num_glyphs)
+        return NULL;
+    if (font->loca_long) {
+        start = u32(font->data + font->loca + glyph * 4);
+        end = u32(font->data + font->loca + glyph * 4 + 4);
+    } else {
+        start = u16(font->data + font->loca + glyph * 2) * 2;
+        end = u16(font->data + font->loca + glyph * 2 + 2) * 2;
+    }
+    if (start >= end || end > font->glyf_size)
+        return NULL;
+    return font->data + font->glyf + start;
+}
+
+// ============================================================================================
+// outlines
+// ============================================================================================
+
+/* Line segments x0, y0, x1, y1 in pixels, y down */
+struct outline {
+    float* segs;
+    int count, capacity;
+    float m[6];                 /* font units to pixels: x' = m0 x + m2 y + m4, y' = m1 x + m3 y + m5 */
+};
+
+static void add_line(struct outline* o, float x0, float y0, float x1, float y1) {
+    if (o->count == o->capacity) {
+        int capacity = o->capacity ? o->capacity * 2 : 256;
+        float* segs = realloc(o->segs, capacity * 4 * sizeof(float));
+
+        if (!segs)
+            return;
+        o->segs = segs;
+        o->capacity = capacity;
+    }
+    o->segs[o->count * 4 + 0] = x0;
+    o->segs[o->count * 4 + 1] = y0;
+    o->segs[o->count * 4 + 2] = x1;
+    o->segs[o->count * 4 + 3] = y1;
+    o->count++;
+}
+
+static void add_point(struct outline* o, const float t[6], float x, float y, float* px, float* py) {
+    float tx = t[0] * x + t[2] * y + t[4], ty = t[1] * x + t[3] * y + t[5];
+
+    *px = o->m[0] * tx + o->m[2] * ty + o->m[4];
+    *py = o->m[1] * tx + o->m[3] * ty + o->m[5];
+}
+
+static void add_curve(struct outline* o, const float t[6], float x0, float y0, float cx, float cy, float x1, float y1) {
+    float px, py, qx, qy;
+
+    add_point(o, t, x0, y0, &px, &py);
+    for (int i = 1; i <= CURVE_STEPS; i++) {
+        float s = (float) i / CURVE_STEPS, r = 1.0f - s;
+
+        add_point(o, t, r * r * x0 + 2 * r * s * cx + s * s * x1, r * r * y0 + 2 * r * s * cy + s * s * y1, &qx, &qy);
+        add_line(o, px, py, qx, qy);
+        px = qx;
+        py = qy;
+    }
+}
+
+static void add_contour(struct outline* o, const float t[6], const int16_t* xs, const int16_t* ys,
+    const uint8_t* flags, int n) {
+    int first = 0;
+    float sx, sy, x, y;
+
+    if (n < 2)
+        return;
+    /* start on an on-curve point, or between two off-curve ones */
+    while (first < n && !(flags[first] & 1))
+        first++;
+    if (first == n) {
+        sx = (xs[0] + xs[1]) / 2.0f;
+        sy = (ys[0] + ys[1]) / 2.0f;
+        first = 0;
+    } else {
+        sx = xs[first];
+        sy = ys[first];
+    }
+    x = sx;
+    y = sy;
+
+    for (int k = 1; k <= n; k++) {
+        int i = (first + k) % n;
+
+        if (flags[i] & 1) {
+            float px, py, qx, qy;
+
+            add_point(o, t, x, y, &px, &py);
+            add_point(o, t, xs[i], ys[i], &qx, &qy);
+            add_line(o, px, py, qx, qy);
+            x = xs[i];
+            y = ys[i];
+        } else {
+            int j = (i + 1) % n;
+            float ex, ey;
+
+            /* two off-curve points in a row imply the on-curve point between them */
+            if (k == n) {
+                ex = sx;
+                ey = sy;
+            } else if (flags[j] & 1) {
+                ex = xs[j];
+                ey = ys[j];
+                k++;
+            } else {
+                ex = (xs[i] + xs[j]) / 2.0f;
+                ey = (ys[i] + ys[j]) / 2.0f;
+            }
+            add_curve(o, t, x, y, xs[i], ys[i], ex, ey);
+            x = ex;
+            y = ey;
+        }
+    }
+    if (x != sx || y != sy) {
+        float px, py, qx, qy;
+
+        add_point(o, t, x, y, &px, &py);
+        add_point(o, t, sx, sy, &qx, &qy);
+        add_line(o, px, py, qx, qy);
+    }
+}
+
+static int decode_simple(struct outline* o, const float t[6], const uint8_t* p, const uint8_t* end, int contours) {
+    const uint8_t* ends = p + 10;
+    int num_points, instructions;
+    int16_t* xs;
+    int16_t* ys;
+    uint8_t* flags;
+    int16_t value = 0;
+
+    if (ends + contours * 2 + 2 > end)
+        return -1;
+    num_points = u16(ends + (contours - 1) * 2) + 1;
+    instructions = u16(ends + contours * 2);
+    p = ends + contours * 2 + 2 + instructions;
+
+    xs = malloc(num_points * (2 * sizeof(int16_t) + 1));
+    if (!xs)
+        return -1;
+    ys = xs + num_points;
+    flags = (uint8_t*) (ys + num_points);
+
+    for (int i = 0; i < num_points;) {
+        uint8_t flag, repeat = 0;
+
+        if (p >= end)
+            goto fail;
+        flag = *p++;
+        if (flag & 8) {
+            if (p >= end)
+                goto fail;
+            repeat = *p++;
+        }
+        for (int r = 0; r <= repeat && i < num_points; r++)
+            flags[i++] = flag;
+    }
+    /* x: short (1 byte, sign in bit 4), same as before (bit 4) or 2 byte delta */
+    for (int i = 0; i < num_points; i++) {
+        if (flags[i] & 2) {
+            if (p >= end)
+                goto fail;
+            value += flags[i] & 16 ? *p : -*p;
+            p++;
+        } else if (!(flags[i] & 16)) {
+            if (p + 2 > end)
+                goto fail;
+            value += s16(p);
+            p += 2;
+        }
+        xs[i] = value;
+    }
+    value = 0;
+    for (int i = 0; i < num_points; i++) {
+        if (flags[i] & 4) {
+            if (p >= end)
+                goto fail;
+            value += flags[i] & 32 ? *p : -*p;
+            p++;
+        } else if (!(flags[i] & 32)) {
+            if (p + 2 > end)
+                goto fail;
+            value += s16(p);
+            p += 2;
+        }
+        ys[i] = value;
+    }
+
+    for (int c = 0, start = 0; c < contours; c++) {
+        int last = u16(ends + c * 2);
+
+        if (last >= num_points || last < start)
+            break;
+        add_contour(o, t, xs + start, ys + start, flags + start, last - start + 1);
+        start = last + 1;
+    }
+    free(xs);
+    return 0;
+
+fail:
+    free(xs);
+    return -1;
+}
+
+static int decode_glyph(const struct font* font, struct outline* o, int glyph, const float t[6], int depth) {
+    const uint8_t* p = glyph_data(font, glyph);
+    const uint8_t* end = font->data + font->glyf + font->glyf_size;
+    int contours;
+    uint16_t flags;
+
+    if (!p)
+        return 0;
+    contours = s16(p);
+    if (contours > 0)
+        return decode_simple(o, t, p, end, contours);
+    if (contours == 0 || depth >= MAX_COMPOSITE_DEPTH)
+        return 0;
+
+    /* composite: transformed references to other glyphs */
+    p += 10;
+    do {
+        float c[6] = { 1, 0, 0, 1, 0, 0 }, m[6];
+        int component;
+
+        if (p + 4 > end)
+            return -1;
+        flags = u16(p);
+        component = u16(p + 2);
+        p += 4;
+        if (flags & 1) {
+            c[4] = s16(p);
+            c[5] = s16(p + 2);
+            p += 4;
+        } else {
+            c[4] = (int8_t) p[0];
+            c[5] = (int8_t) p[1];
+            p += 2;
+        }
+        /* point matching placement is not supported: no offset */
+        if (!(flags & 2))
+            c[4] = c[5] = 0;
+        if (flags & 8) {
+            c[0] = c[3] = s16(p) / 16384.0f;
+            p += 2;
+        } else if (flags & 0x40) {
+            c[0] = s16(p) / 16384.0f;
+            c[3] = s16(p + 2) / 16384.0f;
+            p += 4;
+        } else if (flags & 0x80) {
+            c[0] = s16(p) / 16384.0f;
+            c[1] = s16(p + 2) / 16384.0f;
+            c[2] = s16(p + 4) / 16384.0f;
+            c[3] = s16(p + 6) / 16384.0f;
+            p += 8;
+        }
+        /* the component transform applies first, then ours */
+        m[0] = t[0] * c[0] + t[2] * c[1];
+        m[1] = t[1] * c[0] + t[3] * c[1];
+        m[2] = t[0] * c[2] + t[2] * c[3];
+        m[3] = t[1] * c[2] + t[3] * c[3];
+        m[4] = t[0] * c[4] + t[2] * c[5] + t[4];
+        m[5] = t[1] * c[4] + t[3] * c[5] + t[5];
+        if (decode_glyph(font, o, component, m, depth + 1))
+            return -1;
+    } while (flags & 0x20);
+    return 0;
+}
+
+// ============================================================================================
+// distance field
+// ============================================================================================
+
+static float segment_distance2(const float* s, float x, float y) {
+    float dx = s[2] - s[0], dy = s[3] - s[1];
+    float len2 = dx * dx + dy * dy;
+    float t = len2 > 0 ? ((x - s[0]) * dx + (y - s[1]) * dy) / len2 : 0;
+    float ex, ey;
+
+    t = t < 0 ? 0 : t > 1 ? 1 : t;
+    ex = s[0] + t * dx - x;
+    ey = s[1] + t * dy - y;
+    return ex * ex + ey * ey;
+}
+
+int font_glyph_sdf(const struct font* font, int glyph, float scale, int spread, uint8_t* out, int max_size,
+    struct font_glyph* metrics) {
+    static const float identity[6] = { 1, 0, 0, 1, 0, 0 };
+    const uint8_t* p = glyph_data(font, glyph);
+    struct outline o = { 0 };
+    float x_min, y_max;
+
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->advance = font_glyph_advance(font, glyph) * scale;
+    if (!p)
+        return 0;
+
+    x_min = floorf(s16(p + 2) * scale) - spread;
+    y_max = ceilf(s16(p + 8) * scale) + spread;
+    metrics->width = (int) ceilf(s16(p + 6) * scale) + spread - (int) x_min;
+    metrics->height = (int) y_max - (int) floorf(s16(p + 4) * scale) + spread;
+    metrics->left = x_min;
+    metrics->top = y_max;
+    if (metrics->width > max_size || metrics->height > max_size)
+        return -1;
+
+    /* font units, y up, to bitmap pixels, y down */
+    o.m[0] = scale;
+    o.m[3] = -scale;
+    o.m[4] = -x_min;
+    o.m[5] = y_max;
+    if (decode_glyph(font, &o, glyph, identity, 0)) {
+        free(o.segs);
+        return -1;
+    }
+
+    for (int y = 0; y < metrics->height; y++) {
+        float py = y + 0.5f;
+
+        for (int x = 0; x < metrics->width; x++) {
+            float px = x + 0.5f, best = 1e30f, d;
+            int winding = 0;
+
+            for (int i = 0; i < o.count; i++) {
+                const float* s = &o.segs[i * 4];
+                float d2 = segment_distance2(s, px, py);
+
+                if (d2 < best)
+                    best = d2;
+                /* nonzero rule: signed crossings of a ray towards +x */
+                if ((s[1] <= py) != (s[3] <= py)) {
+                    float cross = s[0] + (py - s[1]) * (s[2] - s[0]) / (s[3] - s[1]);
+
+                    if (cross > px)
+                        winding += s[3] > s[1] ? 1 : -1;
+                }
+            }
+            d = sqrtf(best) * (winding ? 1.0f : -1.0f);
+            d = 128.0f + d * 127.0f / spread;
+            out[y * metrics->width + x] = d < 0 ? 0 : d > 255 ? 255 : (uint8_t) d;
+        }
+    }
+    free(o.segs);
+    return 0;
+}
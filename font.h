@@ -0,0 +1,53 @@
+/*
+Minimal TrueType reader: character map, horizontal metrics and glyph
+outlines (simple and composite), rendered straight into signed distance
+fields for GPU text
+ */
+
+#ifndef _FONT_H
+#define _FONT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FONT_DEFAULT_PATH "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"
+
+struct font {
+    void* map;
+    size_t size;
+    const uint8_t* data;
+    uint32_t cmap, glyf, loca, hmtx;    /* table offsets */
+    uint32_t glyf_size;
+    int cmap_format;                    /* 4 or 12 */
+    int units_per_em;
+    int num_glyphs, num_hmetrics;
+    bool loca_long;
+    int ascent, descent, line_gap;      /* font units */
+};
+
+/* One glyph of an SDF, in pixels at the requested scale */
+struct font_glyph {
+    int width, height;          /* bitmap size, 0 for blank glyphs */
+    float left, top;            /* bitmap corner relative to the pen on the baseline, y up */
+    float advance;
+};
+
+int font_open(struct font* font, const char* path);
+void font_close(struct font* font);
+
+/* Glyph index of a Unicode code point, 0 (.notdef) if missing */
+int font_glyph_index(const struct font* font, uint32_t codepoint);
+
+/* Horizontal advance in font units */
+int font_glyph_advance(const struct font* font, int glyph);
+
+/* Render glyph into out (up to max_size x max_size bytes, rows top-down) as a
+ * distance field: 128 on the outline, rising inside, falling outside, with
+ * spread pixels mapped to the full 0..255 range. scale is pixels per font
+ * unit. Returns -1 if the glyph does not fit.
+ */
+int font_glyph_sdf(const struct font* font, int glyph, float scale, int spread, uint8_t* out, int max_size,
+    struct font_glyph* metrics);
+
+#endif /* _FONT_H */
@@ -849,3 +849,389 @@ int gladLoadGLES2Loader(GLADloadproc load) {
 	return GLVersion.major != 0 || GLVersion.minor != 0;
 }
 
+/*
+ * Lazy loading: every pointer starts at a trampoline that looks its function up
+ * on the first call, replaces itself with it and forwards the call. Startup then
+ * costs no eglGetProcAddress() string lookups for the entry points a program
+ * never calls. The list mirrors the load_GL_ES_VERSION_* functions, sorted by
+ * name for the preload search. A function the driver lacks aborts on its first
+ * call instead of leaving a NULL pointer behind.
+ */
+#define GLAD_LAZY_FUNCTIONS(R, V) \
+    V(PFNGLACTIVESHADERPROGRAMPROC, glActiveShaderProgram, (GLuint pipeline, GLuint program), (pipeline, program)) \
+    V(PFNGLACTIVETEXTUREPROC, glActiveTexture, (GLenum texture), (texture)) \
+    V(PFNGLATTACHSHADERPROC, glAttachShader, (GLuint program, GLuint shader), (program, shader)) \
+    V(PFNGLBEGINQUERYPROC, glBeginQuery, (GLenum target, GLuint id), (target, id)) \
+    V(PFNGLBEGINTRANSFORMFEEDBACKPROC, glBeginTransformFeedback, (GLenum primitiveMode), (primitiveMode)) \
+    V(PFNGLBINDATTRIBLOCATIONPROC, glBindAttribLocation, (GLuint program, GLuint index, const GLchar *name), (program, index, name)) \
+    V(PFNGLBINDBUFFERPROC, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+    V(PFNGLBINDBUFFERBASEPROC, glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+    V(PFNGLBINDBUFFERRANGEPROC, glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size)) \
+    V(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+    V(PFNGLBINDIMAGETEXTUREPROC, glBindImageTexture, (GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format), (unit, texture, level, layered, layer, access, format)) \
+    V(PFNGLBINDPROGRAMPIPELINEPROC, glBindProgramPipeline, (GLuint pipeline), (pipeline)) \
+    V(PFNGLBINDRENDERBUFFERPROC, glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer)) \
+    V(PFNGLBINDSAMPLERPROC, glBindSampler, (GLuint unit, GLuint sampler), (unit, sampler)) \
+    V(PFNGLBINDTEXTUREPROC, glBindTexture, (GLenum target, GLuint texture), (target, texture)) \
+    V(PFNGLBINDTRANSFORMFEEDBACKPROC, glBindTransformFeedback, (GLenum target, GLuint id), (target, id)) \
+    V(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray, (GLuint array), (array)) \
+    V(PFNGLBINDVERTEXBUFFERPROC, glBindVertexBuffer, (GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride), (bindingindex, buffer, offset, stride)) \
+    V(PFNGLBLENDCOLORPROC, glBlendColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+    V(PFNGLBLENDEQUATIONPROC, glBlendEquation, (GLenum mode), (mode)) \
+    V(PFNGLBLENDEQUATIONSEPARATEPROC, glBlendEquationSeparate, (GLenum modeRGB, GLenum modeAlpha), (modeRGB, modeAlpha)) \
+    V(PFNGLBLENDFUNCPROC, glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+    V(PFNGLBLENDFUNCSEPARATEPROC, glBlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha)) \
+    V(PFNGLBLITFRAMEBUFFERPROC, glBlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter)) \
+    V(PFNGLBUFFERDATAPROC, glBufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), (target, size, data, usage)) \
+    V(PFNGLBUFFERSUBDATAPROC, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data), (target, offset, size, data)) \
+    R(GLenum, PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus, (GLenum target), (target)) \
+    V(PFNGLCLEARPROC, glClear, (GLbitfield mask), (mask)) \
+    V(PFNGLCLEARBUFFERFIPROC, glClearBufferfi, (GLenum buffer, GLint drawbuffer, GLfloat depth, GLint stencil), (buffer, drawbuffer, depth, stencil)) \
+    V(PFNGLCLEARBUFFERFVPROC, glClearBufferfv, (GLenum buffer, GLint drawbuffer, const GLfloat *value), (buffer, drawbuffer, value)) \
+    V(PFNGLCLEARBUFFERIVPROC, glClearBufferiv, (GLenum buffer, GLint drawbuffer, const GLint *value), (buffer, drawbuffer, value)) \
+    V(PFNGLCLEARBUFFERUIVPROC, glClearBufferuiv, (GLenum buffer, GLint drawbuffer, const GLuint *value), (buffer, drawbuffer, value)) \
+    V(PFNGLCLEARCOLORPROC, glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+    V(PFNGLCLEARDEPTHFPROC, glClearDepthf, (GLfloat d), (d)) \
+    V(PFNGLCLEARSTENCILPROC, glClearStencil, (GLint s), (s)) \
+    R(GLenum, PFNGLCLIENTWAITSYNCPROC, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout)) \
+    V(PFNGLCOLORMASKPROC, glColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha)) \
+    V(PFNGLCOMPILESHADERPROC, glCompileShader, (GLuint shader), (shader)) \
+    V(PFNGLCOMPRESSEDTEXIMAGE2DPROC, glCompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data), (target, level, internalformat, width, height, border, imageSize, data)) \
+    V(PFNGLCOMPRESSEDTEXIMAGE3DPROC, glCompressedTexImage3D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei imageSize, const void *data), (target, level, internalformat, width, height, depth, border, imageSize, data)) \
+    V(PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC, glCompressedTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data), (target, level, xoffset, yoffset, width, height, format, imageSize, data)) \
+    V(PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC, glCompressedTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei imageSize, const void *data), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, imageSize, data)) \
+    V(PFNGLCOPYBUFFERSUBDATAPROC, glCopyBufferSubData, (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size), (readTarget, writeTarget, readOffset, writeOffset, size)) \
+    V(PFNGLCOPYTEXIMAGE2DPROC, glCopyTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border), (target, level, internalformat, x, y, width, height, border)) \
+    V(PFNGLCOPYTEXSUBIMAGE2DPROC, glCopyTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height), (target, level, xoffset, yoffset, x, y, width, height)) \
+    V(PFNGLCOPYTEXSUBIMAGE3DPROC, glCopyTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLint x, GLint y, GLsizei width, GLsizei height), (target, level, xoffset, yoffset, zoffset, x, y, width, height)) \
+    R(GLuint, PFNGLCREATEPROGRAMPROC, glCreateProgram, (void), ()) \
+    R(GLuint, PFNGLCREATESHADERPROC, glCreateShader, (GLenum type), (type)) \
+    R(GLuint, PFNGLCREATESHADERPROGRAMVPROC, glCreateShaderProgramv, (GLenum type, GLsizei count, const GLchar *const*strings), (type, count, strings)) \
+    V(PFNGLCULLFACEPROC, glCullFace, (GLenum mode), (mode)) \
+    V(PFNGLDELETEBUFFERSPROC, glDeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers)) \
+    V(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers, (GLsizei n, const GLuint *framebuffers), (n, framebuffers)) \
+    V(PFNGLDELETEPROGRAMPROC, glDeleteProgram, (GLuint program), (program)) \
+    V(PFNGLDELETEPROGRAMPIPELINESPROC, glDeleteProgramPipelines, (GLsizei n, const GLuint *pipelines), (n, pipelines)) \
+    V(PFNGLDELETEQUERIESPROC, glDeleteQueries, (GLsizei n, const GLuint *ids), (n, ids)) \
+    V(PFNGLDELETERENDERBUFFERSPROC, glDeleteRenderbuffers, (GLsizei n, const GLuint *renderbuffers), (n, renderbuffers)) \
+    V(PFNGLDELETESAMPLERSPROC, glDeleteSamplers, (GLsizei count, const GLuint *samplers), (count, samplers)) \
+    V(PFNGLDELETESHADERPROC, glDeleteShader, (GLuint shader), (shader)) \
+    V(PFNGLDELETESYNCPROC, glDeleteSync, (GLsync sync), (sync)) \
+    V(PFNGLDELETETEXTURESPROC, glDeleteTextures, (GLsizei n, const GLuint *textures), (n, textures)) \
+    V(PFNGLDELETETRANSFORMFEEDBACKSPROC, glDeleteTransformFeedbacks, (GLsizei n, const GLuint *ids), (n, ids)) \
+    V(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays)) \
+    V(PFNGLDEPTHFUNCPROC, glDepthFunc, (GLenum func), (func)) \
+    V(PFNGLDEPTHMASKPROC, glDepthMask, (GLboolean flag), (flag)) \
+    V(PFNGLDEPTHRANGEFPROC, glDepthRangef, (GLfloat n, GLfloat f), (n, f)) \
+    V(PFNGLDETACHSHADERPROC, glDetachShader, (GLuint program, GLuint shader), (program, shader)) \
+    V(PFNGLDISABLEPROC, glDisable, (GLenum cap), (cap)) \
+    V(PFNGLDISABLEVERTEXATTRIBARRAYPROC, glDisableVertexAttribArray, (GLuint index), (index)) \
+    V(PFNGLDISPATCHCOMPUTEPROC, glDispatchCompute, (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z), (num_groups_x, num_groups_y, num_groups_z)) \
+    V(PFNGLDISPATCHCOMPUTEINDIRECTPROC, glDispatchComputeIndirect, (GLintptr indirect), (indirect)) \
+    V(PFNGLDRAWARRAYSPROC, glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+    V(PFNGLDRAWARRAYSINDIRECTPROC, glDrawArraysIndirect, (GLenum mode, const void *indirect), (mode, indirect)) \
+    V(PFNGLDRAWARRAYSINSTANCEDPROC, glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount), (mode, first, count, instancecount)) \
+    V(PFNGLDRAWBUFFERSPROC, glDrawBuffers, (GLsizei n, const GLenum *bufs), (n, bufs)) \
+    V(PFNGLDRAWELEMENTSPROC, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices)) \
+    V(PFNGLDRAWELEMENTSINDIRECTPROC, glDrawElementsIndirect, (GLenum mode, GLenum type, const void *indirect), (mode, type, indirect)) \
+    V(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount), (mode, count, type, indices, instancecount)) \
+    V(PFNGLDRAWRANGEELEMENTSPROC, glDrawRangeElements, (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void *indices), (mode, start, end, count, type, indices)) \
+    V(PFNGLENABLEPROC, glEnable, (GLenum cap), (cap)) \
+    V(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray, (GLuint index), (index)) \
+    V(PFNGLENDQUERYPROC, glEndQuery, (GLenum target), (target)) \
+    V(PFNGLENDTRANSFORMFEEDBACKPROC, glEndTransformFeedback, (void), ()) \
+    R(GLsync, PFNGLFENCESYNCPROC, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+    V(PFNGLFINISHPROC, glFinish, (void), ()) \
+    V(PFNGLFLUSHPROC, glFlush, (void), ()) \
+    V(PFNGLFLUSHMAPPEDBUFFERRANGEPROC, glFlushMappedBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length), (target, offset, length)) \
+    V(PFNGLFRAMEBUFFERPARAMETERIPROC, glFramebufferParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+    V(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer)) \
+    V(PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level)) \
+    V(PFNGLFRAMEBUFFERTEXTURELAYERPROC, glFramebufferTextureLayer, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer), (target, attachment, texture, level, layer)) \
+    V(PFNGLFRONTFACEPROC, glFrontFace, (GLenum mode), (mode)) \
+    V(PFNGLGENBUFFERSPROC, glGenBuffers, (GLsizei n, GLuint *buffers), (n, buffers)) \
+    V(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers)) \
+    V(PFNGLGENPROGRAMPIPELINESPROC, glGenProgramPipelines, (GLsizei n, GLuint *pipelines), (n, pipelines)) \
+    V(PFNGLGENQUERIESPROC, glGenQueries, (GLsizei n, GLuint *ids), (n, ids)) \
+    V(PFNGLGENRENDERBUFFERSPROC, glGenRenderbuffers, (GLsizei n, GLuint *renderbuffers), (n, renderbuffers)) \
+    V(PFNGLGENSAMPLERSPROC, glGenSamplers, (GLsizei count, GLuint *samplers), (count, samplers)) \
+    V(PFNGLGENTEXTURESPROC, glGenTextures, (GLsizei n, GLuint *textures), (n, textures)) \
+    V(PFNGLGENTRANSFORMFEEDBACKSPROC, glGenTransformFeedbacks, (GLsizei n, GLuint *ids), (n, ids)) \
+    V(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays)) \
+    V(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap, (GLenum target), (target)) \
+    V(PFNGLGETACTIVEATTRIBPROC, glGetActiveAttrib, (GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name), (program, index, bufSize, length, size, type, name)) \
+    V(PFNGLGETACTIVEUNIFORMPROC, glGetActiveUniform, (GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name), (program, index, bufSize, length, size, type, name)) \
+    V(PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC, glGetActiveUniformBlockName, (GLuint program, GLuint uniformBlockIndex, GLsizei bufSize, GLsizei *length, GLchar *uniformBlockName), (program, uniformBlockIndex, bufSize, length, uniformBlockName)) \
+    V(PFNGLGETACTIVEUNIFORMBLOCKIVPROC, glGetActiveUniformBlockiv, (GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params), (program, uniformBlockIndex, pname, params)) \
+    V(PFNGLGETACTIVEUNIFORMSIVPROC, glGetActiveUniformsiv, (GLuint program, GLsizei uniformCount, const GLuint *uniformIndices, GLenum pname, GLint *params), (program, uniformCount, uniformIndices, pname, params)) \
+    V(PFNGLGETATTACHEDSHADERSPROC, glGetAttachedShaders, (GLuint program, GLsizei maxCount, GLsizei *count, GLuint *shaders), (program, maxCount, count, shaders)) \
+    R(GLint, PFNGLGETATTRIBLOCATIONPROC, glGetAttribLocation, (GLuint program, const GLchar *name), (program, name)) \
+    V(PFNGLGETBOOLEANI_VPROC, glGetBooleani_v, (GLenum target, GLuint index, GLboolean *data), (target, index, data)) \
+    V(PFNGLGETBOOLEANVPROC, glGetBooleanv, (GLenum pname, GLboolean *data), (pname, data)) \
+    V(PFNGLGETBUFFERPARAMETERI64VPROC, glGetBufferParameteri64v, (GLenum target, GLenum pname, GLint64 *params), (target, pname, params)) \
+    V(PFNGLGETBUFFERPARAMETERIVPROC, glGetBufferParameteriv, (GLenum target, GLenum pname, GLint *params), (target, pname, params)) \
+    V(PFNGLGETBUFFERPOINTERVPROC, glGetBufferPointerv, (GLenum target, GLenum pname, void **params), (target, pname, params)) \
+    V(PFNGLGETFLOATVPROC, glGetFloatv, (GLenum pname, GLfloat *data), (pname, data)) \
+    R(GLint, PFNGLGETFRAGDATALOCATIONPROC, glGetFragDataLocation, (GLuint program, const GLchar *name), (program, name)) \
+    V(PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC, glGetFramebufferAttachmentParameteriv, (GLenum target, GLenum attachment, GLenum pname, GLint *params), (target, attachment, pname, params)) \
+    V(PFNGLGETFRAMEBUFFERPARAMETERIVPROC, glGetFramebufferParameteriv, (GLenum target, GLenum pname, GLint *params), (target, pname, params)) \
+    V(PFNGLGETINTEGER64I_VPROC, glGetInteger64i_v, (GLenum target, GLuint index, GLint64 *data), (target, index, data)) \
+    V(PFNGLGETINTEGER64VPROC, glGetInteger64v, (GLenum pname, GLint64 *data), (pname, data)) \
+    V(PFNGLGETINTEGERI_VPROC, glGetIntegeri_v, (GLenum target, GLuint index, GLint *data), (target, index, data)) \
+    V(PFNGLGETINTEGERVPROC, glGetIntegerv, (GLenum pname, GLint *data), (pname, data)) \
+    V(PFNGLGETINTERNALFORMATIVPROC, glGetInternalformativ, (GLenum target, GLenum internalformat, GLenum pname, GLsizei count, GLint *params), (target, internalformat, pname, count, params)) \
+    V(PFNGLGETMULTISAMPLEFVPROC, glGetMultisamplefv, (GLenum pname, GLuint index, GLfloat *val), (pname, index, val)) \
+    V(PFNGLGETPROGRAMBINARYPROC, glGetProgramBinary, (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary), (program, bufSize, length, binaryFormat, binary)) \
+    V(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (program, bufSize, length, infoLog)) \
+    V(PFNGLGETPROGRAMINTERFACEIVPROC, glGetProgramInterfaceiv, (GLuint program, GLenum programInterface, GLenum pname, GLint *params), (program, programInterface, pname, params)) \
+    V(PFNGLGETPROGRAMPIPELINEINFOLOGPROC, glGetProgramPipelineInfoLog, (GLuint pipeline, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (pipeline, bufSize, length, infoLog)) \
+    V(PFNGLGETPROGRAMPIPELINEIVPROC, glGetProgramPipelineiv, (GLuint pipeline, GLenum pname, GLint *params), (pipeline, pname, params)) \
+    R(GLuint, PFNGLGETPROGRAMRESOURCEINDEXPROC, glGetProgramResourceIndex, (GLuint program, GLenum programInterface, const GLchar *name), (program, programInterface, name)) \
+    R(GLint, PFNGLGETPROGRAMRESOURCELOCATIONPROC, glGetProgramResourceLocation, (GLuint program, GLenum programInterface, const GLchar *name), (program, programInterface, name)) \
+    V(PFNGLGETPROGRAMRESOURCENAMEPROC, glGetProgramResourceName, (GLuint program, GLenum programInterface, GLuint index, GLsizei bufSize, GLsizei *length, GLchar *name), (program, programInterface, index, bufSize, length, name)) \
+    V(PFNGLGETPROGRAMRESOURCEIVPROC, glGetProgramResourceiv, (GLuint program, GLenum programInterface, GLuint index, GLsizei propCount, const GLenum *props, GLsizei count, GLsizei *length, GLint *params), (program, programInterface, index, propCount, props, count, length, params)) \
+    V(PFNGLGETPROGRAMIVPROC, glGetProgramiv, (GLuint program, GLenum pname, GLint *params), (program, pname, params)) \
+    V(PFNGLGETQUERYOBJECTUIVPROC, glGetQueryObjectuiv, (GLuint id, GLenum pname, GLuint *params), (id, pname, params)) \
+    V(PFNGLGETQUERYIVPROC, glGetQueryiv, (GLenum target, GLenum pname, GLint *params), (target, pname, params)) \
+    V(PFNGLGETRENDERBUFFERPARAMETERIVPROC, glGetRenderbufferParameteriv, (GLenum target, GLenum pname, GLint *params), (target, pname, params)) \
+    V(PFNGLGETSAMPLERPARAMETERFVPROC, glGetSamplerParameterfv, (GLuint sampler, GLenum pname, GLfloat *params), (sampler, pname, params)) \
+    V(PFNGLGETSAMPLERPARAMETERIVPROC, glGetSamplerParameteriv, (GLuint sampler, GLenum pname, GLint *params), (sampler, pname, params)) \
+    V(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (shader, bufSize, length, infoLog)) \
+    V(PFNGLGETSHADERPRECISIONFORMATPROC, glGetShaderPrecisionFormat, (GLenum shadertype, GLenum precisiontype, GLint *range, GLint *precision), (shadertype, precisiontype, range, precision)) \
+    V(PFNGLGETSHADERSOURCEPROC, glGetShaderSource, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *source), (shader, bufSize, length, source)) \
+    V(PFNGLGETSHADERIVPROC, glGetShaderiv, (GLuint shader, GLenum pname, GLint *params), (shader, pname, params)) \
+    R(const GLubyte *, PFNGLGETSTRINGIPROC, glGetStringi, (GLenum name, GLuint index), (name, index)) \
+    V(PFNGLGETSYNCIVPROC, glGetSynciv, (GLsync sync, GLenum pname, GLsizei count, GLsizei *length, GLint *values), (sync, pname, count, length, values)) \
+    V(PFNGLGETTEXLEVELPARAMETERFVPROC, glGetTexLevelParameterfv, (GLenum target, GLint level, GLenum pname, GLfloat *params), (target, level, pname, params)) \
+    V(PFNGLGETTEXLEVELPARAMETERIVPROC, glGetTexLevelParameteriv, (GLenum target, GLint level, GLenum pname, GLint *params), (target, level, pname, params)) \
+    V(PFNGLGETTEXPARAMETERFVPROC, glGetTexParameterfv, (GLenum target, GLenum pname, GLfloat *params), (target, pname, params)) \
+    V(PFNGLGETTEXPARAMETERIVPROC, glGetTexParameteriv, (GLenum target, GLenum pname, GLint *params), (target, pname, params)) \
+    V(PFNGLGETTRANSFORMFEEDBACKVARYINGPROC, glGetTransformFeedbackVarying, (GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLsizei *size, GLenum *type, GLchar *name), (program, index, bufSize, length, size, type, name)) \
+    R(GLuint, PFNGLGETUNIFORMBLOCKINDEXPROC, glGetUniformBlockIndex, (GLuint program, const GLchar *uniformBlockName), (program, uniformBlockName)) \
+    V(PFNGLGETUNIFORMINDICESPROC, glGetUniformIndices, (GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames, GLuint *uniformIndices), (program, uniformCount, uniformNames, uniformIndices)) \
+    R(GLint, PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation, (GLuint program, const GLchar *name), (program, name)) \
+    V(PFNGLGETUNIFORMFVPROC, glGetUniformfv, (GLuint program, GLint location, GLfloat *params), (program, location, params)) \
+    V(PFNGLGETUNIFORMIVPROC, glGetUniformiv, (GLuint program, GLint location, GLint *params), (program, location, params)) \
+    V(PFNGLGETUNIFORMUIVPROC, glGetUniformuiv, (GLuint program, GLint location, GLuint *params), (program, location, params)) \
+    V(PFNGLGETVERTEXATTRIBIIVPROC, glGetVertexAttribIiv, (GLuint index, GLenum pname, GLint *params), (index, pname, params)) \
+    V(PFNGLGETVERTEXATTRIBIUIVPROC, glGetVertexAttribIuiv, (GLuint index, GLenum pname, GLuint *params), (index, pname, params)) \
+    V(PFNGLGETVERTEXATTRIBPOINTERVPROC, glGetVertexAttribPointerv, (GLuint index, GLenum pname, void **pointer), (index, pname, pointer)) \
+    V(PFNGLGETVERTEXATTRIBFVPROC, glGetVertexAttribfv, (GLuint index, GLenum pname, GLfloat *params), (index, pname, params)) \
+    V(PFNGLGETVERTEXATTRIBIVPROC, glGetVertexAttribiv, (GLuint index, GLenum pname, GLint *params), (index, pname, params)) \
+    V(PFNGLHINTPROC, glHint, (GLenum target, GLenum mode), (target, mode)) \
+    V(PFNGLINVALIDATEFRAMEBUFFERPROC, glInvalidateFramebuffer, (GLenum target, GLsizei numAttachments, const GLenum *attachments), (target, numAttachments, attachments)) \
+    V(PFNGLINVALIDATESUBFRAMEBUFFERPROC, glInvalidateSubFramebuffer, (GLenum target, GLsizei numAttachments, const GLenum *attachments, GLint x, GLint y, GLsizei width, GLsizei height), (target, numAttachments, attachments, x, y, width, height)) \
+    R(GLboolean, PFNGLISBUFFERPROC, glIsBuffer, (GLuint buffer), (buffer)) \
+    R(GLboolean, PFNGLISENABLEDPROC, glIsEnabled, (GLenum cap), (cap)) \
+    R(GLboolean, PFNGLISFRAMEBUFFERPROC, glIsFramebuffer, (GLuint framebuffer), (framebuffer)) \
+    R(GLboolean, PFNGLISPROGRAMPROC, glIsProgram, (GLuint program), (program)) \
+    R(GLboolean, PFNGLISPROGRAMPIPELINEPROC, glIsProgramPipeline, (GLuint pipeline), (pipeline)) \
+    R(GLboolean, PFNGLISQUERYPROC, glIsQuery, (GLuint id), (id)) \
+    R(GLboolean, PFNGLISRENDERBUFFERPROC, glIsRenderbuffer, (GLuint renderbuffer), (renderbuffer)) \
+    R(GLboolean, PFNGLISSAMPLERPROC, glIsSampler, (GLuint sampler), (sampler)) \
+    R(GLboolean, PFNGLISSHADERPROC, glIsShader, (GLuint shader), (shader)) \
+    R(GLboolean, PFNGLISSYNCPROC, glIsSync, (GLsync sync), (sync)) \
+    R(GLboolean, PFNGLISTEXTUREPROC, glIsTexture, (GLuint texture), (texture)) \
+    R(GLboolean, PFNGLISTRANSFORMFEEDBACKPROC, glIsTransformFeedback, (GLuint id), (id)) \
+    R(GLboolean, PFNGLISVERTEXARRAYPROC, glIsVertexArray, (GLuint array), (array)) \
+    V(PFNGLLINEWIDTHPROC, glLineWidth, (GLfloat width), (width)) \
+    V(PFNGLLINKPROGRAMPROC, glLinkProgram, (GLuint program), (program)) \
+    R(void *, PFNGLMAPBUFFERRANGEPROC, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access)) \
+    V(PFNGLMEMORYBARRIERPROC, glMemoryBarrier, (GLbitfield barriers), (barriers)) \
+    V(PFNGLMEMORYBARRIERBYREGIONPROC, glMemoryBarrierByRegion, (GLbitfield barriers), (barriers)) \
+    V(PFNGLPAUSETRANSFORMFEEDBACKPROC, glPauseTransformFeedback, (void), ()) \
+    V(PFNGLPIXELSTOREIPROC, glPixelStorei, (GLenum pname, GLint param), (pname, param)) \
+    V(PFNGLPOLYGONOFFSETPROC, glPolygonOffset, (GLfloat factor, GLfloat units), (factor, units)) \
+    V(PFNGLPROGRAMBINARYPROC, glProgramBinary, (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length), (program, binaryFormat, binary, length)) \
+    V(PFNGLPROGRAMPARAMETERIPROC, glProgramParameteri, (GLuint program, GLenum pname, GLint value), (program, pname, value)) \
+    V(PFNGLPROGRAMUNIFORM1FPROC, glProgramUniform1f, (GLuint program, GLint location, GLfloat v0), (program, location, v0)) \
+    V(PFNGLPROGRAMUNIFORM1FVPROC, glProgramUniform1fv, (GLuint program, GLint location, GLsizei count, const GLfloat *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM1IPROC, glProgramUniform1i, (GLuint program, GLint location, GLint v0), (program, location, v0)) \
+    V(PFNGLPROGRAMUNIFORM1IVPROC, glProgramUniform1iv, (GLuint program, GLint location, GLsizei count, const GLint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM1UIPROC, glProgramUniform1ui, (GLuint program, GLint location, GLuint v0), (program, location, v0)) \
+    V(PFNGLPROGRAMUNIFORM1UIVPROC, glProgramUniform1uiv, (GLuint program, GLint location, GLsizei count, const GLuint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM2FPROC, glProgramUniform2f, (GLuint program, GLint location, GLfloat v0, GLfloat v1), (program, location, v0, v1)) \
+    V(PFNGLPROGRAMUNIFORM2FVPROC, glProgramUniform2fv, (GLuint program, GLint location, GLsizei count, const GLfloat *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM2IPROC, glProgramUniform2i, (GLuint program, GLint location, GLint v0, GLint v1), (program, location, v0, v1)) \
+    V(PFNGLPROGRAMUNIFORM2IVPROC, glProgramUniform2iv, (GLuint program, GLint location, GLsizei count, const GLint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM2UIPROC, glProgramUniform2ui, (GLuint program, GLint location, GLuint v0, GLuint v1), (program, location, v0, v1)) \
+    V(PFNGLPROGRAMUNIFORM2UIVPROC, glProgramUniform2uiv, (GLuint program, GLint location, GLsizei count, const GLuint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM3FPROC, glProgramUniform3f, (GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (program, location, v0, v1, v2)) \
+    V(PFNGLPROGRAMUNIFORM3FVPROC, glProgramUniform3fv, (GLuint program, GLint location, GLsizei count, const GLfloat *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM3IPROC, glProgramUniform3i, (GLuint program, GLint location, GLint v0, GLint v1, GLint v2), (program, location, v0, v1, v2)) \
+    V(PFNGLPROGRAMUNIFORM3IVPROC, glProgramUniform3iv, (GLuint program, GLint location, GLsizei count, const GLint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM3UIPROC, glProgramUniform3ui, (GLuint program, GLint location, GLuint v0, GLuint v1, GLuint v2), (program, location, v0, v1, v2)) \
+    V(PFNGLPROGRAMUNIFORM3UIVPROC, glProgramUniform3uiv, (GLuint program, GLint location, GLsizei count, const GLuint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM4FPROC, glProgramUniform4f, (GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (program, location, v0, v1, v2, v3)) \
+    V(PFNGLPROGRAMUNIFORM4FVPROC, glProgramUniform4fv, (GLuint program, GLint location, GLsizei count, const GLfloat *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM4IPROC, glProgramUniform4i, (GLuint program, GLint location, GLint v0, GLint v1, GLint v2, GLint v3), (program, location, v0, v1, v2, v3)) \
+    V(PFNGLPROGRAMUNIFORM4IVPROC, glProgramUniform4iv, (GLuint program, GLint location, GLsizei count, const GLint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORM4UIPROC, glProgramUniform4ui, (GLuint program, GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3), (program, location, v0, v1, v2, v3)) \
+    V(PFNGLPROGRAMUNIFORM4UIVPROC, glProgramUniform4uiv, (GLuint program, GLint location, GLsizei count, const GLuint *value), (program, location, count, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX2FVPROC, glProgramUniformMatrix2fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX2X3FVPROC, glProgramUniformMatrix2x3fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX2X4FVPROC, glProgramUniformMatrix2x4fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX3FVPROC, glProgramUniformMatrix3fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX3X2FVPROC, glProgramUniformMatrix3x2fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX3X4FVPROC, glProgramUniformMatrix3x4fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX4FVPROC, glProgramUniformMatrix4fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX4X2FVPROC, glProgramUniformMatrix4x2fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLPROGRAMUNIFORMMATRIX4X3FVPROC, glProgramUniformMatrix4x3fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (program, location, count, transpose, value)) \
+    V(PFNGLREADBUFFERPROC, glReadBuffer, (GLenum src), (src)) \
+    V(PFNGLREADPIXELSPROC, glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels), (x, y, width, height, format, type, pixels)) \
+    V(PFNGLRELEASESHADERCOMPILERPROC, glReleaseShaderCompiler, (void), ()) \
+    V(PFNGLRENDERBUFFERSTORAGEPROC, glRenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height)) \
+    V(PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC, glRenderbufferStorageMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height), (target, samples, internalformat, width, height)) \
+    V(PFNGLRESUMETRANSFORMFEEDBACKPROC, glResumeTransformFeedback, (void), ()) \
+    V(PFNGLSAMPLECOVERAGEPROC, glSampleCoverage, (GLfloat value, GLboolean invert), (value, invert)) \
+    V(PFNGLSAMPLEMASKIPROC, glSampleMaski, (GLuint maskNumber, GLbitfield mask), (maskNumber, mask)) \
+    V(PFNGLSAMPLERPARAMETERFPROC, glSamplerParameterf, (GLuint sampler, GLenum pname, GLfloat param), (sampler, pname, param)) \
+    V(PFNGLSAMPLERPARAMETERFVPROC, glSamplerParameterfv, (GLuint sampler, GLenum pname, const GLfloat *param), (sampler, pname, param)) \
+    V(PFNGLSAMPLERPARAMETERIPROC, glSamplerParameteri, (GLuint sampler, GLenum pname, GLint param), (sampler, pname, param)) \
+    V(PFNGLSAMPLERPARAMETERIVPROC, glSamplerParameteriv, (GLuint sampler, GLenum pname, const GLint *param), (sampler, pname, param)) \
+    V(PFNGLSCISSORPROC, glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+    V(PFNGLSHADERBINARYPROC, glShaderBinary, (GLsizei count, const GLuint *shaders, GLenum binaryFormat, const void *binary, GLsizei length), (count, shaders, binaryFormat, binary, length)) \
+    V(PFNGLSHADERSOURCEPROC, glShaderSource, (GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length), (shader, count, string, length)) \
+    V(PFNGLSTENCILFUNCPROC, glStencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask)) \
+    V(PFNGLSTENCILFUNCSEPARATEPROC, glStencilFuncSeparate, (GLenum face, GLenum func, GLint ref, GLuint mask), (face, func, ref, mask)) \
+    V(PFNGLSTENCILMASKPROC, glStencilMask, (GLuint mask), (mask)) \
+    V(PFNGLSTENCILMASKSEPARATEPROC, glStencilMaskSeparate, (GLenum face, GLuint mask), (face, mask)) \
+    V(PFNGLSTENCILOPPROC, glStencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass)) \
+    V(PFNGLSTENCILOPSEPARATEPROC, glStencilOpSeparate, (GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass), (face, sfail, dpfail, dppass)) \
+    V(PFNGLTEXIMAGE2DPROC, glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, border, format, type, pixels)) \
+    V(PFNGLTEXIMAGE3DPROC, glTexImage3D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, depth, border, format, type, pixels)) \
+    V(PFNGLTEXPARAMETERFPROC, glTexParameterf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param)) \
+    V(PFNGLTEXPARAMETERFVPROC, glTexParameterfv, (GLenum target, GLenum pname, const GLfloat *params), (target, pname, params)) \
+    V(PFNGLTEXPARAMETERIPROC, glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+    V(PFNGLTEXPARAMETERIVPROC, glTexParameteriv, (GLenum target, GLenum pname, const GLint *params), (target, pname, params)) \
+    V(PFNGLTEXSTORAGE2DPROC, glTexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height)) \
+    V(PFNGLTEXSTORAGE2DMULTISAMPLEPROC, glTexStorage2DMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations), (target, samples, internalformat, width, height, fixedsamplelocations)) \
+    V(PFNGLTEXSTORAGE3DPROC, glTexStorage3D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth), (target, levels, internalformat, width, height, depth)) \
+    V(PFNGLTEXSUBIMAGE2DPROC, glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels)) \
+    V(PFNGLTEXSUBIMAGE3DPROC, glTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels)) \
+    V(PFNGLTRANSFORMFEEDBACKVARYINGSPROC, glTransformFeedbackVaryings, (GLuint program, GLsizei count, const GLchar *const*varyings, GLenum bufferMode), (program, count, varyings, bufferMode)) \
+    V(PFNGLUNIFORM1FPROC, glUniform1f, (GLint location, GLfloat v0), (location, v0)) \
+    V(PFNGLUNIFORM1FVPROC, glUniform1fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    V(PFNGLUNIFORM1IPROC, glUniform1i, (GLint location, GLint v0), (location, v0)) \
+    V(PFNGLUNIFORM1IVPROC, glUniform1iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    V(PFNGLUNIFORM1UIPROC, glUniform1ui, (GLint location, GLuint v0), (location, v0)) \
+    V(PFNGLUNIFORM1UIVPROC, glUniform1uiv, (GLint location, GLsizei count, const GLuint *value), (location, count, value)) \
+    V(PFNGLUNIFORM2FPROC, glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1)) \
+    V(PFNGLUNIFORM2FVPROC, glUniform2fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    V(PFNGLUNIFORM2IPROC, glUniform2i, (GLint location, GLint v0, GLint v1), (location, v0, v1)) \
+    V(PFNGLUNIFORM2IVPROC, glUniform2iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    V(PFNGLUNIFORM2UIPROC, glUniform2ui, (GLint location, GLuint v0, GLuint v1), (location, v0, v1)) \
+    V(PFNGLUNIFORM2UIVPROC, glUniform2uiv, (GLint location, GLsizei count, const GLuint *value), (location, count, value)) \
+    V(PFNGLUNIFORM3FPROC, glUniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2)) \
+    V(PFNGLUNIFORM3FVPROC, glUniform3fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    V(PFNGLUNIFORM3IPROC, glUniform3i, (GLint location, GLint v0, GLint v1, GLint v2), (location, v0, v1, v2)) \
+    V(PFNGLUNIFORM3IVPROC, glUniform3iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    V(PFNGLUNIFORM3UIPROC, glUniform3ui, (GLint location, GLuint v0, GLuint v1, GLuint v2), (location, v0, v1, v2)) \
+    V(PFNGLUNIFORM3UIVPROC, glUniform3uiv, (GLint location, GLsizei count, const GLuint *value), (location, count, value)) \
+    V(PFNGLUNIFORM4FPROC, glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3)) \
+    V(PFNGLUNIFORM4FVPROC, glUniform4fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    V(PFNGLUNIFORM4IPROC, glUniform4i, (GLint location, GLint v0, GLint v1, GLint v2, GLint v3), (location, v0, v1, v2, v3)) \
+    V(PFNGLUNIFORM4IVPROC, glUniform4iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    V(PFNGLUNIFORM4UIPROC, glUniform4ui, (GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3), (location, v0, v1, v2, v3)) \
+    V(PFNGLUNIFORM4UIVPROC, glUniform4uiv, (GLint location, GLsizei count, const GLuint *value), (location, count, value)) \
+    V(PFNGLUNIFORMBLOCKBINDINGPROC, glUniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding)) \
+    V(PFNGLUNIFORMMATRIX2FVPROC, glUniformMatrix2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX2X3FVPROC, glUniformMatrix2x3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX2X4FVPROC, glUniformMatrix2x4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX3FVPROC, glUniformMatrix3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX3X2FVPROC, glUniformMatrix3x2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX3X4FVPROC, glUniformMatrix3x4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX4X2FVPROC, glUniformMatrix4x2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    V(PFNGLUNIFORMMATRIX4X3FVPROC, glUniformMatrix4x3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    R(GLboolean, PFNGLUNMAPBUFFERPROC, glUnmapBuffer, (GLenum target), (target)) \
+    V(PFNGLUSEPROGRAMPROC, glUseProgram, (GLuint program), (program)) \
+    V(PFNGLUSEPROGRAMSTAGESPROC, glUseProgramStages, (GLuint pipeline, GLbitfield stages, GLuint program), (pipeline, stages, program)) \
+    V(PFNGLVALIDATEPROGRAMPROC, glValidateProgram, (GLuint program), (program)) \
+    V(PFNGLVALIDATEPROGRAMPIPELINEPROC, glValidateProgramPipeline, (GLuint pipeline), (pipeline)) \
+    V(PFNGLVERTEXATTRIB1FPROC, glVertexAttrib1f, (GLuint index, GLfloat x), (index, x)) \
+    V(PFNGLVERTEXATTRIB1FVPROC, glVertexAttrib1fv, (GLuint index, const GLfloat *v), (index, v)) \
+    V(PFNGLVERTEXATTRIB2FPROC, glVertexAttrib2f, (GLuint index, GLfloat x, GLfloat y), (index, x, y)) \
+    V(PFNGLVERTEXATTRIB2FVPROC, glVertexAttrib2fv, (GLuint index, const GLfloat *v), (index, v)) \
+    V(PFNGLVERTEXATTRIB3FPROC, glVertexAttrib3f, (GLuint index, GLfloat x, GLfloat y, GLfloat z), (index, x, y, z)) \
+    V(PFNGLVERTEXATTRIB3FVPROC, glVertexAttrib3fv, (GLuint index, const GLfloat *v), (index, v)) \
+    V(PFNGLVERTEXATTRIB4FPROC, glVertexAttrib4f, (GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w), (index, x, y, z, w)) \
+    V(PFNGLVERTEXATTRIB4FVPROC, glVertexAttrib4fv, (GLuint index, const GLfloat *v), (index, v)) \
+    V(PFNGLVERTEXATTRIBBINDINGPROC, glVertexAttribBinding, (GLuint attribindex, GLuint bindingindex), (attribindex, bindingindex)) \
+    V(PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+    V(PFNGLVERTEXATTRIBFORMATPROC, glVertexAttribFormat, (GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset), (attribindex, size, type, normalized, relativeoffset)) \
+    V(PFNGLVERTEXATTRIBI4IPROC, glVertexAttribI4i, (GLuint index, GLint x, GLint y, GLint z, GLint w), (index, x, y, z, w)) \
+    V(PFNGLVERTEXATTRIBI4IVPROC, glVertexAttribI4iv, (GLuint index, const GLint *v), (index, v)) \
+    V(PFNGLVERTEXATTRIBI4UIPROC, glVertexAttribI4ui, (GLuint index, GLuint x, GLuint y, GLuint z, GLuint w), (index, x, y, z, w)) \
+    V(PFNGLVERTEXATTRIBI4UIVPROC, glVertexAttribI4uiv, (GLuint index, const GLuint *v), (index, v)) \
+    V(PFNGLVERTEXATTRIBIFORMATPROC, glVertexAttribIFormat, (GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset), (attribindex, size, type, relativeoffset)) \
+    V(PFNGLVERTEXATTRIBIPOINTERPROC, glVertexAttribIPointer, (GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer), (index, size, type, stride, pointer)) \
+    V(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer)) \
+    V(PFNGLVERTEXBINDINGDIVISORPROC, glVertexBindingDivisor, (GLuint bindingindex, GLuint divisor), (bindingindex, divisor)) \
+    V(PFNGLVIEWPORTPROC, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+    V(PFNGLWAITSYNCPROC, glWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout))
+
+static GLADloadproc lazy_load;
+
+static void* lazy_resolve(const char* name) {
+	void* proc = lazy_load(name);
+	if (proc == NULL) {
+		fprintf(stderr, "GLAD: %s is not available\n", name);
+		abort();
+	}
+	return proc;
+}
+
+#define GLAD_LAZY_R(ret, type, name, params, args) \
+	static ret APIENTRY lazy_##name params { glad_##name = (type)lazy_resolve(#name); return glad_##name args; }
+#define GLAD_LAZY_V(type, name, params, args) \
+	static void APIENTRY lazy_##name params { glad_##name = (type)lazy_resolve(#name); glad_##name args; }
+GLAD_LAZY_FUNCTIONS(GLAD_LAZY_R, GLAD_LAZY_V)
+
+struct lazy_entry {
+	const char* name;
+	void** proc;
+	void* trampoline;
+};
+
+#define GLAD_LAZY_ENTRY_R(ret, type, name, params, args) { #name, (void**)&glad_##name, (void*)lazy_##name },
+#define GLAD_LAZY_ENTRY_V(type, name, params, args) { #name, (void**)&glad_##name, (void*)lazy_##name },
+static const struct lazy_entry lazy_entries[] = {
+	GLAD_LAZY_FUNCTIONS(GLAD_LAZY_ENTRY_R, GLAD_LAZY_ENTRY_V)
+};
+
+static int compare_lazy_entry(const void* name, const void* entry) {
+	return strcmp((const char*)name, ((const struct lazy_entry*)entry)->name);
+}
+
+int gladLoadGLES2LoaderLazy(GLADloadproc load, const char* const* preload) {
+	size_t i;
+	const size_t count = sizeof(lazy_entries) / sizeof(lazy_entries[0]);
+
+	GLVersion.major = 0; GLVersion.minor = 0;
+	glGetError = (PFNGLGETERRORPROC)load("glGetError");
+	glGetString = (PFNGLGETSTRINGPROC)load("glGetString");
+	if(glGetString == NULL) {
+		fprintf(stderr, "Failed to initialize GLAD glGetString\n");
+		return 0;
+	}
+	GLAD_GL_ES_VERSION_2_0 = 1;
+	GLAD_GL_ES_VERSION_3_0 = 1;
+	GLAD_GL_ES_VERSION_3_1 = 1;
+	GLVersion.major = 3;
+	GLVersion.minor = 1;
+	lazy_load = load;
+	for (i = 0; i < count; i++)
+		*lazy_entries[i].proc = lazy_entries[i].trampoline;
+	/* resolve these now, not in the middle of a frame */
+	for (; preload && *preload; preload++) {
+		const struct lazy_entry* entry = bsearch(*preload, lazy_entries, count, sizeof(lazy_entries[0]), compare_lazy_entry);
+		if (entry)
+			*entry->proc = lazy_resolve(entry->name);
+		else
+			fprintf(stderr, "GLAD: cannot preload unknown function %s\n", *preload);
+	}
+
+	if (!find_extensionsGLES2()) return 0;
+	return 1;
+}
@@ -87,6 +87,9 @@ typedef void* (* GLADloadproc)(const char *name);
 
 GLAPI struct gladGLversionStruct GLVersion;
 GLAPI int gladLoadGLES2Loader(GLADloadproc);
+/* Like gladLoadGLES2Loader(), but every function is looked up on its first call,
+ * except the ones in the NULL terminated preload list, which are looked up now */
+GLAPI int gladLoadGLES2LoaderLazy(GLADloadproc load, const char* const* preload);
 
 #include "khrplatform.h"
 typedef unsigned int GLenum;
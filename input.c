@@ -0,0 +1,241 @@
+/*
+Input
+
+The reader thread sleeps in poll() on the evdev devices and pushes every
+event into a single-producer single-consumer ring, the same two-index scheme
+as the frame stream. The render thread drains the ring when it starts a
+frame, so input costs it no system call and no lock. The devices are
+switched to CLOCK_MONOTONIC timestamps, the clock of the page flip events,
+which makes the time from an event to the flip that first shows it a plain
+subtraction.
+ */
+
+#include "input.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+static bool test_bit(const uint8_t* bits, int bit) {
+    return bits[bit / 8] & (1 << bit % 8);
+}
+
+static int open_device(struct input* input, const char* path, bool named) {
+    uint8_t types[(EV_MAX + 8) / 8] = { 0 };
+    int clock = CLOCK_MONOTONIC;
+    int fd;
+
+    if (input->num_devices == INPUT_MAX_DEVICES)
+        return -1;
+    fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        if (named)
+            printf("input: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    /* when scanning, skip devices without keys, buttons or axes */
+    if (!named && (ioctl(fd, EVIOCGBIT(0, sizeof(types)), types) < 0 ||
+        (!test_bit(types, EV_KEY) && !test_bit(types, EV_ABS)))) {
+        close(fd);
+        return -1;
+    }
+    if (ioctl(fd, EVIOCSCLOCKID, &clock) < 0)
+        printf("input: %s keeps realtime timestamps, latency will be off\n", path);
+    for (int axis = 0; axis < 2; axis++) {
+        struct input_absinfo info;
+
+        if (!ioctl(fd, EVIOCGABS(ABS_X + axis), &info)) {
+            input->abs_min[input->num_devices][axis] = info.minimum;
+            input->abs_max[input->num_devices][axis] = info.maximum;
+        }
+    }
+    if (ioctl(fd, EVIOCGNAME(sizeof(input->names[0])), input->names[input->num_devices]) < 0)
+        snprintf(input->names[input->num_devices], sizeof(input->names[0]), "%s", path);
+    input->fds[input->num_devices++] = fd;
+    return 0;
+}
+
+static void push(struct input* input, const struct input_record* record) {
+    unsigned int tail = atomic_load_explicit(&input->tail, memory_order_relaxed);
+
+    input->received++;
+    if (tail - atomic_load_explicit(&input->head, memory_order_acquire) >= INPUT_QUEUE) {
+        input->dropped++;
+        return;
+    }
+    input->queue[tail % INPUT_QUEUE] = *record;
+    atomic_store_explicit(&input->tail, tail + 1, memory_order_release);
+}
+
+static void* input_thread(void* data) {
+    struct input* input = data;
+    struct pollfd fds[INPUT_MAX_DEVICES + 1];
+    struct input_event events[64];
+
+    while (true) {
+        int n = 0;
+
+        for (int i = 0; i < input->num_devices; i++)
+            fds[n++] = (struct pollfd) { input->fds[i], POLLIN, 0 };
+        fds[n++] = (struct pollfd) { input->wakeup[0], POLLIN, 0 };
+        if (poll(fds, n, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[n - 1].revents)
+            break;
+
+        for (int i = 0; i < input->num_devices; i++) {
+            ssize_t size;
+
+            if (!fds[i].revents)
+                continue;
+            size = read(input->fds[i], events, sizeof(events));
+            if (size < 0 && errno == EAGAIN)
+                continue;
+            if (size <= 0) {
+                /* unplugged: stop polling it, keep the slot so device numbers stay */
+                printf("input: lost %s\n", input->names[i]);
+                close(input->fds[i]);
+                input->fds[i] = -1;
+                continue;
+            }
+            for (size_t e = 0; e < size / sizeof(events[0]); e++) {
+                const struct input_event* ev = &events[e];
+                const struct input_record record = {
+                    ev->input_event_sec * INT64_C(1000000000) + ev->input_event_usec * INT64_C(1000),
+                    ev->type, ev->code, ev->value, i };
+
+                if (input->handler)
+                    input->handler(input->handler_data, &record);
+                /* the frame looks at state changes, report boundaries add nothing */
+                if (ev->type != EV_SYN && ev->type != EV_MSC)
+                    push(input, &record);
+            }
+        }
+    }
+    return NULL;
+}
+
+int input_start(struct input* input, const char* device, input_handler handler, void* data) {
+    memset(input, 0, sizeof(*input));
+    input->handler = handler;
+    input->handler_data = data;
+    if (device) {
+        open_device(input, device, true);
+    } else {
+        DIR* dir = opendir("/dev/input");
+        struct dirent* entry;
+        char path[300];
+
+        while (dir && (entry = readdir(dir))) {
+            if (strncmp(entry->d_name, "event", 5))
+                continue;
+            snprintf(path, sizeof(path), "/dev/input/%s", entry->d_name);
+            open_device(input, path, false);
+        }
+        if (dir)
+            closedir(dir);
+    }
+    if (!input->num_devices) {
+        printf("input: no readable input devices\n");
+        return -1;
+    }
+    for (int i = 0; i < input->num_devices; i++)
+        printf("input: [%d] %s\n", i, input->names[i]);
+
+    if (pipe(input->wakeup))
+        goto fail;
+    if (pthread_create(&input->thread, NULL, input_thread, input)) {
+        printf("input_start: failed to create reader thread\n");
+        close(input->wakeup[0]);
+        close(input->wakeup[1]);
+        goto fail;
+    }
+    input->running = true;
+    return 0;
+
+fail:
+    for (int i = 0; i < input->num_devices; i++)
+        close(input->fds[i]);
+    input->num_devices = 0;
+    return -1;
+}
+
+void input_stop(struct input* input) {
+    if (!input->running)
+        return;
+    if (write(input->wakeup[1], "", 1) != 1)
+        pthread_cancel(input->thread);
+    pthread_join(input->thread, NULL);
+    close(input->wakeup[0]);
+    close(input->wakeup[1]);
+    for (int i = 0; i < input->num_devices; i++) {
+        if (input->fds[i] >= 0)
+            close(input->fds[i]);
+    }
+    input->running = false;
+    printf("input: %u events, %u delivered to frames, %u dropped\n", input->received, input->delivered,
+        input->dropped);
+}
+
+bool input_poll(struct input* input, struct input_record* record) {
+    unsigned int head = atomic_load_explicit(&input->head, memory_order_relaxed);
+
+    if (head == atomic_load_explicit(&input->tail, memory_order_acquire))
+        return false;
+    *record = input->queue[head % INPUT_QUEUE];
+    atomic_store_explicit(&input->head, head + 1, memory_order_release);
+    input->delivered++;
+    return true;
+}
+
+// ============================================================================================
+// latency
+// ============================================================================================
+
+void input_latency_add(struct input_latency* latency, int64_t ns) {
+    int bucket = ns / 500000;
+
+    if (ns < 0)
+        return;
+    if (!latency->count || ns < latency->min)
+        latency->min = ns;
+    if (ns > latency->max)
+        latency->max = ns;
+    latency->sum += ns;
+    latency->count++;
+    latency->buckets[bucket < INPUT_LATENCY_BUCKETS ? bucket : INPUT_LATENCY_BUCKETS - 1]++;
+}
+
+/* Upper edge of the bucket holding the given fraction of the samples, ms */
+static double percentile(const struct input_latency* latency, double fraction) {
+    unsigned int seen = 0;
+
+    for (int i = 0; i < INPUT_LATENCY_BUCKETS; i++) {
+        seen += latency->buckets[i];
+        if (seen >= fraction * latency->count)
+            return (i + 1) * 0.5;
+    }
+    return latency->max / 1e6;
+}
+
+void input_latency_report(const struct input_latency* latency, const char* label) {
+    if (!latency->count)
+        return;
+    printf("%s: %u frames, avg %.2f ms, min %.2f ms, p50 < %.1f ms, p99 < %.1f ms, max %.2f ms\n", label,
+        latency->count, latency->sum / 1e6 / latency->count, latency->min / 1e6, percentile(latency, 0.5),
+        percentile(latency, 0.99), latency->max / 1e6);
+}
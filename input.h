@@ -0,0 +1,70 @@
+/*
+Input: evdev devices read on a dedicated thread, events delivered with their
+kernel timestamps through a lock-free queue to the render thread, plus the
+bookkeeping for input-to-scanout latency
+ */
+
+#ifndef _INPUT_EVENTS_H
+#define _INPUT_EVENTS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define INPUT_QUEUE 256         /* power of two */
+#define INPUT_MAX_DEVICES 16
+#define INPUT_LATENCY_BUCKETS 200   /* 0.5 ms each, the last one takes everything slower */
+
+struct input_record {
+    int64_t time;               /* kernel timestamp, CLOCK_MONOTONIC ns */
+    uint16_t type, code;
+    int32_t value;
+    int device;
+};
+
+typedef void (*input_handler)(void* data, const struct input_record* record);
+
+struct input {
+    int fds[INPUT_MAX_DEVICES];
+    char names[INPUT_MAX_DEVICES][64];
+    int abs_min[INPUT_MAX_DEVICES][2], abs_max[INPUT_MAX_DEVICES][2];   /* ABS_X, ABS_Y ranges */
+    int num_devices;
+    int wakeup[2];              /* pipe that stops the reader */
+    input_handler handler;
+    void* handler_data;
+
+    /* single producer (reader thread), single consumer (render thread) */
+    struct input_record queue[INPUT_QUEUE];
+    atomic_uint head, tail;
+    pthread_t thread;
+    bool running;
+
+    /* statistics */
+    unsigned int received, dropped;     /* reader thread */
+    unsigned int delivered;             /* render thread */
+};
+
+struct input_latency {
+    unsigned int count;
+    int64_t sum, min, max;
+    unsigned int buckets[INPUT_LATENCY_BUCKETS];
+};
+
+/* Open device, or with NULL every /dev/input/event* with keys, buttons or
+ * axes that can be read, and start the reader thread. handler, if not NULL,
+ * sees every event on the reader thread as soon as it is read, EV_SYN report
+ * boundaries included, for work that must not wait for the next frame (the
+ * hardware cursor). The events are queued for the render thread as well.
+ */
+int input_start(struct input* input, const char* device, input_handler handler, void* data);
+
+void input_stop(struct input* input);
+
+/* Next queued event, false if there is none. Never blocks. */
+bool input_poll(struct input* input, struct input_record* record);
+
+void input_latency_add(struct input_latency* latency, int64_t ns);
+void input_latency_report(const struct input_latency* latency, const char* label);
+
+#endif /* _INPUT_EVENTS_H */
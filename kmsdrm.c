@@ -0,0 +1,1767 @@
+/*
+libkmsdrm: KMSDRM output with double buffer swapped (page flipped) when vertical blank,
+rendered with OpenGL ES or OpenGL, whichever init_egl() is given or finds first
+based on kmscube
+ */
+
+#include "kmsdrm.h"
+
+/* API of the current context, picks the GLSL version create_program() adds */
+static enum gl_api current_api = GL_API_GLES;
+
+#ifdef GL_LAZY_LOAD
+/* What the render loops call every frame: looked up in init_egl(), so that no
+ * lookup lands in the first frames. The rest resolve on their first call.
+ */
+static const char* const gl_preload[] = {
+    "glBindBuffer", "glBindTexture", "glClear", "glClearColor", "glDisable", "glDrawArrays",
+    "glDrawElements", "glEnable", "glEnableVertexAttribArray", "glFinish", "glFlush", "glScissor",
+    "glUniform1f", "glUniform1i", "glUniform4f", "glUniformMatrix4fv", "glUseProgram",
+    "glVertexAttribPointer", "glViewport", NULL
+};
+#endif
+
+int64_t get_time_ns(void) {
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return tv.tv_nsec + tv.tv_sec * NSEC_PER_SEC;
+}
+
+/* Number of strings for glShaderSource(): sources without a #version line
+ * get the GLSL version both APIs understand, GLSL ES 1.00 or GLSL 1.20,
+ * prepended. Such sources declare precision under #ifdef GL_ES.
+ */
+static int shader_strings(const char* src, const char** strings) {
+    if (!strncmp(src, "#version", 8)) {
+        strings[0] = src;
+        return 1;
+    }
+    strings[0] = current_api == GL_API_GL ? "#version 120\n" : "#version 100\n";
+    strings[1] = src;
+    return 2;
+}
+
+int create_program(const char* vs_src, const char* fs_src) {
+    GLuint vertex_shader, fragment_shader, program;
+    const char* strings[2];
+    GLint ret;
+    int phase = startup_trace_begin("create_program");
+
+    vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    if (vertex_shader == 0) {
+        debug_printf("vertex shader creation failed!:\n");
+        return -1;
+    }
+
+    glShaderSource(vertex_shader, shader_strings(vs_src, strings), strings, NULL);
+    glCompileShader(vertex_shader);
+
+    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &ret);
+    if (!ret) {
+        char* log;
+
+        debug_printf("vertex shader compilation failed!:\n");
+        glGetShaderiv(vertex_shader, GL_INFO_LOG_LENGTH, &ret);
+        if (ret > 1) {
+            log = malloc(ret);
+            glGetShaderInfoLog(vertex_shader, ret, NULL, log);
+            debug_printf("%s", log);
+            free(log);
+        }
+
+        return -1;
+    }
+
+    fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    if (fragment_shader == 0) {
+        debug_printf("fragment shader creation failed!:\n");
+        return -1;
+    }
+    glShaderSource(fragment_shader, shader_strings(fs_src, strings), strings, NULL);
+    glCompileShader(fragment_shader);
+
+    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &ret);
+    if (!ret) {
+        char* log;
+
+        debug_printf("fragment shader compilation failed!:\n");
+        glGetShaderiv(fragment_shader, GL_INFO_LOG_LENGTH, &ret);
+
+        if (ret > 1) {
+            log = malloc(ret);
+            glGetShaderInfoLog(fragment_shader, ret, NULL, log);
+            debug_printf("%s", log);
+            free(log);
+        }
+        return -1;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    startup_trace_end(phase);
+    return program;
+}
+
+int link_program(unsigned program) {
+    GLint ret;
+    int phase = startup_trace_begin("link_program");
+
+    glLinkProgram(program);
+    glGetProgramiv(program, GL_LINK_STATUS, &ret);
+    startup_trace_end(phase);
+    if (!ret) {
+        char* log;
+
+        debug_printf("program linking failed!:\n");
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &ret);
+
+        if (ret > 1) {
+            log = malloc(ret);
+            glGetProgramInfoLog(program, ret, NULL, log);
+            debug_printf("%s", log);
+            free(log);
+        }
+        glDeleteProgram(program);
+        program = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static int get_resources(int fd, drmModeRes** resources) {
+    debug_puts("drmModeGetResources");
+    *resources = drmModeGetResources(fd);
+    if (*resources == NULL)
+        return -1;
+    return 0;
+}
+
+static int find_drm_device(drmModeRes** resources, char* path, size_t path_len) {
+    drmDevicePtr devices[MAX_DRM_DEVICES] = { NULL };
+    int num_devices, fd = -1;
+
+    debug_puts("find_drm_device: drmGetDevices2");
+    num_devices = drmGetDevices2(0, devices, MAX_DRM_DEVICES);
+    if (num_devices < 0) {
+        debug_printf("drmGetDevices2 failed: %s\n", strerror(-num_devices));
+        return -1;
+    }
+
+    for (int i = 0; i < num_devices; i++) {
+        drmDevicePtr device = devices[i];
+        int ret;
+
+        if (!(device->available_nodes & (1 << DRM_NODE_PRIMARY)))
+            continue;
+        /* OK, it's a primary device. If we can get the
+         * drmModeResources, it means it's also a
+         * KMS-capable device.
+         */
+        printf("Opening DRM device %s\n", device->nodes[DRM_NODE_PRIMARY]);
+        fd = open(device->nodes[DRM_NODE_PRIMARY], O_RDWR | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        ret = get_resources(fd, resources);
+        if (!ret) {
+            snprintf(path, path_len, "%s", device->nodes[DRM_NODE_PRIMARY]);
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    debug_puts("find_drm_device: drmFreeDevices");
+    drmFreeDevices(devices, num_devices);
+
+    if (fd < 0)
+        printf("no drm device found!\n");
+    return fd;
+}
+
+static bool crtc_in_use(const struct drm* drm, uint32_t crtc_id) {
+    for (int i = 0; i < drm->num_outputs; i++) {
+        if (drm->outputs[i].crtc_id == crtc_id)
+            return true;
+    }
+    return false;
+}
+
+static int32_t find_crtc_for_encoder(const struct drm* drm, const drmModeRes* resources,
+    const drmModeEncoder* encoder) {
+    int i;
+
+    for (i = 0; i < resources->count_crtcs; i++) {
+        /* possible_crtcs is a bitmask as described here:
+         * https://dvdhrm.wordpress.com/2012/09/13/linux-drm-mode-setting-api
+         */
+        const uint32_t crtc_mask = 1 << i;
+        const uint32_t crtc_id = resources->crtcs[i];
+        if ((encoder->possible_crtcs & crtc_mask) && !crtc_in_use(drm, crtc_id)) {
+            return crtc_id;
+        }
+    }
+    /* no match found */
+    return -1;
+}
+
+static int32_t find_crtc_for_connector(const struct drm* drm, const drmModeRes* resources,
+    const drmModeConnector* connector) {
+    int i;
+
+    for (i = 0; i < connector->count_encoders; i++) {
+        const uint32_t encoder_id = connector->encoders[i];
+        debug_puts("find_crtc_for_connector: drmModeGetEncoder");
+        drmModeEncoder* encoder = drmModeGetEncoder(drm->fd, encoder_id);
+
+        if (encoder) {
+            const int32_t crtc_id = find_crtc_for_encoder(drm, resources, encoder);
+            debug_puts("find_crtc_for_connector: drmModeFreeEncoder");
+            drmModeFreeEncoder(encoder);
+            if (crtc_id != -1) {
+                return crtc_id;
+            }
+        }
+    }
+    /* no match found */
+    return -1;
+}
+
+static int find_crtc_index(const drmModeRes* resources, uint32_t crtc_id) {
+    for (int i = 0; i < resources->count_crtcs; i++) {
+        if (resources->crtcs[i] == crtc_id)
+            return i;
+    }
+    return -1;
+}
+
+/* preferred mode of the connector, or its highest resolution mode */
+static drmModeModeInfo* find_default_mode(const drmModeConnector* connector) {
+    drmModeModeInfo* mode = NULL;
+    int i, area;
+
+    for (i = 0, area = 0; i < connector->count_modes; i++) {
+        drmModeModeInfo* current_mode = &connector->modes[i];
+
+        if (current_mode->type & DRM_MODE_TYPE_PREFERRED) {
+            debug_printf("find_default_mode: found preferred mode %dx%d\n", current_mode->hdisplay, current_mode->vdisplay);
+            return current_mode;
+        }
+
+        int current_area = current_mode->hdisplay * current_mode->vdisplay;
+        if (current_area > area) {
+            mode = current_mode;
+            debug_printf("find_default_mode: found higher mode %dx%d\n", current_mode->hdisplay, current_mode->vdisplay);
+            area = current_area;
+        }
+    }
+    return mode;
+}
+
+/* drmModeGetConnectorCurrent() returns the state the kernel already knows
+ * without forcing a probe (which can mean a slow EDID read). Only fall back
+ * to a full probe when that state has no usable modes.
+ */
+static drmModeConnector* get_connector(int fd, uint32_t connector_id) {
+    drmModeConnector* connector = drmModeGetConnectorCurrent(fd, connector_id);
+
+    if (connector && connector->connection == DRM_MODE_CONNECTED && connector->count_modes > 0)
+        return connector;
+    drmModeFreeConnector(connector);
+    debug_printf("get_connector: drmModeGetConnector connector_id=%u (full probe)\n", connector_id);
+    return drmModeGetConnector(fd, connector_id);
+}
+
+static drmModeConnector* find_drm_connector(int fd, drmModeRes* resources,
+    int connector_id) {
+    drmModeConnector* connector = NULL;
+    int i;
+
+    if (connector_id >= 0) {
+        if (connector_id >= resources->count_connectors)
+            return NULL;
+        debug_puts("find_drm_connector: get_connector");
+        connector = get_connector(fd, resources->connectors[connector_id]);
+        if (connector && connector->connection == DRM_MODE_CONNECTED)
+            return connector;
+        debug_puts("find_drm_connector: drmModeFreeConnector");
+        drmModeFreeConnector(connector);
+        return NULL;
+    }
+
+    debug_printf("find_drm_connector: count_connectors=%d\n", resources->count_connectors);
+    for (i = 0; i < resources->count_connectors; i++) {
+        debug_printf("find_drm_connector: get_connector i=%d\n", i);
+        connector = get_connector(fd, resources->connectors[i]);
+        if (connector && connector->connection == DRM_MODE_CONNECTED) {
+            /* it's connected, let's use this! */
+            debug_printf("find_drm_connector: connector[%d] is CONNECTED.\n", i);
+            break;
+        }
+        debug_puts("find_drm_connector: drmModeFreeConnector");
+        drmModeFreeConnector(connector);
+        connector = NULL;
+    }
+
+    return connector;
+}
+
+static bool crtc_possible_for_connector(const struct drm* drm, const drmModeRes* resources,
+    const drmModeConnector* connector, uint32_t crtc_id) {
+    int crtc_index = find_crtc_index(resources, crtc_id);
+    bool possible = false;
+
+    if (crtc_index < 0)
+        return false;
+    for (int i = 0; i < connector->count_encoders && !possible; i++) {
+        drmModeEncoder* encoder = drmModeGetEncoder(drm->fd, connector->encoders[i]);
+
+        if (encoder) {
+            possible = encoder->crtc_id == crtc_id || (encoder->possible_crtcs & (1 << crtc_index));
+            drmModeFreeEncoder(encoder);
+        }
+    }
+    return possible;
+}
+
+/* Reuse the cached connector/CRTC/mode if it still matches the hardware and
+ * the request. Returns false (leaving drm untouched) when it does not.
+ */
+static bool use_cached_output(struct drm* drm, drmModeRes* resources, const struct startup_cache_output* cached,
+    const char* mode_str, int connector_id, unsigned int vrefresh) {
+    drmModeConnector* connector;
+    int i;
+
+    if (connector_id >= 0 && (connector_id >= resources->count_connectors || resources->connectors[connector_id] != cached->connector_id))
+        return false;
+    if (mode_str && *mode_str && (strcmp(cached->mode.name, mode_str) != 0 || (vrefresh && cached->mode.vrefresh != vrefresh)))
+        return false;
+
+    debug_printf("use_cached_output: drmModeGetConnectorCurrent connector_id=%u\n", cached->connector_id);
+    connector = drmModeGetConnectorCurrent(drm->fd, cached->connector_id);
+    if (!connector || connector->connection != DRM_MODE_CONNECTED)
+        goto invalid;
+
+    for (i = 0; i < connector->count_modes; i++) {
+        if (memcmp(&connector->modes[i], &cached->mode, sizeof(cached->mode)) == 0)
+            break;
+    }
+    if (i == connector->count_modes)
+        goto invalid;
+    if (!crtc_possible_for_connector(drm, resources, connector, cached->crtc_id))
+        goto invalid;
+
+    drm->connected_connector = connector;
+    drm->mode = &connector->modes[i];
+    drm->crtc_id = cached->crtc_id;
+    return true;
+
+invalid:
+    debug_puts("use_cached_output: cache entry is stale");
+    drmModeFreeConnector(connector);
+    return false;
+}
+
+static bool mode_timings_equal(const drmModeModeInfo* a, const drmModeModeInfo* b) {
+    return a->clock == b->clock &&
+        a->hdisplay == b->hdisplay && a->hsync_start == b->hsync_start &&
+        a->hsync_end == b->hsync_end && a->htotal == b->htotal && a->hskew == b->hskew &&
+        a->vdisplay == b->vdisplay && a->vsync_start == b->vsync_start &&
+        a->vsync_end == b->vsync_end && a->vtotal == b->vtotal && a->vscan == b->vscan &&
+        a->flags == b->flags;
+}
+
+/* Remember the CRTC configuration found at startup so it can be restored on
+ * exit, and whether it already drives our connector with our mode, in which
+ * case the first frame can be presented with a page flip (no modeset blank).
+ */
+static void save_crtc(const struct drm* drm, struct output* output) {
+    drmModeEncoder* encoder = NULL;
+
+    debug_printf("save_crtc: drmModeGetCrtc crtc_id=%u\n", output->crtc_id);
+    output->saved_crtc = drmModeGetCrtc(drm->fd, output->crtc_id);
+    if (!output->saved_crtc || !output->saved_crtc->mode_valid || !output->saved_crtc->buffer_id)
+        return;
+
+    if (output->connector->encoder_id)
+        encoder = drmModeGetEncoder(drm->fd, output->connector->encoder_id);
+    output->reuse_crtc = encoder && encoder->crtc_id == output->crtc_id &&
+        mode_timings_equal(&output->saved_crtc->mode, output->mode);
+    drmModeFreeEncoder(encoder);
+    if (output->reuse_crtc)
+        debug_printf("save_crtc: crtc_id=%u already shows %s, skipping modeset\n", output->crtc_id, output->mode->name);
+}
+
+int init_drm(struct drm* drm, const char* device, const char* mode_str, int connector_id, unsigned int vrefresh, unsigned int count, bool nonblocking) {
+    drmModeRes* resources = NULL;
+    drmModeEncoder* encoder = NULL;
+    struct startup_cache_output cached;
+    bool have_cached;
+    int phase = startup_trace_begin("init_drm"), step;
+    int i, ret;
+
+    step = startup_trace_begin("find_drm_device");
+    have_cached = startup_cache_load_output(device, &cached);
+
+    if (device) {
+        drm->fd = open(device, O_RDWR | O_CLOEXEC);
+        ret = get_resources(drm->fd, &resources);
+        if (ret < 0 && errno == EOPNOTSUPP)
+            printf("%s does not look like a modeset device\n", device);
+        snprintf(drm->device_path, sizeof(drm->device_path), "%s", device);
+    } else {
+        /* try the last used device before enumerating all of them */
+        drm->fd = have_cached ? open(cached.device, O_RDWR | O_CLOEXEC) : -1;
+        if (drm->fd >= 0 && get_resources(drm->fd, &resources) == 0) {
+            printf("Opening DRM device %s (cached)\n", cached.device);
+            snprintf(drm->device_path, sizeof(drm->device_path), "%s", cached.device);
+        } else {
+            if (drm->fd >= 0)
+                close(drm->fd);
+            have_cached = false;
+            drm->fd = find_drm_device(&resources, drm->device_path, sizeof(drm->device_path));
+        }
+    }
+    startup_trace_end(step);
+
+    if (drm->fd < 0) {
+        printf("could not open drm device\n");
+        return -1;
+    }
+
+    if (!resources) {
+        printf("drmModeGetResources failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    step = startup_trace_begin("connector probing");
+    if (have_cached && use_cached_output(drm, resources, &cached, mode_str, connector_id, vrefresh)) {
+        debug_printf("init_drm: using cached connector_id=%u crtc_id=%u mode %s\n", cached.connector_id, cached.crtc_id, cached.mode.name);
+        goto found_crtc;
+    }
+
+    /* find a connected connector: */
+    drm->connected_connector = find_drm_connector(drm->fd, resources, connector_id);
+    if (!drm->connected_connector) {
+        /* we could be fancy and listen for hotplug events and wait for
+         * a connector..
+         */
+        printf("no connected connector!\n");
+        return -1;
+    }
+
+    /* find user requested mode: */
+    if (mode_str && *mode_str) {
+        for (i = 0; i < drm->connected_connector->count_modes; i++) {
+            drmModeModeInfo* current_mode = &drm->connected_connector->modes[i];
+
+            if (strcmp(current_mode->name, mode_str) == 0) {
+                if (vrefresh == 0 || current_mode->vrefresh == vrefresh) {
+                    drm->mode = current_mode;
+                    debug_printf("init_drm: found requested mode %dx%d\n", current_mode->hdisplay, current_mode->vdisplay);
+                    break;
+                }
+            }
+        }
+        if (!drm->mode)
+            debug_printf("init_drm: requested mode not found, using default mode!\n");
+    }
+
+    /* find preferred mode or the highest resolution mode: */
+    if (!drm->mode)
+        drm->mode = find_default_mode(drm->connected_connector);
+
+    if (!drm->mode) {
+        printf("init_drm: could not find mode!\nSelect valid mode:\n");
+        for (i = 0; i < drm->connected_connector->count_modes; i++) {
+            drmModeModeInfo* current_mode = &drm->connected_connector->modes[i];
+            if (current_mode->type & DRM_MODE_TYPE_PREFERRED) {
+                printf("[%d] %s %dx%d #\n", i, current_mode->name, current_mode->hdisplay, current_mode->vdisplay);
+            } else {
+                printf("[%d] %s %dx%d\n", i, current_mode->name, current_mode->hdisplay, current_mode->vdisplay);
+            }
+        }
+        return -1;
+    }
+
+    /* find encoder: the connector already tells which one it is bound to */
+    if (drm->connected_connector->encoder_id) {
+        debug_puts("drmModeGetEncoder");
+        encoder = drmModeGetEncoder(drm->fd, drm->connected_connector->encoder_id);
+    }
+
+    if (encoder && encoder->crtc_id) {
+        drm->crtc_id = encoder->crtc_id;
+        drmModeFreeEncoder(encoder);
+    } else {
+        drmModeFreeEncoder(encoder);
+        int32_t crtc_id = find_crtc_for_connector(drm, resources, drm->connected_connector);
+        if (crtc_id == -1) {
+            printf("init_drm: no crtc found!\n");
+            return -1;
+        }
+        drm->crtc_id = crtc_id;
+    }
+    debug_printf("init_drm: using encoder crtc_id=%d\n", drm->crtc_id);
+
+found_crtc:
+    startup_trace_end(step);
+    drm->crtc_index = find_crtc_index(resources, drm->crtc_id);
+    debug_printf("init_drm: using crtc_index=%d\n", drm->crtc_index);
+    debug_puts("drmModeFreeResources");
+    drmModeFreeResources(resources);
+    drm->connector_id = drm->connected_connector->connector_id;
+    drm->count = count;
+    drm->nonblocking = nonblocking;
+
+    drm->outputs[0] = (struct output) {
+        .connector_id = drm->connector_id,
+        .crtc_id = drm->crtc_id,
+        .crtc_index = drm->crtc_index,
+        .connector = drm->connected_connector,
+        .mode = drm->mode,
+    };
+    drm->num_outputs = 1;
+    save_crtc(drm, &drm->outputs[0]);
+
+    cached = (struct startup_cache_output) {
+        .connector_id = drm->connector_id,
+        .crtc_id = drm->crtc_id,
+        .mode = *drm->mode,
+    };
+    snprintf(cached.device, sizeof(cached.device), "%s", drm->device_path);
+    if (startup_cache_store_output(&cached))
+        debug_puts("init_drm: failed to write startup cache");
+    startup_trace_end(phase);
+    return 0;
+}
+
+/* Add every other connected connector that can get a free CRTC as an extra
+ * output, using its preferred mode. Call after init_drm().
+ */
+int init_drm_outputs(struct drm* drm) {
+    drmModeRes* resources;
+    int i;
+
+    if (get_resources(drm->fd, &resources))
+        return -1;
+
+    for (i = 0; i < resources->count_connectors && drm->num_outputs < MAX_OUTPUTS; i++) {
+        struct output* output = &drm->outputs[drm->num_outputs];
+        drmModeConnector* connector;
+        drmModeEncoder* encoder = NULL;
+        int32_t crtc_id = -1;
+
+        if (resources->connectors[i] == drm->connector_id)
+            continue;
+        debug_printf("init_drm_outputs: drmModeGetConnector i=%d\n", i);
+        connector = drmModeGetConnector(drm->fd, resources->connectors[i]);
+        if (!connector || connector->connection != DRM_MODE_CONNECTED || !find_default_mode(connector)) {
+            drmModeFreeConnector(connector);
+            continue;
+        }
+
+        /* keep the CRTC the connector is already routed to, if still free */
+        if (connector->encoder_id)
+            encoder = drmModeGetEncoder(drm->fd, connector->encoder_id);
+        if (encoder) {
+            if (encoder->crtc_id && !crtc_in_use(drm, encoder->crtc_id))
+                crtc_id = encoder->crtc_id;
+            drmModeFreeEncoder(encoder);
+        }
+        if (crtc_id == -1)
+            crtc_id = find_crtc_for_connector(drm, resources, connector);
+        if (crtc_id == -1) {
+            printf("init_drm_outputs: no free crtc for connector %u\n", connector->connector_id);
+            drmModeFreeConnector(connector);
+            continue;
+        }
+
+        *output = (struct output) {
+            .connector_id = connector->connector_id,
+            .crtc_id = crtc_id,
+            .crtc_index = find_crtc_index(resources, crtc_id),
+            .connector = connector,
+            .mode = find_default_mode(connector),
+        };
+        printf("init_drm_outputs: output[%d] connector=%u crtc=%u %dx%d@%u\n", drm->num_outputs,
+            output->connector_id, output->crtc_id, output->mode->hdisplay, output->mode->vdisplay, output->mode->vrefresh);
+        save_crtc(drm, output);
+        drm->num_outputs++;
+    }
+    drmModeFreeResources(resources);
+    return 0;
+}
+
+/* Put back the CRTC configuration found at startup (e.g. the console). Must run
+ * before our buffers are destroyed, as removing a scanned out fb turns the
+ * CRTC off.
+ */
+void restore_drm(struct drm* drm) {
+    for (int i = 0; i < drm->num_outputs; i++) {
+        struct output* output = &drm->outputs[i];
+        drmModeCrtc* saved = output->saved_crtc;
+
+        if (!saved)
+            continue;
+        if (saved->mode_valid && saved->buffer_id) {
+            debug_printf("restore_drm: drmModeSetCrtc crtc_id=%u buffer_id=%u\n", saved->crtc_id, saved->buffer_id);
+            if (drmModeSetCrtc(drm->fd, saved->crtc_id, saved->buffer_id, saved->x, saved->y, &output->connector_id, 1, &saved->mode))
+                printf("restore_drm: failed to restore crtc %u: %s\n", saved->crtc_id, strerror(errno));
+        }
+        drmModeFreeCrtc(saved);
+        output->saved_crtc = NULL;
+    }
+}
+
+/* Look up the primary plane of every output so flips can carry FB_DAMAGE_CLIPS.
+ * That property only exists for atomic clients; without it (or without atomic
+ * support) outputs keep using legacy page flips and only EGL sees the damage.
+ */
+void init_damage(struct drm* drm) {
+    drm->damage = true;
+    if (PROFILE_DAMAGE_CLIPS == 0) {
+        printf("init_damage: no FB_DAMAGE_CLIPS on %s\n", PROFILE_NAME);
+        return;
+    }
+    if (drmSetClientCap(drm->fd, DRM_CLIENT_CAP_ATOMIC, 1)) {
+        printf("init_damage: no atomic modesetting, FB_DAMAGE_CLIPS disabled\n");
+        return;
+    }
+    for (int i = 0; i < drm->num_outputs; i++) {
+        struct output* output = &drm->outputs[i];
+
+        output->plane_id = find_plane(drm->fd, output->crtc_id, output->crtc_index, DRM_PLANE_TYPE_PRIMARY);
+        if (!output->plane_id)
+            continue;
+        output->fb_id_prop = get_prop_id(drm->fd, output->plane_id, DRM_MODE_OBJECT_PLANE, "FB_ID");
+        output->damage_clips_prop = get_prop_id(drm->fd, output->plane_id, DRM_MODE_OBJECT_PLANE, "FB_DAMAGE_CLIPS");
+        if (!output->fb_id_prop || !output->damage_clips_prop)
+            output->plane_id = 0;
+        printf("init_damage: crtc %u FB_DAMAGE_CLIPS %s\n", output->crtc_id,
+            output->plane_id ? "supported" : "not supported");
+    }
+}
+
+/* Scanout modifiers for the GBM surface: what the primary plane can scan out
+ * (IN_FORMATS) and EGL can render to. GBM picks the best layout among them
+ * (tiled, compressed) instead of linear, which costs memory bandwidth.
+ */
+static void negotiate_modifiers(const struct drm* drm, struct gbm* gbm) {
+    uint64_t plane_modifiers[MAX_PLANE_MODIFIERS], egl_modifiers[MAX_PLANE_MODIFIERS];
+    EGLBoolean external_only[MAX_PLANE_MODIFIERS];
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = NULL;
+    PFNEGLQUERYDMABUFMODIFIERSEXTPROC query_modifiers = NULL;
+    EGLDisplay display;
+    struct ext_set client_exts = { 0 }, display_exts = { 0 };
+    EGLint num_egl = -1;
+    uint32_t plane_id;
+    int num_plane = 0;
+
+    /* the primary plane is only visible to universal plane clients */
+    drmSetClientCap(drm->fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+    plane_id = find_plane(drm->fd, drm->crtc_id, drm->crtc_index, DRM_PLANE_TYPE_PRIMARY);
+    if (plane_id)
+        num_plane = plane_format_modifiers(drm->fd, plane_id, gbm->format, plane_modifiers, MAX_PLANE_MODIFIERS);
+
+    /* init_egl() gets the same display again, initializing it twice is harmless */
+    ext_set_init(&client_exts, eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS));
+    if (ext_set_has(&client_exts, "EGL_EXT_platform_base"))
+        get_platform_display = (void*) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    ext_set_free(&client_exts);
+    display = get_platform_display ? get_platform_display(EGL_PLATFORM_GBM_KHR, gbm->dev, NULL) :
+        eglGetDisplay((EGLNativeDisplayType) gbm->dev);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+        ext_set_init(&display_exts, eglQueryString(display, EGL_EXTENSIONS));
+    if (ext_set_has(&display_exts, "EGL_EXT_image_dma_buf_import_modifiers"))
+        query_modifiers = (void*) eglGetProcAddress("eglQueryDmaBufModifiersEXT");
+    ext_set_free(&display_exts);
+    if (query_modifiers &&
+        !query_modifiers(display, gbm->format, MAX_PLANE_MODIFIERS, egl_modifiers, external_only, &num_egl))
+        num_egl = -1;
+
+    gbm->num_modifiers = 0;
+    if (num_egl < 0) {
+        /* EGL cannot tell which of the plane's tiled or compressed layouts it
+         * renders to: leave the choice to the implicit path, where the driver
+         * allocates for scanout and rendering at once
+         */
+        printf("negotiate_modifiers: no EGL modifier query, using an implicit layout\n");
+        return;
+    }
+    for (int i = 0; i < num_plane; i++) {
+        bool usable = false;
+
+        /* external_only modifiers can be sampled but not rendered to */
+        for (int j = 0; j < num_egl; j++)
+            usable |= egl_modifiers[j] == plane_modifiers[i] && !external_only[j];
+        if (usable)
+            gbm->modifiers[gbm->num_modifiers++] = plane_modifiers[i];
+    }
+    if (!gbm->num_modifiers)
+        gbm->modifiers[gbm->num_modifiers++] = DRM_FORMAT_MOD_LINEAR;
+    printf("negotiate_modifiers: %d scanout modifiers (plane %d, EGL %d)\n", gbm->num_modifiers, num_plane, num_egl);
+    for (int i = 0; i < gbm->num_modifiers; i++)
+        debug_printf("  0x%016" PRIx64 "\n", gbm->modifiers[i]);
+}
+
+/* The primary plane has to scan out the requested format, else fall back to
+ * XRGB8888, which every KMS driver supports
+ */
+static uint32_t check_scanout_format(const struct drm* drm, uint32_t format) {
+    uint32_t plane_id;
+
+    drmSetClientCap(drm->fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+    plane_id = find_plane(drm->fd, drm->crtc_id, drm->crtc_index, DRM_PLANE_TYPE_PRIMARY);
+    if (!plane_id || plane_supports(drm->fd, plane_id, format, DRM_FORMAT_MOD_INVALID))
+        return format;
+    printf("check_scanout_format: primary plane cannot scan out %.4s, using XRGB8888\n", (const char*) &format);
+    return DRM_FORMAT_XRGB8888;
+}
+
+/* Create gbm->surface with one of gbm->modifiers, falling back to an
+ * implicit layout when explicit modifiers are not supported
+ */
+int init_surface(struct gbm* gbm) {
+    if (gbm->num_modifiers && gbm_surface_create_with_modifiers) {
+        debug_printf("init_surface: gbm_surface_create_with_modifiers gbm.device:%p gbm.width=%d gbm.height=%d, gbm.format=%d modifiers=%d\n", gbm->dev, gbm->width, gbm->height, gbm->format, gbm->num_modifiers);
+        gbm->surface = gbm_surface_create_with_modifiers(gbm->dev, gbm->width, gbm->height, gbm->format, gbm->modifiers, gbm->num_modifiers);
+    }
+
+    if (!gbm->surface) {
+        if (gbm->num_modifiers)
+            debug_printf("Modifiers requested but support isn't available\n");
+        debug_printf("init_surface: gbm_surface_create gbm.device:%p gbm.width=%d gbm.height=%d, gbm.format=%d flags=%d\n", gbm->dev, gbm->width, gbm->height, gbm->format, GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING);
+        gbm->surface = gbm_surface_create(gbm->dev, gbm->width, gbm->height, gbm->format, GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING);
+    }
+    if (!gbm->surface) {
+        puts("init_surface: failed to create gbm surface");
+        return -3;
+    }
+    printf("init_surface: %dx%d created\n", gbm->width, gbm->height);
+    return 0;
+}
+
+/* With force_linear the surface is linear, as before modifier negotiation */
+int init_gbm(struct gbm* gbm, const struct drm* drm, int w, int h, uint32_t format, bool force_linear) {
+    int phase = startup_trace_begin("init_gbm"), ret;
+
+    debug_printf("init_gbm: gbm_create_device drm_fd=%d\n", drm->fd);
+    gbm->dev = gbm_create_device(drm->fd);
+    if (!gbm->dev)
+        return -1;
+    gbm->device = drm->device_path;
+
+    gbm->format = check_scanout_format(drm, format);
+    gbm->modifier = DRM_FORMAT_MOD_INVALID;
+    gbm->surface = NULL;
+
+    debug_printf("init_gbm: request width=%d height=%d\n", w, h);
+    gbm->width = w;
+    gbm->height = h;
+
+    if (force_linear) {
+        gbm->modifiers[0] = DRM_FORMAT_MOD_LINEAR;
+        gbm->num_modifiers = 1;
+    } else if (PROFILE_MODIFIERS == 0) {
+        gbm->num_modifiers = 0;
+    } else {
+        negotiate_modifiers(drm, gbm);
+    }
+    ret = init_surface(gbm);
+    startup_trace_end(phase);
+    return ret;
+}
+
+/* Bits per pixel the config costs beyond the color buffer: depth, stencil and
+ * samples nobody asked for still take memory and bandwidth every frame. -1 if
+ * the config does not meet attribs (minimum sizes, required bits) or visual_id.
+ */
+static int score_config(EGLDisplay egl_display, EGLConfig config, const EGLint* attribs, EGLint visual_id) {
+    EGLint value, buffer_size = 0, samples = 0, depth = 0, stencil = 0, caveat = EGL_NONE;
+
+    /* what eglChooseConfig() checked, again for configs that did not come from it */
+    for (const EGLint* attrib = attribs; *attrib != EGL_NONE; attrib += 2) {
+        if (!eglGetConfigAttrib(egl_display, config, attrib[0], &value))
+            return -1;
+        if (attrib[0] == EGL_SURFACE_TYPE || attrib[0] == EGL_RENDERABLE_TYPE ?
+            (value & attrib[1]) != attrib[1] : value < attrib[1])
+            return -1;
+    }
+    if (visual_id && (!eglGetConfigAttrib(egl_display, config, EGL_NATIVE_VISUAL_ID, &value) || value != visual_id))
+        return -1;
+
+    eglGetConfigAttrib(egl_display, config, EGL_BUFFER_SIZE, &buffer_size);
+    eglGetConfigAttrib(egl_display, config, EGL_SAMPLES, &samples);
+    eglGetConfigAttrib(egl_display, config, EGL_DEPTH_SIZE, &depth);
+    eglGetConfigAttrib(egl_display, config, EGL_STENCIL_SIZE, &stencil);
+    eglGetConfigAttrib(egl_display, config, EGL_CONFIG_CAVEAT, &caveat);
+    /* slow (software) or non-conformant configs only when nothing else fits */
+    return (buffer_size + depth + stencil) * (samples > 1 ? samples : 1) + (caveat != EGL_NONE ? 4096 : 0);
+}
+
+/* The config with the lowest score among those matching attribs and visual_id
+ * (any visual if 0). eglChooseConfig() sorts the most color bits first, 10 bit
+ * before 8 bit, and leaves the visual to us: its first match is rarely the
+ * cheapest.
+ */
+static bool egl_choose_config(EGLDisplay egl_display, const EGLint* attribs,
+    EGLint visual_id, EGLConfig* config_out) {
+    EGLint count = 0;
+    EGLint matched = 0;
+    EGLConfig* configs;
+    int config_index = -1, best_score = 0;
+
+    if (!eglGetConfigs(egl_display, NULL, 0, &count) || count < 1) {
+        printf("egl_choose_config: No EGL configs to choose from.\n");
+        return false;
+    }
+    configs = malloc(count * sizeof * configs);
+    if (!configs)
+        return false;
+
+    if (!eglChooseConfig(egl_display, attribs, configs, count, &matched) || !matched) {
+        debug_printf("egl_choose_config: No EGL configs with appropriate attributes.\n");
+        goto out;
+    }
+    for (int i = 0; i < matched; i++) {
+        int score = score_config(egl_display, configs[i], attribs, visual_id);
+
+        if (score >= 0 && (config_index == -1 || score < best_score)) {
+            config_index = i;
+            best_score = score;
+        }
+    }
+    if (config_index != -1) {
+        *config_out = configs[config_index];
+        debug_printf("egl_choose_config: Use index [%d] of %d matched EGL configs, %d bits per pixel\n",
+            config_index, matched, best_score);
+    } else {
+        puts("egl_choose_config: Visual ID NOT FOUND");
+    }
+
+out:
+    free(configs);
+    if (config_index == -1)
+        return false;
+
+    return true;
+}
+
+/* The config a previous run chose for the same request, if it still meets it */
+static bool egl_cached_config(EGLDisplay egl_display, const EGLint* attribs, EGLint visual_id,
+    EGLint config_id, EGLConfig* config_out) {
+    const EGLint id_attribs[] = { EGL_CONFIG_ID, config_id, EGL_NONE };
+    EGLint matched = 0;
+
+    return eglChooseConfig(egl_display, id_attribs, config_out, 1, &matched) && matched == 1 &&
+        score_config(egl_display, *config_out, attribs, visual_id) >= 0;
+}
+
+static const EGLint context_attribs[] = {
+    EGL_CONTEXT_CLIENT_VERSION, 2,
+    EGL_NONE
+};
+
+/* Bind api and create the render context on a config that can render with it.
+ * config_attribs[renderable] is the EGL_RENDERABLE_TYPE value.
+ */
+static int create_context(struct egl* egl, const struct gbm* gbm, EGLint* config_attribs, int renderable, enum gl_api api) {
+    const char* name = api == GL_API_GL ? "EGL_OPENGL_API" : "EGL_OPENGL_ES_API";
+    const char* device = gbm->device ? gbm->device : "surfaceless";
+    EGLint visual_id = gbm->dev ? (EGLint) gbm->format : 0, config_id;
+    char request[128];
+    int phase, n;
+
+    debug_printf("init_egl: eglBindAPI %s\n", name);
+    if (!eglBindAPI(api == GL_API_GL ? EGL_OPENGL_API : EGL_OPENGL_ES_API)) {
+        printf("init_egl: failed to bind api %s\n", name);
+        return -1;
+    }
+    config_attribs[renderable] = api == GL_API_GL ? EGL_OPENGL_BIT : EGL_OPENGL_ES2_BIT;
+    debug_puts("init_egl: egl_choose_config");
+    phase = startup_trace_begin("egl_choose_config");
+    /* the request is everything the choice depends on: API, visual and attribute values */
+    n = snprintf(request, sizeof(request), "%s-%x", api == GL_API_GL ? "gl" : "gles", visual_id);
+    for (int i = 1; config_attribs[i - 1] != EGL_NONE && n < (int) sizeof(request); i += 2)
+        n += snprintf(request + n, sizeof(request) - n, "-%x", config_attribs[i]);
+    if (startup_cache_load_config(device, request, &config_id) &&
+        egl_cached_config(egl->display, config_attribs, visual_id, config_id, &egl->config)) {
+        debug_printf("init_egl: using cached config %d\n", config_id);
+    } else {
+        if (!egl_choose_config(egl->display, config_attribs, visual_id, &egl->config)) {
+            printf("init_egl: failed to choose config for %s\n", name);
+            return -1;
+        }
+        if (eglGetConfigAttrib(egl->display, egl->config, EGL_CONFIG_ID, &config_id) &&
+            startup_cache_store_config(device, request, config_id))
+            debug_puts("init_egl: failed to write startup cache");
+    }
+    startup_trace_end(phase);
+    debug_printf("init_egl: eglCreateContext egl.display=%p egl.config=%p\n", egl->display, egl->config);
+    phase = startup_trace_begin("eglCreateContext");
+    egl->context = eglCreateContext(egl->display, egl->config, EGL_NO_CONTEXT, context_attribs);
+    startup_trace_end(phase);
+    if (egl->context == EGL_NO_CONTEXT) {
+        printf("init_egl: failed to create context for %s\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+int init_egl(struct egl* egl, const struct gbm* gbm, int samples, int depth, int stencil, enum gl_api api) {
+    EGLint major, minor;
+
+    const struct pixel_format* pixel_format = pixel_format_by_fourcc(gbm->format);
+    EGLint config_attribs[32];
+    int n = 0, renderable;
+
+    const char* egl_exts_client, * egl_exts_dpy;
+    GLint gl_major = 0;
+    int phase = startup_trace_begin("init_egl"), step;
+
+#define get_proc_client(ext, name) do { \
+		if (ext_set_has(&egl->client_exts, #ext)) { \
+            egl->name = (void *)eglGetProcAddress(#name); \
+		} \
+    } while (0)
+#define get_proc_dpy(ext, name) do { \
+		if (ext_set_has(&egl->display_exts, #ext)) { \
+			egl->name = (void*) eglGetProcAddress(#name); \
+		} \
+    } while (0)
+
+#define get_proc_gl(ext, name) do { \
+		if (ext_set_has(&egl->gl_exts, #ext)) {\
+			egl->name = (void*) eglGetProcAddress(#name); \
+		} \
+    } while (0)
+
+    if (!pixel_format) {
+        printf("init_egl: unsupported format %.4s\n", (const char*) &gbm->format);
+        return -1;
+    }
+    /* channel sizes of the scanout format; the visual id picks the exact match */
+    config_attribs[n++] = EGL_SURFACE_TYPE;
+    config_attribs[n++] = gbm->dev ? EGL_WINDOW_BIT : EGL_PBUFFER_BIT;
+    config_attribs[n++] = EGL_RED_SIZE;
+    config_attribs[n++] = pixel_format->red;
+    config_attribs[n++] = EGL_GREEN_SIZE;
+    config_attribs[n++] = pixel_format->green;
+    config_attribs[n++] = EGL_BLUE_SIZE;
+    config_attribs[n++] = pixel_format->blue;
+    config_attribs[n++] = EGL_ALPHA_SIZE;
+    config_attribs[n++] = pixel_format->alpha;
+    /* only what the app renders with: the scoring keeps the rest at 0 */
+    config_attribs[n++] = EGL_DEPTH_SIZE;
+    config_attribs[n++] = depth;
+    config_attribs[n++] = EGL_STENCIL_SIZE;
+    config_attribs[n++] = stencil;
+    config_attribs[n++] = EGL_RENDERABLE_TYPE;
+    renderable = n;
+    config_attribs[n++] = EGL_OPENGL_ES2_BIT;
+    config_attribs[n++] = EGL_SAMPLES;
+    config_attribs[n++] = samples;
+    config_attribs[n] = EGL_NONE;
+
+    egl_exts_client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    ext_set_init(&egl->client_exts, egl_exts_client);
+    get_proc_client(EGL_EXT_platform_base, eglGetPlatformDisplayEXT);
+
+    if (!gbm->dev) {
+        /* headless: no GBM, no display, only a GPU or the software rasterizer */
+        if (!ext_set_has(&egl->client_exts, "EGL_MESA_platform_surfaceless") || !egl->eglGetPlatformDisplayEXT) {
+            printf("init_egl: headless needs EGL_MESA_platform_surfaceless\n");
+            return -1;
+        }
+        egl->display = egl->eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    } else if (egl->eglGetPlatformDisplayEXT) {
+        debug_printf("init_egl: eglGetPlatformDisplayEXT device=%p\n", gbm->dev);
+        egl->display = egl->eglGetPlatformDisplayEXT(EGL_PLATFORM_GBM_KHR, gbm->dev, NULL);
+    } else {
+        debug_printf("init_egl: eglGetDisplay device=%p\n", gbm->dev);
+        egl->display = eglGetDisplay((EGLNativeDisplayType) gbm->dev);
+    }
+
+    debug_printf("init_egl: eglInitialize egl.display=%p\n", egl->display);
+    step = startup_trace_begin("eglInitialize");
+    if (!eglInitialize(egl->display, &major, &minor)) {
+        debug_printf("failed to initialize\n");
+        return -1;
+    }
+    startup_trace_end(step);
+    egl_exts_dpy = eglQueryString(egl->display, EGL_EXTENSIONS);
+    ext_set_init(&egl->display_exts, egl_exts_dpy);
+    egl->modifiers_supported = ext_set_has(&egl->display_exts, "EGL_EXT_image_dma_buf_import_modifiers");
+    get_proc_dpy(EGL_KHR_swap_buffers_with_damage, eglSwapBuffersWithDamageKHR);
+    if (!egl->eglSwapBuffersWithDamageKHR && ext_set_has(&egl->display_exts, "EGL_EXT_swap_buffers_with_damage"))
+        egl->eglSwapBuffersWithDamageKHR = (void*) eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+    get_proc_dpy(EGL_KHR_partial_update, eglSetDamageRegionKHR);
+    egl->buffer_age = ext_set_has(&egl->display_exts, "EGL_EXT_buffer_age") ||
+        ext_set_has(&egl->display_exts, "EGL_KHR_partial_update");
+
+    // printf("init_egl: using EGL Library version %d.%d\n", major, minor);
+    debug_printf("\n===================================\n");
+    printf("EGL information:\n");
+    printf("  version: %s\n", eglQueryString(egl->display, EGL_VERSION));
+    printf("  vendor: %s\n", eglQueryString(egl->display, EGL_VENDOR));
+    printf("  profile: %s\n", PROFILE_NAME);
+    debug_printf("  client extensions: \"%s\"\n", egl_exts_client);
+    debug_printf("  display extensions: \"%s\"\n", egl_exts_dpy);
+    debug_printf("===================================\n");
+
+    /* OpenGL ES first: it is what the SoC drivers are built around, and the
+     * only API that samples dma-bufs as external textures. Desktop drivers run
+     * both on the same backend, so nothing is lost there.
+     */
+    if (api == GL_API_AUTO)
+        api = PROFILE_API;
+    if (api != GL_API_GL && !create_context(egl, gbm, config_attribs, renderable, GL_API_GLES))
+        egl->api = GL_API_GLES;
+    else if (api != GL_API_GLES && !create_context(egl, gbm, config_attribs, renderable, GL_API_GL))
+        egl->api = GL_API_GL;
+    else
+        return -1;
+    current_api = egl->api;
+    /* shares textures and buffers with the render context, for the loader thread */
+    if (ext_set_has(&egl->display_exts, "EGL_KHR_surfaceless_context"))
+        egl->loader_context = eglCreateContext(egl->display, egl->config, egl->context, context_attribs);
+    if (!gbm->dev) {
+        const EGLint pbuffer_attribs[] = { EGL_WIDTH, gbm->width, EGL_HEIGHT, gbm->height, EGL_NONE };
+
+        egl->surface = eglCreatePbufferSurface(egl->display, egl->config, pbuffer_attribs);
+        if (egl->surface == EGL_NO_SURFACE) {
+            printf("init_egl: failed to create %dx%d pbuffer\n", gbm->width, gbm->height);
+            return -1;
+        }
+    } else if (!gbm->surface) {
+        egl->surface = EGL_NO_SURFACE;
+    } else {
+        debug_printf("init_egl: eglCreateWindowSurface egl.display=%p egl.config=%p gbm.surface=%p\n", egl->display, egl->config, gbm->surface);
+        egl->surface = eglCreateWindowSurface(egl->display, egl->config, (EGLNativeWindowType) gbm->surface, NULL);
+        if (egl->surface == EGL_NO_SURFACE) {
+            printf("init_egl: failed to create egl surface\n");
+            return -1;
+        }
+    }
+    /* connect the context to the surface */
+    debug_printf("init_egl: eglMakeCurrent egl.display=%p egl.surface=%p egl.context=%p\n", egl->display, egl->surface, egl->context);
+    eglMakeCurrent(egl->display, egl->surface, egl->surface, egl->context);
+
+    /* the entry points we use have the same names in GL and GLES: one loader
+     * serves both, loaded from the context that will call them
+     */
+#ifdef GL_LAZY_LOAD
+    step = startup_trace_begin("gladLoadGLES2LoaderLazy");
+    if (!gladLoadGLES2LoaderLazy((GLADloadproc) eglGetProcAddress, gl_preload)) {
+#else
+    step = startup_trace_begin("gladLoadGLES2Loader");
+    if (!gladLoadGLES2Loader((GLADloadproc) eglGetProcAddress)) {
+#endif
+        printf("init_egl: failed to load the GL functions\n");
+        return -1;
+    }
+    startup_trace_end(step);
+    ext_set_init(&egl->gl_exts, (const char*) glGetString(GL_EXTENSIONS));
+    if (egl->api == GL_API_GL) {
+        /* GL_MAJOR_VERSION needs OpenGL 3.0 */
+        sscanf((const char*) glGetString(GL_VERSION), "%d", &gl_major);
+        egl->etc2 = ext_set_has(&egl->gl_exts, "GL_ARB_ES3_compatibility");
+        egl->sync = ext_set_has(&egl->gl_exts, "GL_ARB_sync");
+    } else {
+        /* an OpenGL ES 2.0 context does not know the query either and leaves 0 */
+        glGetIntegerv(GL_MAJOR_VERSION, &gl_major);
+        egl->etc2 = egl->sync = gl_major >= 3;
+    }
+    egl->gl_major = gl_major ? gl_major : 2;
+    egl->astc = ext_set_has(&egl->gl_exts, "GL_KHR_texture_compression_astc_ldr");
+    egl->invalidate_framebuffer = egl->api == GL_API_GL ?
+        ext_set_has(&egl->gl_exts, "GL_ARB_invalidate_subdata") : gl_major >= 3;
+    if (!egl->invalidate_framebuffer && egl->api == GL_API_GLES &&
+        ext_set_has(&egl->gl_exts, "GL_EXT_discard_framebuffer"))
+        egl->discard_framebuffer_ext = (void*) eglGetProcAddress("glDiscardFramebufferEXT");
+    printf("%s information:\n", egl->api == GL_API_GL ? "OpenGL" : "OpenGL ES");
+    printf("  version: %s\n", glGetString(GL_VERSION));
+    printf("  shading language version: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
+    printf("  vendor: %s\n", glGetString(GL_VENDOR));
+    debug_printf("  renderer: %s\n", glGetString(GL_RENDERER));
+    debug_printf("===================================\n");
+    EGLint red_size, green_size, blue_size, alpha_size, depth_size, stencil_size, surface_type, render_type;
+    eglGetConfigAttrib(egl->display, egl->config, EGL_RED_SIZE, &red_size);
+    eglGetConfigAttrib(egl->display, egl->config, EGL_GREEN_SIZE, &green_size);
+    eglGetConfigAttrib(egl->display, egl->config, EGL_BLUE_SIZE, &blue_size);
+    eglGetConfigAttrib(egl->display, egl->config, EGL_ALPHA_SIZE, &alpha_size);
+    eglGetConfigAttrib(egl->display, egl->config, EGL_DEPTH_SIZE, &depth_size);
+    eglGetConfigAttrib(egl->display, egl->config, EGL_STENCIL_SIZE, &stencil_size);
+    eglGetConfigAttrib(egl->display, egl->config, EGL_SURFACE_TYPE, &surface_type);
+    eglGetConfigAttrib(egl->display, egl->config, EGL_RENDERABLE_TYPE, &render_type);
+    debug_printf("init_egl: chosen config R:%d G:%d B:%d A:%d Depth:%d Stencil:%d Surface=0x%08X Render=0x%08X\n", red_size, green_size, blue_size, alpha_size, depth_size, stencil_size, surface_type, render_type);
+    egl->depth_size = depth_size;
+    egl->stencil_size = stencil_size;
+    egl->discard_depth_stencil = (egl->invalidate_framebuffer || egl->discard_framebuffer_ext) &&
+        (depth_size || stencil_size);
+    startup_trace_end(phase);
+    return 0;
+}
+
+static void drm_fb_destroy_callback(struct gbm_bo* bo, void* data) {
+    debug_puts("drm_fb_destroy_callback: gbm_device_get_fd gbm_bo_get_device");
+    int drm_fd = gbm_device_get_fd(gbm_bo_get_device(bo));
+    struct drm_fb* fb = data;
+    if (fb->fb_id) {
+        debug_puts("drm_fb_destroy_callback: drmModeRmFB");
+        drmModeRmFB(drm_fd, fb->fb_id);
+    }
+    debug_puts("drm_fb_destroy_callback: free");
+    free(fb);
+}
+
+struct drm_fb* drm_fb_get_from_bo(struct gbm_bo* bo) {
+    debug_printf("drm_fb_get_from_bo: gbm_device_get_fd gbm_bo_get_device gbm_bo_get_user_data bo=%p\n", bo);
+    int drm_fd = gbm_device_get_fd(gbm_bo_get_device(bo));
+    struct drm_fb* fb = gbm_bo_get_user_data(bo);
+    uint32_t width, height, format,
+        strides[4] = { 0 }, handles[4] = { 0 },
+        offsets[4] = { 0 }, flags = 0;
+    int ret = -1;
+
+    if (fb)
+        return fb;
+
+    fb = calloc(1, sizeof * fb);
+    fb->bo = bo;
+
+    debug_puts("drm_fb_get_from_bo: gbm_bo_get_width gbm_bo_get_height gbm_bo_get_format");
+    width = gbm_bo_get_width(bo);
+    height = gbm_bo_get_height(bo);
+    format = gbm_bo_get_format(bo);
+
+    /* known targets skip the checks for GBM entry points they always have, or
+     * the whole modifier path if their buffers have no modifiers
+     */
+    if (profile_has(PROFILE_MODIFIERS, gbm_bo_get_handle_for_plane && gbm_bo_get_modifier &&
+        gbm_bo_get_plane_count && gbm_bo_get_stride_for_plane &&
+        gbm_bo_get_offset)) {
+
+        uint64_t modifier;
+        debug_puts("drm_fb_get_from_bo: gbm_bo_get_modifier gbm_bo_get_plane_count");
+        modifier = gbm_bo_get_modifier(bo);
+        const int num_planes = profile_has(PROFILE_FB_PLANES, gbm_bo_get_plane_count(bo));
+        for (int i = 0; i < num_planes; i++) {
+            debug_printf("drm_fb_get_from_bo: plane[%d] gbm_bo_get_handle_for_plane gbm_bo_get_stride_for_plane gbm_bo_get_offset\n", i);
+            handles[i] = gbm_bo_get_handle_for_plane(bo, i).u32;
+            strides[i] = gbm_bo_get_stride_for_plane(bo, i);
+            offsets[i] = gbm_bo_get_offset(bo, i);
+        }
+
+        if (modifier && modifier != DRM_FORMAT_MOD_INVALID) {
+            flags = DRM_MODE_FB_MODIFIERS;
+        }
+
+        debug_printf("drm_fb_get_from_bo: add_fb drm_fd=%d width=%d height=%d format=%d modifier=0x%" PRIx64 "\n", drm_fd, width, height, format, modifier);
+        ret = add_fb(drm_fd, width, height, format, handles, strides, offsets, modifier, &fb->fb_id);
+    }
+
+    if (ret) {
+        if (flags)
+            debug_puts("drm_fb_get_from_bo: Modifiers failed!");
+
+        memcpy(handles, (uint32_t[4]) { gbm_bo_get_handle(bo).u32, 0, 0, 0 }, 16);
+        memcpy(strides, (uint32_t[4]) { gbm_bo_get_stride(bo), 0, 0, 0 }, 16);
+        memset(offsets, 0, 16);
+        debug_printf("drm_fb_get_from_bo: drmModeAddFB2 drm_fd=%d width=%d height=%d format=%d fb.fb_id=%d\n", drm_fd, width, height, format, fb->fb_id);
+        ret = drmModeAddFB2(drm_fd, width, height, format, handles, strides, offsets, &fb->fb_id, 0);
+    }
+
+    if (ret) {
+        printf("drm_fb_get_from_bo: failed to create fb: %s\n", strerror(errno));
+        free(fb);
+        return NULL;
+    }
+    debug_puts("drm_fb_get_from_bo: gbm_bo_set_user_data");
+    gbm_bo_set_user_data(bo, fb, drm_fb_destroy_callback);
+    return fb;
+}
+
+/* Give outputs[0] the main surfaces and create a GBM + EGL surface for every
+ * extra output, sharing egl->config so one context can render to all of them.
+ */
+int init_output_surfaces(const struct gbm* gbm, const struct egl* egl, struct drm* drm) {
+    drm->outputs[0].surface = gbm->surface;
+    drm->outputs[0].egl_surface = egl->surface;
+
+    for (int i = 1; i < drm->num_outputs; i++) {
+        struct output* output = &drm->outputs[i];
+        struct gbm output_gbm = *gbm;
+        int ret;
+
+        output_gbm.surface = NULL;
+        output_gbm.width = output->mode->hdisplay;
+        output_gbm.height = output->mode->vdisplay;
+        ret = init_surface(&output_gbm);
+        if (ret)
+            return ret;
+        output->surface = output_gbm.surface;
+
+        debug_printf("init_output_surfaces: eglCreateWindowSurface output[%d] gbm.surface=%p\n", i, output->surface);
+        output->egl_surface = eglCreateWindowSurface(egl->display, egl->config, (EGLNativeWindowType) output->surface, NULL);
+        if (output->egl_surface == EGL_NO_SURFACE) {
+            printf("init_output_surfaces: failed to create egl surface for output[%d]\n", i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Fallback ladder for when the display rejects the buffers GBM allocated: drop
+ * their modifier from gbm->modifiers (after the last one comes linear, then
+ * the implicit layout) and recreate the output's surfaces. Returns a negative
+ * value when there is nothing left to try.
+ */
+static int downgrade_output_surface(struct gbm* gbm, struct egl* egl, struct drm* drm, struct output* output) {
+    uint64_t failed = gbm_bo_get_modifier(output->bo);
+    struct gbm output_gbm;
+    int n = 0;
+
+    if (!gbm->num_modifiers)
+        return -1;
+    for (int i = 0; i < gbm->num_modifiers; i++) {
+        if (gbm->modifiers[i] != failed)
+            gbm->modifiers[n++] = gbm->modifiers[i];
+    }
+    if (n == gbm->num_modifiers)
+        n = 0;  /* GBM did not use the list at all */
+    else if (n == 0 && failed != DRM_FORMAT_MOD_LINEAR)
+        gbm->modifiers[n++] = DRM_FORMAT_MOD_LINEAR;
+    gbm->num_modifiers = n;
+    printf("run_gl_loop: modifier 0x%016" PRIx64 " rejected, retrying with %s\n", failed,
+        n ? "the remaining modifiers" : "an implicit layout");
+
+    gbm_surface_release_buffer(output->surface, output->bo);
+    output->bo = NULL;
+    eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(egl->display, output->egl_surface);
+    gbm_surface_destroy(output->surface);
+
+    output_gbm = *gbm;
+    output_gbm.surface = NULL;
+    output_gbm.width = output->mode->hdisplay;
+    output_gbm.height = output->mode->vdisplay;
+    if (init_surface(&output_gbm))
+        return -1;
+    output->surface = output_gbm.surface;
+    output->egl_surface = eglCreateWindowSurface(egl->display, egl->config, (EGLNativeWindowType) output->surface, NULL);
+    if (output->egl_surface == EGL_NO_SURFACE) {
+        printf("run_gl_loop: failed to recreate egl surface\n");
+        return -1;
+    }
+    eglMakeCurrent(egl->display, output->egl_surface, output->egl_surface, egl->context);
+    if (output == &drm->outputs[0]) {
+        gbm->surface = output->surface;
+        egl->surface = output->egl_surface;
+    }
+    return 0;
+}
+
+static void page_flip_handler(int fd, unsigned int frame,
+    unsigned int sec, unsigned int usec, void* data) {
+/* suppress 'unused parameter' warnings */
+    (void) fd, (void) frame;
+
+    struct output* output = data;
+
+    /* sec/usec: CLOCK_MONOTONIC time of the flip, as are the input event timestamps */
+    if (output->input_time) {
+        input_latency_add(&output->input_latency, sec * NSEC_PER_SEC + usec * INT64_C(1000) - output->input_time);
+        output->input_time = 0;
+    }
+
+    /* release last buffer to render on again (none after a reused CRTC's first flip): */
+    if (output->bo) {
+        debug_printf("page_flip_handler: gbm_surface_release_buffer crtc_id=%d\n", output->crtc_id);
+        gbm_surface_release_buffer(output->surface, output->bo);
+    }
+    output->bo = output->next_bo;
+    output->next_bo = NULL;
+    output->waiting_for_flip = false;
+    output->frames++;
+    /* a reused CRTC flips to the buffer a modeset would have shown first */
+    if (output->frames == (output->reuse_crtc ? 2u : 1u))
+        startup_trace_first_frame();
+
+    /* Start fps measuring on second frame, to remove the time spent
+     * compiling shader, etc, from the fps:
+     */
+    if (output->frames == 1)
+        output->start_time = get_time_ns();
+}
+
+static void report_fps(const struct drm* drm, int64_t cur_time, bool final) {
+    for (int i = 0; i < drm->num_outputs; i++) {
+        const struct output* output = &drm->outputs[i];
+        double secs = (cur_time - output->start_time) / (double) NSEC_PER_SEC;
+        unsigned frames = output->frames ? output->frames - 1 : 0; /* first frame ignored */
+
+        if (drm->num_outputs > 1)
+            printf("[crtc %u] ", output->crtc_id);
+        if (final)
+            printf("Rendered %u frames in %f sec (%f fps)\n", frames, secs, (double) frames / secs);
+        else
+            debug_printf("Rendered %u frames in %f sec (%f fps)\n", frames, secs, (double) frames / secs);
+        if (final && drm->damage && output->damage_frame)
+            printf("Repainted %.1f%% of the pixels\n", 100.0 * output->repainted_pixels /
+                ((double) output->mode->hdisplay * output->mode->vdisplay * output->damage_frame));
+        if (final)
+            input_latency_report(&output->input_latency, "Input to scanout latency");
+    }
+}
+
+// ============================================================================================
+// Damage tracking
+// ============================================================================================
+
+static struct damage_region* current_damage(struct output* output) {
+    return &output->damage[output->damage_frame % DAMAGE_HISTORY];
+}
+
+static void damage_region_add(struct damage_region* region, int x, int y, int w, int h) {
+    int* r;
+
+    if (w <= 0 || h <= 0)
+        return;
+    if (region->count == MAX_DAMAGE_RECTS) {
+        /* out of rects: grow the last one to cover the new one too */
+        r = &region->rects[(MAX_DAMAGE_RECTS - 1) * 4];
+        int x1 = r[0] + r[2] > x + w ? r[0] + r[2] : x + w;
+        int y1 = r[1] + r[3] > y + h ? r[1] + r[3] : y + h;
+        r[0] = r[0] < x ? r[0] : x;
+        r[1] = r[1] < y ? r[1] : y;
+        r[2] = x1 - r[0];
+        r[3] = y1 - r[1];
+        return;
+    }
+    r = &region->rects[region->count++ * 4];
+    r[0] = x;
+    r[1] = y;
+    r[2] = w;
+    r[3] = h;
+}
+
+/* Start a new frame with an empty damage region */
+void damage_begin(struct output* output) {
+    output->damage_frame++;
+    current_damage(output)->count = 0;
+}
+
+/* Declare a rectangle changed by the frame being drawn */
+void damage_add(struct output* output, int x, int y, int w, int h) {
+    damage_region_add(current_damage(output), x, y, w, h);
+}
+
+/* EGL wants x, y, w, h with a bottom-left origin */
+static void damage_to_egl(const struct output* output, const struct damage_region* region, EGLint* rects) {
+    for (int i = 0; i < region->count; i++) {
+        const int* r = &region->rects[i * 4];
+
+        rects[i * 4 + 0] = r[0];
+        rects[i * 4 + 1] = output->mode->vdisplay - r[1] - r[3];
+        rects[i * 4 + 2] = r[2];
+        rects[i * 4 + 3] = r[3];
+    }
+}
+
+/* Work out what has to be redrawn this frame: the new damage plus everything
+ * that changed since the back buffer was last drawn, which EGL_EXT_buffer_age
+ * tells us. Returns false if the whole surface must be repainted, else the
+ * bounding box of the stale region (top-left origin) in box.
+ */
+bool damage_repaint_region(const struct egl* egl, struct output* output, int box[4]) {
+    struct damage_region* current = current_damage(output);
+    struct damage_region repaint = *current;
+    EGLint age = 0;
+    int x1, y1;
+
+    if (profile_has(PROFILE_BUFFER_AGE, egl->buffer_age))
+        eglQuerySurface(egl->display, output->egl_surface, EGL_BUFFER_AGE_EXT, &age);
+
+    /* age 0 is an undefined buffer; frame 0 is the modeset buffer we never drew */
+    if (age <= 0 || age > DAMAGE_HISTORY || (unsigned) age >= output->damage_frame) {
+        current->count = 0;
+        damage_region_add(current, 0, 0, output->mode->hdisplay, output->mode->vdisplay);
+        output->repainted_pixels += (uint64_t) output->mode->hdisplay * output->mode->vdisplay;
+        return false;
+    }
+    for (int i = 1; i < age; i++) {
+        const struct damage_region* old = &output->damage[(output->damage_frame - i) % DAMAGE_HISTORY];
+
+        for (int j = 0; j < old->count; j++)
+            damage_region_add(&repaint, old->rects[j * 4], old->rects[j * 4 + 1], old->rects[j * 4 + 2], old->rects[j * 4 + 3]);
+    }
+
+    if (egl->eglSetDamageRegionKHR && repaint.count) {
+        EGLint rects[MAX_DAMAGE_RECTS * 4];
+
+        damage_to_egl(output, &repaint, rects);
+        egl->eglSetDamageRegionKHR(egl->display, output->egl_surface, rects, repaint.count);
+    }
+
+    box[0] = box[1] = INT32_MAX;
+    x1 = y1 = 0;
+    for (int i = 0; i < repaint.count; i++) {
+        const int* r = &repaint.rects[i * 4];
+
+        box[0] = r[0] < box[0] ? r[0] : box[0];
+        box[1] = r[1] < box[1] ? r[1] : box[1];
+        x1 = r[0] + r[2] > x1 ? r[0] + r[2] : x1;
+        y1 = r[1] + r[3] > y1 ? r[1] + r[3] : y1;
+    }
+    box[2] = x1 > box[0] ? x1 - box[0] : 0;
+    box[3] = y1 > box[1] ? y1 - box[1] : 0;
+    output->repainted_pixels += (uint64_t) box[2] * box[3];
+    return true;
+}
+
+void gl_frame_begin(const struct egl* egl, GLbitfield mask) {
+    mask |= (egl->depth_size ? GL_DEPTH_BUFFER_BIT : 0) | (egl->stencil_size ? GL_STENCIL_BUFFER_BIT : 0);
+
+    if (mask)
+        glClear(mask);
+}
+
+void gl_frame_end(const struct egl* egl) {
+    static const GLenum depth_stencil[] = { GL_DEPTH, GL_STENCIL };
+
+    if (!egl->discard_depth_stencil)
+        return;
+    /* through the glad pointer: with GL_LAZY_LOAD it is resolved on the first call */
+    if (egl->invalidate_framebuffer)
+        glInvalidateFramebuffer(GL_FRAMEBUFFER, 2, depth_stencil);
+    else
+        egl->discard_framebuffer_ext(GL_FRAMEBUFFER, 2, depth_stencil);
+}
+
+/* Swap the output's surface and lock the new front buffer as DRM framebuffer */
+static struct drm_fb* swap_output(const struct egl* egl, struct output* output, struct gbm_bo** bo) {
+    struct drm_fb* fb;
+
+    const struct damage_region* damage = current_damage(output);
+
+    if (damage->count && egl->eglSwapBuffersWithDamageKHR) {
+        EGLint rects[MAX_DAMAGE_RECTS * 4];
+
+        damage_to_egl(output, damage, rects);
+        debug_printf("run_gl_loop: eglSwapBuffersWithDamageKHR egl.surface=%p rects=%d\n", output->egl_surface, damage->count);
+        egl->eglSwapBuffersWithDamageKHR(egl->display, output->egl_surface, rects, damage->count);
+    } else {
+        debug_printf("run_gl_loop: eglSwapBuffers egl.display=%p egl.surface=%p\n", egl->display, output->egl_surface);
+        eglSwapBuffers(egl->display, output->egl_surface);
+    }
+    debug_printf("run_gl_loop: gbm_surface_lock_front_buffer gbm.surface=%p\n", output->surface);
+    *bo = gbm_surface_lock_front_buffer(output->surface);
+    debug_printf("run_gl_loop: drm_fb_get_from_bo bo=%p\n", *bo);
+    fb = drm_fb_get_from_bo(*bo);
+    if (!fb)
+        printf("run_gl_loop: Failed to get a new framebuffer BO\n");
+    return fb;
+}
+
+/* Queue a flip to fb_id, completed in page_flip_handler(). With damage
+ * tracking the flip is an atomic commit of the primary plane carrying the
+ * frame's damage as FB_DAMAGE_CLIPS, so the display engine (or a panel with
+ * self refresh) only has to fetch the changed rectangles.
+ */
+static int queue_flip(struct drm* drm, struct output* output, uint32_t fb_id) {
+    const struct damage_region* damage = current_damage(output);
+    struct drm_mode_rect clips[MAX_DAMAGE_RECTS];
+    drmModeAtomicReq* req;
+    uint32_t blob_id = 0;
+    int ret;
+
+    if (PROFILE_DAMAGE_CLIPS == 0 || !drm->damage || !output->plane_id) {
+        debug_printf("run_gl_loop: drmModePageFlip drm.fd=%d crtc_id=%d fb.fb_id=%d\n", drm->fd, output->crtc_id, fb_id);
+        return drmModePageFlip(drm->fd, output->crtc_id, fb_id, DRM_MODE_PAGE_FLIP_EVENT, output);
+    }
+
+    for (int i = 0; i < damage->count; i++) {
+        const int* r = &damage->rects[i * 4];
+
+        clips[i].x1 = r[0];
+        clips[i].y1 = r[1];
+        clips[i].x2 = r[0] + r[2];
+        clips[i].y2 = r[1] + r[3];
+    }
+    /* no blob means the whole plane is damaged */
+    if (damage->count &&
+        drmModeCreatePropertyBlob(drm->fd, clips, damage->count * sizeof(clips[0]), &blob_id))
+        blob_id = 0;
+
+    req = drmModeAtomicAlloc();
+    drmModeAtomicAddProperty(req, output->plane_id, output->fb_id_prop, fb_id);
+    drmModeAtomicAddProperty(req, output->plane_id, output->damage_clips_prop, blob_id);
+    debug_printf("run_gl_loop: drmModeAtomicCommit plane_id=%d fb.fb_id=%d damage_clips=%d\n", output->plane_id, fb_id, damage->count);
+    ret = drmModeAtomicCommit(drm->fd, req, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, output);
+    drmModeAtomicFree(req);
+    /* the plane state keeps its own reference to the blob */
+    if (blob_id)
+        drmModeDestroyPropertyBlob(drm->fd, blob_id);
+    return ret;
+}
+
+/* Block until DRM events arrive and dispatch them to page_flip_handler().
+ * Returns 1 when events were handled, 0 when the user interrupted on stdin
+ * and a negative value on error.
+ */
+static int wait_drm_events(struct drm* drm) {
+    fd_set fds;
+    drmEventContext evctx = {
+        .version = 2,
+        .page_flip_handler = page_flip_handler,
+    };
+    int ret;
+
+    FD_ZERO(&fds);
+    FD_SET(0, &fds);
+    FD_SET(drm->fd, &fds);
+
+    ret = select(drm->fd + 1, &fds, NULL, NULL, NULL);
+    if (ret < 0) {
+        debug_printf("select err: %s\n", strerror(errno));
+        return ret;
+    } else if (ret == 0) {
+        debug_printf("select timeout!\n");
+        return -1;
+    } else if (FD_ISSET(0, &fds) && !drm->nonblocking) {
+        debug_printf("user interrupted!\n");
+        return 0;
+    }
+    debug_printf("wait_drm_events: drmHandleEvent drm.fd=%d\n", drm->fd);
+    drmHandleEvent(drm->fd, &evctx);
+    return 1;
+}
+
+int run_gl_loop(struct gbm* gbm, struct egl* egl, struct drm* drm, const struct gl_client* client) {
+    struct drm_fb* fb;
+    int64_t report_time, cur_time, render_start, render_time = 0;
+    int i, ret, phase;
+
+    if (!gbm->surface) {
+        printf("run_gl_loop: FATAL ERROR, gbm->surface is NULL\n");
+        return -1;
+    }
+
+    /* set mode on every output: */
+    phase = startup_trace_begin("first drmModeSetCrtc");
+    for (i = 0; i < drm->num_outputs; i++) {
+        struct output* output = &drm->outputs[i];
+
+        if (drm->num_outputs > 1)
+            eglMakeCurrent(egl->display, output->egl_surface, output->egl_surface, egl->context);
+        fb = swap_output(egl, output, &output->bo);
+        if (!fb) {
+            /* the buffer could not become a framebuffer: try the next layout */
+            if (output->bo && !downgrade_output_surface(gbm, egl, drm, output)) {
+                i--;
+                continue;
+            }
+            return -1;
+        }
+        gbm->modifier = gbm_bo_get_modifier(output->bo);
+        printf("run_gl_loop: crtc %u scanout modifier 0x%016" PRIx64 "%s\n", output->crtc_id, gbm->modifier,
+            gbm->modifier == DRM_FORMAT_MOD_LINEAR ? " (linear)" : "");
+        output->start_time = get_time_ns();
+
+        if (output->reuse_crtc) {
+            /* the mode is already on screen: a plain flip avoids the modeset blank */
+            debug_printf("run_gl_loop: reusing crtc_id=%d\n", output->crtc_id);
+            ret = queue_flip(drm, output, fb->fb_id);
+            if (!ret) {
+                output->next_bo = output->bo;
+                output->bo = NULL;
+                output->waiting_for_flip = true;
+                continue;
+            }
+            printf("run_gl_loop: flip on crtc %u failed, doing a full modeset: %s\n", output->crtc_id, strerror(errno));
+            output->reuse_crtc = false;
+        }
+
+        debug_printf("run_gl_loop: drmModeSetCrtc drm.fd=%d crtc_id=%d fb.fb_id=%d connector_id=%d\n", drm->fd, output->crtc_id, fb->fb_id, output->connector_id);
+        ret = drmModeSetCrtc(drm->fd, output->crtc_id, fb->fb_id, 0, 0, &output->connector_id, 1, output->mode);
+        if (ret) {
+            printf("run_gl_loop: failed to set mode: %s\n", strerror(errno));
+            if (!downgrade_output_surface(gbm, egl, drm, output)) {
+                i--;
+                continue;
+            }
+            return ret;
+        }
+    }
+    startup_trace_end(phase);
+
+    report_time = get_time_ns();
+    while (true) {
+        bool done = true;
+
+        /* Queue a new frame on every output whose previous flip completed, so
+         * outputs with different refresh rates never wait on each other.
+         */
+        for (i = 0; i < drm->num_outputs; i++) {
+            struct output* output = &drm->outputs[i];
+            int64_t input_time;
+
+            if (output->frames >= drm->count)
+                continue;
+            done = false;
+            if (output->waiting_for_flip)
+                continue;
+
+            render_start = get_time_ns();
+            input_time = client->draw(client->data, egl, drm, i);
+            gl_frame_end(egl);
+            fb = swap_output(egl, output, &output->next_bo);
+            if (!fb)
+                return -1;
+            render_time += get_time_ns() - render_start;
+
+            // Here you could also update drm plane layers if you want hw composition
+            ret = queue_flip(drm, output, fb->fb_id);
+            if (ret) {
+                debug_printf("run_gl_loop: failed to queue page flip: %s\n", strerror(errno));
+                return -1;
+            }
+            output->waiting_for_flip = true;
+            output->input_time = input_time;
+        }
+        if (done || (client->quit && client->quit(client->data)))
+            break;
+
+        ret = wait_drm_events(drm);
+        if (ret <= 0)
+            return ret;
+
+        cur_time = get_time_ns();
+        if (cur_time > (report_time + 2 * NSEC_PER_SEC)) {
+            report_fps(drm, cur_time, false);
+            report_time = cur_time;
+        }
+    }
+    report_fps(drm, get_time_ns(), true);
+    printf("GL render+swap time: %.3f ms/frame\n", render_time / 1e6 / (drm->outputs[0].frames ? drm->outputs[0].frames : 1));
+    return 0;
+}
+
+/* Software backend: no GBM/EGL, dumb buffers flipped with the same page flip
+ * handling as run_gl_loop(). Drives outputs[0] only.
+ */
+int run_sw_loop(struct drm* drm, struct swrender* sw, void (*draw)(struct swrender* sw)) {
+    struct output* output = &drm->outputs[0];
+    int64_t report_time, cur_time, render_start, render_time = 0;
+    uint32_t fb_id;
+    int ret, phase;
+
+    ret = init_dumb(sw, drm->fd, output->mode->hdisplay, output->mode->vdisplay, sysconf(_SC_NPROCESSORS_ONLN));
+    if (ret) {
+        printf("run_sw_loop: failed to create dumb buffers\n");
+        destroy_dumb(sw);
+        return ret;
+    }
+
+    draw(sw);
+    fb_id = sw_flush(sw);
+    debug_printf("run_sw_loop: drmModeSetCrtc crtc_id=%d fb_id=%d connector_id=%d\n", output->crtc_id, fb_id, output->connector_id);
+    phase = startup_trace_begin("first drmModeSetCrtc");
+    ret = drmModeSetCrtc(drm->fd, output->crtc_id, fb_id, 0, 0, &output->connector_id, 1, output->mode);
+    startup_trace_end(phase);
+    if (ret) {
+        printf("run_sw_loop: failed to set mode: %s\n", strerror(errno));
+        goto out;
+    }
+    /* the modeset buffer is already a drawn frame */
+    startup_trace_first_frame();
+
+    output->start_time = report_time = get_time_ns();
+    while (output->frames < drm->count) {
+        render_start = get_time_ns();
+        draw(sw);
+        fb_id = sw_flush(sw);
+        render_time += get_time_ns() - render_start;
+
+        ret = drmModePageFlip(drm->fd, output->crtc_id, fb_id, DRM_MODE_PAGE_FLIP_EVENT, output);
+        if (ret) {
+            debug_printf("run_sw_loop: failed to queue page flip: %s\n", strerror(errno));
+            goto out;
+        }
+        output->waiting_for_flip = true;
+        while (output->waiting_for_flip) {
+            ret = wait_drm_events(drm);
+            if (ret <= 0)
+                goto out;
+        }
+
+        cur_time = get_time_ns();
+        if (cur_time > (report_time + 2 * NSEC_PER_SEC)) {
+            report_fps(drm, cur_time, false);
+            report_time = cur_time;
+        }
+    }
+    report_fps(drm, get_time_ns(), true);
+    printf("Software render time: %.3f ms/frame on %d thread(s)\n", render_time / 1e6 / (output->frames ? output->frames : 1), sw->num_threads + 1);
+    ret = 0;
+
+out:
+    /* put the saved CRTC back before our framebuffers disappear */
+    restore_drm(drm);
+    destroy_dumb(sw);
+    return ret;
+}
+
+/* Free the output surfaces, the EGL context and display, and the DRM device.
+ * The CRTCs must have been given back with restore_drm() first.
+ */
+void destroy_kmsdrm(struct gbm* gbm, struct egl* egl, struct drm* drm) {
+    for (int i = 1; i < drm->num_outputs; i++) {
+        struct output* output = &drm->outputs[i];
+
+        if (output->egl_surface != EGL_NO_SURFACE)
+            eglDestroySurface(egl->display, output->egl_surface);
+        if (output->surface)
+            gbm_surface_destroy(output->surface);
+        drmModeFreeConnector(output->connector);
+    }
+
+    if (gbm->surface) {
+        debug_puts("gbm_surface_destroy");
+        gbm_surface_destroy(gbm->surface);
+    }
+
+    if (egl->surface != EGL_NO_SURFACE) {
+        debug_puts("eglDestroySurface");
+        eglDestroySurface(egl->display, egl->surface);
+    }
+
+    if (egl->loader_context != EGL_NO_CONTEXT)
+        eglDestroyContext(egl->display, egl->loader_context);
+
+    if (egl->context != EGL_NO_CONTEXT) {
+        debug_puts("eglDestroyContext");
+        eglDestroyContext(egl->display, egl->context);
+    }
+
+    if (egl->display != EGL_NO_DISPLAY) {
+        debug_puts("eglTerminate");
+        eglTerminate(egl->display);
+    }
+    ext_set_free(&egl->client_exts);
+    ext_set_free(&egl->display_exts);
+    ext_set_free(&egl->gl_exts);
+
+    if (drm->connected_connector) {
+        debug_puts("drmModeFreeConnector");
+        drmModeFreeConnector(drm->connected_connector);
+    }
+
+    if (drm->fd) {
+        debug_puts("close drm.fd");
+        close(drm->fd);
+    }
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2017 Rob Clark <rclark@redhat.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sub license,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _KMSDRM_H
+#define _KMSDRM_H
+
+#include "gles/glad.h"
+#include <inttypes.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+#include <stdio.h>
+#include <sys/select.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <linux/input-event-codes.h>
+#include <libdrm/drm.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <gbm.h>
+#include <libdrm/drm_fourcc.h>
+#include <stdbool.h>
+#include "startup_cache.h"
+#include "startup_trace.h"
+#include "ext_set.h"
+#include "swrender.h"
+#include "drm_plane.h"
+#include "pixel_format.h"
+#include "capture.h"
+#include "stream.h"
+#include "ktx.h"
+#include "atlas.h"
+#include "font.h"
+#include "input.h"
+#include "cursor.h"
+#include "profile.h"
+#include "dmabuf_import.h"
+#include "video_plane.h"
+#include <sys/mman.h>
+
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+#define MAX_DRM_DEVICES 8
+#define MAX_OUTPUTS 4
+#define MAX_DAMAGE_RECTS 16
+#define DAMAGE_HISTORY 4
+
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR 0
+#endif
+
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID ((((__u64)0) << 56) | ((1ULL << 56) - 1))
+#endif
+
+#ifndef EGL_KHR_platform_gbm
+#define EGL_KHR_platform_gbm 1
+#define EGL_PLATFORM_GBM_KHR              0x31D7
+#endif /* EGL_KHR_platform_gbm */
+
+#ifndef EGL_MESA_platform_surfaceless
+#define EGL_PLATFORM_SURFACELESS_MESA     0x31DD
+#endif
+
+#ifndef EGL_EXT_platform_base
+#define EGL_EXT_platform_base 1
+typedef EGLDisplay(EGLAPIENTRYP PFNEGLGETPLATFORMDISPLAYEXTPROC) (EGLenum platform, void* native_display, const EGLint* attrib_list);
+typedef EGLSurface(EGLAPIENTRYP PFNEGLCREATEPLATFORMWINDOWSURFACEEXTPROC) (EGLDisplay dpy, EGLConfig config, void* native_window, const EGLint* attrib_list);
+typedef EGLSurface(EGLAPIENTRYP PFNEGLCREATEPLATFORMPIXMAPSURFACEEXTPROC) (EGLDisplay dpy, EGLConfig config, void* native_pixmap, const EGLint* attrib_list);
+#ifdef EGL_EGLEXT_PROTOTYPES
+EGLAPI EGLDisplay EGLAPIENTRY eglGetPlatformDisplayEXT(EGLenum platform, void* native_display, const EGLint* attrib_list);
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePlatformWindowSurfaceEXT(EGLDisplay dpy, EGLConfig config, void* native_window, const EGLint* attrib_list);
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePlatformPixmapSurfaceEXT(EGLDisplay dpy, EGLConfig config, void* native_pixmap, const EGLint* attrib_list);
+#endif
+#endif /* EGL_EXT_platform_base */
+
+#ifndef GL_BGRA_EXT
+#define GL_BGRA_EXT 0x80E1      /* GL_BGRA in desktop GL */
+#endif
+
+#define WEAK __attribute__((weak))
+
+#ifdef DEBUG
+#define debug_puts puts
+#define debug_printf printf
+#else
+#define debug_puts (void)
+#define debug_printf (void)
+#endif
+
+/* Client API of the EGL context */
+enum gl_api {
+    GL_API_AUTO,                /* OpenGL ES if the driver has it, else OpenGL */
+    GL_API_GLES,
+    GL_API_GL,
+};
+
+/* Rectangles changed in one frame as x, y, w, h in pixels, top-left origin
+ * like KMS (EGL and GL want bottom-left, see damage_to_egl())
+ */
+struct damage_region {
+    int count;
+    int rects[MAX_DAMAGE_RECTS * 4];
+};
+
+/* One connector/CRTC pair driven by the render loop. Every output has its
+ * own GBM and EGL surface; all outputs share the EGL context and programs.
+ */
+struct output {
+    uint32_t connector_id;
+    uint32_t crtc_id;
+    int crtc_index;
+    drmModeConnector* connector;
+    drmModeModeInfo* mode;
+    struct gbm_surface* surface;
+    EGLSurface egl_surface;
+    struct gbm_bo* bo;          /* buffer currently scanned out */
+    struct gbm_bo* next_bo;     /* buffer queued for page flip */
+    drmModeCrtc* saved_crtc;    /* CRTC state at startup, restored on exit */
+    bool reuse_crtc;            /* saved_crtc already shows our mode: flip instead of modeset */
+    bool waiting_for_flip;
+    unsigned int frames;
+    int64_t start_time;
+    /* damage tracking (-d): the last DAMAGE_HISTORY frames, current one in
+     * damage[damage_frame % DAMAGE_HISTORY]
+     */
+    struct damage_region damage[DAMAGE_HISTORY];
+    unsigned int damage_frame;
+    uint64_t repainted_pixels;
+    uint32_t plane_id;          /* primary plane, 0 to flip without FB_DAMAGE_CLIPS */
+    uint32_t fb_id_prop, damage_clips_prop;
+    /* input (--input): oldest event shown by next_bo, 0 if none */
+    int64_t input_time;
+    struct input_latency input_latency;
+};
+
+struct drm {
+    int fd;
+    char device_path[STARTUP_CACHE_PATH_LEN];
+    int crtc_index;
+    drmModeModeInfo* mode;
+    uint32_t crtc_id;
+    uint32_t connector_id;
+    unsigned int count;
+    bool nonblocking;
+    bool damage;
+    drmModeConnector *connected_connector;
+    /* outputs[0] mirrors the fields above, the rest are extra CRTCs */
+    struct output outputs[MAX_OUTPUTS];
+    int num_outputs;
+};
+
+struct drm_fb {
+    struct gbm_bo* bo;
+    uint32_t fb_id;
+};
+
+struct gbm {
+    struct gbm_device* dev;
+    const char* device;         /* DRM device path, keys the startup cache */
+    struct gbm_surface* surface;
+    uint32_t format;
+    uint64_t modifiers[MAX_PLANE_MODIFIERS];    /* allowed scanout layouts, best first */
+    int num_modifiers;                          /* 0: implicit layout */
+    uint64_t modifier;                          /* layout GBM chose */
+    int width, height;
+};
+
+struct egl {
+    enum gl_api api;            /* what init_egl() got, never GL_API_AUTO */
+    int gl_major;               /* context version */
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLContext loader_context;  /* shares objects with context, EGL_NO_CONTEXT if unsupported */
+    EGLSurface surface;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT;
+    bool modifiers_supported;
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC eglSwapBuffersWithDamageKHR;
+    PFNEGLSETDAMAGEREGIONKHRPROC eglSetDamageRegionKHR;
+    bool buffer_age;
+    bool etc2, astc;            /* compressed texture formats the context can sample */
+    bool sync;                  /* fence sync objects, else glFinish() */
+    int depth_size, stencil_size;   /* of the chosen config */
+    bool invalidate_framebuffer;    /* glInvalidateFramebuffer() */
+    /* glDiscardFramebufferEXT() on GLES 2, the same signature */
+    PFNGLINVALIDATEFRAMEBUFFERPROC discard_framebuffer_ext;
+    bool discard_depth_stencil; /* gl_frame_end() invalidates them, clear to keep them */
+    /* what the driver reported, parsed once for every extension check */
+    struct ext_set client_exts, display_exts, gl_exts;
+};
+
+/* What run_gl_loop() asks of the application */
+struct gl_client {
+    void* data;
+    /* Draw the next frame of drm->outputs[index], its surface current. Returns
+     * the CLOCK_MONOTONIC time of the oldest input event the frame shows, 0 if
+     * none, for the input to scanout latency.
+     */
+    int64_t (*draw)(void* data, const struct egl* egl, struct drm* drm, int index);
+    /* Optional: true to stop before every output showed drm->count frames */
+    bool (*quit)(void* data);
+};
+
+int init_drm(struct drm* drm, const char* device, const char* mode_str, int connector_id, unsigned int vrefresh, unsigned int count, bool nonblocking);
+int init_drm_outputs(struct drm* drm);
+void restore_drm(struct drm* drm);
+void init_damage(struct drm* drm);
+int init_surface(struct gbm* gbm);
+int init_gbm(struct gbm* gbm, const struct drm* drm, int w, int h, uint32_t format, bool force_linear);
+/* Create the context for api, with GL_API_AUTO the first of OpenGL ES and
+ * OpenGL the driver can do, and load the GL functions. A gbm without device
+ * runs headless: a gbm->width x gbm->height pbuffer on Mesa's surfaceless
+ * platform, which works without DRM master and on llvmpipe.
+ */
+int init_egl(struct egl* egl, const struct gbm* gbm, int samples, int depth, int stencil, enum gl_api api);
+int init_output_surfaces(const struct gbm* gbm, const struct egl* egl, struct drm* drm);
+struct drm_fb* drm_fb_get_from_bo(struct gbm_bo* bo);
+void destroy_kmsdrm(struct gbm* gbm, struct egl* egl, struct drm* drm);
+
+/* Shaders without a #version line are compiled as GLSL ES 1.00 or GLSL 1.20,
+ * to match the context
+ */
+int create_program(const char* vs_src, const char* fs_src);
+int link_program(unsigned program);
+
+/* Damage tracking (-d): start a frame, declare what it changes, then get the
+ * bounding box to repaint (false: repaint everything)
+ */
+void damage_begin(struct output* output);
+void damage_add(struct output* output, int x, int y, int w, int h);
+bool damage_repaint_region(const struct egl* egl, struct output* output, int box[4]);
+
+/* Depth and stencil on tilers (Mali, V3D): cleared at the start of a frame they
+ * are never loaded from memory, invalidated at its end never written back.
+ * gl_frame_begin() is the first drawing of the frame, after
+ * damage_repaint_region(): one glClear() of mask (e.g. GL_COLOR_BUFFER_BIT, 0
+ * to keep the color) and whatever depth and stencil the config has.
+ * run_gl_loop() calls gl_frame_end() before the swap. The default framebuffer
+ * must be bound. gl_frame_end() is a no-op without depth and stencil.
+ */
+void gl_frame_begin(const struct egl* egl, GLbitfield mask);
+void gl_frame_end(const struct egl* egl);
+
+/* Set the mode on every output and render drm->count frames per output with
+ * client, page flipped on vblank. Returns 0 when done or interrupted on stdin.
+ */
+int run_gl_loop(struct gbm* gbm, struct egl* egl, struct drm* drm, const struct gl_client* client);
+/* The same on drm->outputs[0] without a GPU: draw renders into sw's dumb buffers */
+int run_sw_loop(struct drm* drm, struct swrender* sw, void (*draw)(struct swrender* sw));
+
+#define NSEC_PER_SEC (INT64_C(1000) * USEC_PER_SEC)
+#define USEC_PER_SEC (INT64_C(1000) * MSEC_PER_SEC)
+#define MSEC_PER_SEC INT64_C(1000)
+
+int64_t get_time_ns(void);
+
+#endif /* _KMSDRM_H */
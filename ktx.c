@@ -0,0 +1,485 @@
+/*
+KTX 1.1 / KTX 2.0 texture loader
+
+The file is mapped read-only and the level table points into the mapping,
+so glCompressedTexImage2D() copies each mip level straight from the page
+cache: no malloc, no read() into a staging buffer, and the RSS of a loaded
+texture drops back once ktx_release_level() hands the pages back.
+
+The ETC decoder covers every ETC1/ETC2 mode (individual, differential, T, H,
+planar, punch-through alpha) and EAC alpha, for drivers that expose neither
+GLES 3.0 nor GL_ARB_ES3_compatibility. ASTC has no CPU fallback: the
+decoder would be larger than the rest of this project.
+ */
+
+#include "ktx.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct ktx_format {
+    uint32_t vk_format;         /* KTX2, 0 if KTX 1.1 only */
+    uint32_t gl_format;
+    uint8_t block_width, block_height, block_size;
+    uint32_t format, type;      /* for glTexImage2D, 0 for compressed formats */
+};
+
+#define ASTC(i, w, h) \
+    { 157 + 2 * (i), GL_COMPRESSED_RGBA_ASTC_4x4_KHR + (i), w, h, 16, 0, 0 }, \
+    { 158 + 2 * (i), GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR + (i), w, h, 16, 0, 0 }
+
+static const struct ktx_format formats[] = {
+    { 0, GL_ETC1_RGB8_OES, 4, 4, 8, 0, 0 },
+    { 147, GL_COMPRESSED_RGB8_ETC2, 4, 4, 8, 0, 0 },
+    { 148, GL_COMPRESSED_SRGB8_ETC2, 4, 4, 8, 0, 0 },
+    { 149, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, 4, 4, 8, 0, 0 },
+    { 150, GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2, 4, 4, 8, 0, 0 },
+    { 151, GL_COMPRESSED_RGBA8_ETC2_EAC, 4, 4, 16, 0, 0 },
+    { 152, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 4, 4, 16, 0, 0 },
+    ASTC(0, 4, 4), ASTC(1, 5, 4), ASTC(2, 5, 5), ASTC(3, 6, 5), ASTC(4, 6, 6),
+    ASTC(5, 8, 5), ASTC(6, 8, 6), ASTC(7, 8, 8), ASTC(8, 10, 5), ASTC(9, 10, 6),
+    ASTC(10, 10, 8), ASTC(11, 10, 10), ASTC(12, 12, 10), ASTC(13, 12, 12),
+    /* uncompressed: GL_RGBA8 / GL_SRGB8_ALPHA8 / unsized GL_RGBA, GL_UNSIGNED_BYTE */
+    { 37, 0x8058, 1, 1, 4, 0x1908, 0x1401 },
+    { 43, 0x8C43, 1, 1, 4, 0x1908, 0x1401 },
+    { 0, 0x1908, 1, 1, 4, 0x1908, 0x1401 },
+};
+
+static const uint8_t ktx1_id[12] = { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
+static const uint8_t ktx2_id[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+static uint32_t read_le32(const uint8_t* p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static uint32_t read_be32(const uint8_t* p) {
+    return (uint32_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint64_t read_le64(const uint8_t* p) {
+    return read_le32(p) | (uint64_t) read_le32(p + 4) << 32;
+}
+
+static size_t level_size(const struct ktx* ktx, int width, int height) {
+    size_t blocks_x = (width + ktx->block_width - 1) / ktx->block_width;
+    size_t blocks_y = (height + ktx->block_height - 1) / ktx->block_height;
+
+    return blocks_x * blocks_y * ktx->block_size;
+}
+
+static int set_format(struct ktx* ktx, const struct ktx_format* format) {
+    if (!format)
+        return -1;
+    ktx->internal_format = format->gl_format;
+    ktx->format = format->format;
+    ktx->type = format->type;
+    ktx->block_width = format->block_width;
+    ktx->block_height = format->block_height;
+    ktx->block_size = format->block_size;
+    return 0;
+}
+
+static const struct ktx_format* find_format(uint32_t vk_format, uint32_t gl_format) {
+    for (unsigned int i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (vk_format ? formats[i].vk_format == vk_format : formats[i].gl_format == gl_format)
+            return &formats[i];
+    }
+    return NULL;
+}
+
+static int parse_ktx1(struct ktx* ktx, const uint8_t* data, size_t size) {
+    uint32_t (*read32)(const uint8_t*) = read_le32;
+    uint32_t depth, elements, faces, levels, kvd;
+    size_t offset;
+
+    if (size < 64)
+        return -1;
+    /* written in the producer's byte order */
+    if (read_le32(data + 12) != 0x04030201)
+        read32 = read_be32;
+    if (read32(data + 12) != 0x04030201)
+        return -1;
+
+    if (read32(data + 16) && read32(data + 16) != 0x1401) {
+        printf("ktx_open: only GL_UNSIGNED_BYTE uncompressed data is supported\n");
+        return -1;
+    }
+    if (set_format(ktx, find_format(0, read32(data + 28)))) {
+        printf("ktx_open: unsupported internal format 0x%x\n", read32(data + 28));
+        return -1;
+    }
+    ktx->width = read32(data + 36);
+    ktx->height = read32(data + 40);
+    depth = read32(data + 44);
+    elements = read32(data + 48);
+    faces = read32(data + 52);
+    levels = read32(data + 56);
+    kvd = read32(data + 60);
+    if (depth || elements || faces != 1 || ktx->width <= 0 || ktx->height <= 0) {
+        printf("ktx_open: only 2D textures are supported\n");
+        return -1;
+    }
+    ktx->generate_mipmaps = levels == 0;
+    ktx->num_levels = levels ? levels : 1;
+    if (ktx->num_levels > KTX_MAX_LEVELS)
+        ktx->num_levels = KTX_MAX_LEVELS;
+
+    offset = 64 + (size_t) kvd;
+    for (int i = 0; i < ktx->num_levels; i++) {
+        struct ktx_level* level = &ktx->levels[i];
+
+        if (offset + 4 > size)
+            return -1;
+        level->size = read32(data + offset);
+        level->data = data + offset + 4;
+        offset += 4 + ((level->size + 3) & ~(size_t) 3);
+    }
+    return 0;
+}
+
+static int parse_ktx2(struct ktx* ktx, const uint8_t* data, size_t size) {
+    uint32_t levels;
+
+    if (size < 80)
+        return -1;
+    if (set_format(ktx, find_format(read_le32(data + 12), 0))) {
+        printf("ktx_open: unsupported vkFormat %u\n", read_le32(data + 12));
+        return -1;
+    }
+    ktx->width = read_le32(data + 20);
+    ktx->height = read_le32(data + 24);
+    if (read_le32(data + 28) || read_le32(data + 32) || read_le32(data + 36) != 1 || ktx->width <= 0 || ktx->height <= 0) {
+        printf("ktx_open: only 2D textures are supported\n");
+        return -1;
+    }
+    if (read_le32(data + 44)) {
+        printf("ktx_open: supercompressed (BasisLZ, zstd) files are not supported\n");
+        return -1;
+    }
+    levels = read_le32(data + 40);
+    ktx->generate_mipmaps = levels == 0;
+    ktx->num_levels = levels ? levels : 1;
+    if (ktx->num_levels > KTX_MAX_LEVELS)
+        ktx->num_levels = KTX_MAX_LEVELS;
+    if (80 + (size_t) ktx->num_levels * 24 > size)
+        return -1;
+
+    /* the level index is sorted base level first, the data usually smallest first */
+    for (int i = 0; i < ktx->num_levels; i++) {
+        uint64_t offset = read_le64(data + 80 + i * 24);
+        uint64_t length = read_le64(data + 80 + i * 24 + 8);
+
+        if (offset > size || length > size - offset)
+            return -1;
+        ktx->levels[i].data = data + offset;
+        ktx->levels[i].size = length;
+    }
+    return 0;
+}
+
+int ktx_open(struct ktx* ktx, const char* path) {
+    struct stat st;
+    int fd, ret;
+
+    memset(ktx, 0, sizeof(*ktx));
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("ktx_open: cannot open %s\n", path);
+        return -1;
+    }
+    if (fstat(fd, &st) || st.st_size < 12) {
+        close(fd);
+        return -1;
+    }
+    ktx->map_size = st.st_size;
+    ktx->map = mmap(NULL, ktx->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ktx->map == MAP_FAILED) {
+        ktx->map = NULL;
+        return -1;
+    }
+    /* levels are read front to back once: let the kernel read ahead */
+    madvise(ktx->map, ktx->map_size, MADV_SEQUENTIAL);
+
+    if (!memcmp(ktx->map, ktx1_id, sizeof(ktx1_id))) {
+        ktx->version = 1;
+        ret = parse_ktx1(ktx, ktx->map, ktx->map_size);
+    } else if (!memcmp(ktx->map, ktx2_id, sizeof(ktx2_id))) {
+        ktx->version = 2;
+        ret = parse_ktx2(ktx, ktx->map, ktx->map_size);
+    } else {
+        printf("ktx_open: %s is not a KTX file\n", path);
+        ret = -1;
+    }
+
+    for (int i = 0; !ret && i < ktx->num_levels; i++) {
+        struct ktx_level* level = &ktx->levels[i];
+        const uint8_t* end = (const uint8_t*) ktx->map + ktx->map_size;
+
+        level->width = ktx->width >> i ? ktx->width >> i : 1;
+        level->height = ktx->height >> i ? ktx->height >> i : 1;
+        if (level->size < level_size(ktx, level->width, level->height) || level->data > end ||
+            level->size > (size_t) (end - level->data)) {
+            printf("ktx_open: %s: level %d is truncated\n", path, i);
+            ret = -1;
+        }
+    }
+    if (ret)
+        ktx_close(ktx);
+    return ret;
+}
+
+void ktx_close(struct ktx* ktx) {
+    if (ktx->map)
+        munmap(ktx->map, ktx->map_size);
+    ktx->map = NULL;
+}
+
+void ktx_release_level(struct ktx* ktx, int level) {
+    const long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t) ktx->levels[level].data;
+    uintptr_t end = start + ktx->levels[level].size;
+
+    /* whole pages only, the neighbouring levels may share the edges */
+    start = (start + page - 1) & ~(uintptr_t) (page - 1);
+    end &= ~(uintptr_t) (page - 1);
+    if (end > start)
+        madvise((void*) start, end - start, MADV_DONTNEED);
+}
+
+bool ktx_is_etc(uint32_t internal_format) {
+    return internal_format == GL_ETC1_RGB8_OES ||
+        (internal_format >= GL_COMPRESSED_RGB8_ETC2 && internal_format <= GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC);
+}
+
+bool ktx_is_astc(uint32_t internal_format) {
+    return (internal_format >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && internal_format <= GL_COMPRESSED_RGBA_ASTC_4x4_KHR + 13) ||
+        (internal_format >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR && internal_format <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR + 13);
+}
+
+bool ktx_is_srgb(uint32_t internal_format) {
+    switch (internal_format) {
+    case GL_COMPRESSED_SRGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case 0x8C43:
+        return true;
+    default:
+        return internal_format >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR &&
+            internal_format <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR + 13;
+    }
+}
+
+// ============================================================================================
+// ETC1 / ETC2 / EAC decoder
+// ============================================================================================
+
+static const int etc_modifiers[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+};
+
+static const int etc_distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+static const int eac_modifiers[16][8] = {
+    { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 },
+};
+
+static inline uint8_t clamp255(int v) {
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static inline int extend4(int v) {
+    return v << 4 | v;
+}
+
+static inline int extend5(int v) {
+    return v << 3 | v >> 2;
+}
+
+static inline int extend6(int v) {
+    return v << 2 | v >> 4;
+}
+
+static inline int extend7(int v) {
+    return v << 1 | v >> 6;
+}
+
+static void set_pixel(uint8_t* out, int r, int g, int b, int a) {
+    out[0] = clamp255(r);
+    out[1] = clamp255(g);
+    out[2] = clamp255(b);
+    out[3] = a;
+}
+
+/* T and H modes: four paint colors picked per pixel */
+static void decode_paint(uint8_t out[16][4], const int paint[4][3], uint32_t indices, bool punchthrough) {
+    for (int i = 0; i < 16; i++) {
+        int index = ((indices >> (16 + i)) & 1) << 1 | ((indices >> i) & 1);
+
+        if (punchthrough && index == 2)
+            set_pixel(out[i], 0, 0, 0, 0);
+        else
+            set_pixel(out[i], paint[index][0], paint[index][1], paint[index][2], 255);
+    }
+}
+
+static void decode_planar(uint8_t out[16][4], const uint8_t* b) {
+    int ro = extend6((b[0] >> 1) & 0x3f);
+    int go = extend7((b[0] & 1) << 6 | ((b[1] >> 1) & 0x3f));
+    int bo = extend6((b[1] & 1) << 5 | ((b[2] >> 3) & 3) << 3 | (b[2] & 3) << 1 | b[3] >> 7);
+    int rh = extend6(((b[3] >> 2) & 0x1f) << 1 | (b[3] & 1));
+    int gh = extend7(b[4] >> 1);
+    int bh = extend6((b[4] & 1) << 5 | b[5] >> 3);
+    int rv = extend6((b[5] & 7) << 3 | b[6] >> 5);
+    int gv = extend7((b[6] & 0x1f) << 2 | b[7] >> 6);
+    int bv = extend6(b[7] & 0x3f);
+
+    for (int x = 0; x < 4; x++) {
+        for (int y = 0; y < 4; y++) {
+            set_pixel(out[x * 4 + y],
+                (x * (rh - ro) + y * (rv - ro) + 4 * ro + 2) >> 2,
+                (x * (gh - go) + y * (gv - go) + 4 * go + 2) >> 2,
+                (x * (bh - bo) + y * (bv - bo) + 4 * bo + 2) >> 2, 255);
+        }
+    }
+}
+
+/* One 4x4 color block into out[x * 4 + y] (the order ETC stores the indices
+ * in). etc1 disables the T/H/planar modes, punchthrough reads the
+ * differential bit as the opaque flag of RGB8_PUNCHTHROUGH_ALPHA1.
+ */
+static void decode_etc_block(uint8_t out[16][4], const uint8_t* b, bool etc1, bool punchthrough) {
+    const uint32_t indices = read_be32(b + 4);
+    const bool flip = b[3] & 1;
+    const bool diff = punchthrough || (b[3] & 2);
+    const bool opaque = !punchthrough || (b[3] & 2);
+    int base[2][3], table[2];
+
+    if (!diff) {
+        for (int c = 0; c < 3; c++) {
+            base[0][c] = extend4(b[c] >> 4);
+            base[1][c] = extend4(b[c] & 0xf);
+        }
+    } else {
+        int c1[3], c2[3];
+
+        for (int c = 0; c < 3; c++) {
+            int delta = b[c] & 7;
+
+            c1[c] = b[c] >> 3;
+            c2[c] = c1[c] + (delta >= 4 ? delta - 8 : delta);
+        }
+        if (!etc1 && (c2[0] < 0 || c2[0] > 31)) {
+            /* T mode */
+            int d = etc_distances[((b[3] >> 2) & 3) << 1 | (b[3] & 1)];
+            int r1 = extend4(((b[0] >> 3) & 3) << 2 | (b[0] & 3)), g1 = extend4(b[1] >> 4), b1 = extend4(b[1] & 0xf);
+            int r2 = extend4(b[2] >> 4), g2 = extend4(b[2] & 0xf), b2 = extend4(b[3] >> 4);
+            const int paint[4][3] = {
+                { r1, g1, b1 }, { r2 + d, g2 + d, b2 + d }, { r2, g2, b2 }, { r2 - d, g2 - d, b2 - d },
+            };
+
+            decode_paint(out, paint, indices, !opaque);
+            return;
+        }
+        if (!etc1 && (c2[1] < 0 || c2[1] > 31)) {
+            /* H mode */
+            int r1 = (b[0] >> 3) & 0xf, g1 = (b[0] & 7) << 1 | ((b[1] >> 4) & 1);
+            int b1 = ((b[1] >> 3) & 1) << 3 | (b[1] & 3) << 1 | b[2] >> 7;
+            int r2 = (b[2] >> 3) & 0xf, g2 = (b[2] & 7) << 1 | b[3] >> 7, b2 = (b[3] >> 3) & 0xf;
+            int order = (r1 << 8 | g1 << 4 | b1) >= (r2 << 8 | g2 << 4 | b2);
+            int d = etc_distances[((b[3] >> 2) & 1) << 2 | (b[3] & 1) << 1 | order];
+            const int paint[4][3] = {
+                { extend4(r1) + d, extend4(g1) + d, extend4(b1) + d },
+                { extend4(r1) - d, extend4(g1) - d, extend4(b1) - d },
+                { extend4(r2) + d, extend4(g2) + d, extend4(b2) + d },
+                { extend4(r2) - d, extend4(g2) - d, extend4(b2) - d },
+            };
+
+            decode_paint(out, paint, indices, !opaque);
+            return;
+        }
+        if (!etc1 && (c2[2] < 0 || c2[2] > 31)) {
+            decode_planar(out, b);
+            return;
+        }
+        for (int c = 0; c < 3; c++) {
+            base[0][c] = extend5(c1[c]);
+            base[1][c] = extend5(c2[c]);
+        }
+    }
+    table[0] = b[3] >> 5;
+    table[1] = (b[3] >> 2) & 7;
+
+    for (int x = 0; x < 4; x++) {
+        for (int y = 0; y < 4; y++) {
+            int i = x * 4 + y;
+            int sub = flip ? y >= 2 : x >= 2;
+            int msb = (indices >> (16 + i)) & 1, lsb = (indices >> i) & 1;
+            int modifier = etc_modifiers[table[sub]][lsb];
+
+            if (msb)
+                modifier = -modifier;
+            if (!opaque) {
+                /* punch-through: index 2 is transparent, index 0 has no modifier */
+                if (msb && !lsb) {
+                    set_pixel(out[i], 0, 0, 0, 0);
+                    continue;
+                }
+                if (!msb && !lsb)
+                    modifier = 0;
+            }
+            set_pixel(out[i], base[sub][0] + modifier, base[sub][1] + modifier, base[sub][2] + modifier, 255);
+        }
+    }
+}
+
+static void decode_eac_alpha(uint8_t out[16][4], const uint8_t* b) {
+    const int base = b[0], multiplier = b[1] >> 4;
+    const int* modifiers = eac_modifiers[b[1] & 0xf];
+    uint64_t indices = 0;
+
+    for (int i = 2; i < 8; i++)
+        indices = indices << 8 | b[i];
+    for (int i = 0; i < 16; i++)
+        out[i][3] = clamp255(base + modifiers[(indices >> (45 - 3 * i)) & 7] * multiplier);
+}
+
+int ktx_decode_etc(const struct ktx* ktx, int level, uint8_t* rgba) {
+    const struct ktx_level* l = &ktx->levels[level];
+    const uint32_t f = ktx->internal_format;
+    const bool etc1 = f == GL_ETC1_RGB8_OES;
+    const bool punchthrough = f == GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 ||
+        f == GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+    const bool eac = f == GL_COMPRESSED_RGBA8_ETC2_EAC || f == GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+    const uint8_t* block = l->data;
+
+    if (!ktx_is_etc(f))
+        return -1;
+    for (int by = 0; by < l->height; by += 4) {
+        for (int bx = 0; bx < l->width; bx += 4) {
+            uint8_t pixels[16][4];
+
+            decode_etc_block(pixels, eac ? block + 8 : block, etc1, punchthrough);
+            if (eac)
+                decode_eac_alpha(pixels, block);
+            block += ktx->block_size;
+
+            /* edge blocks hang over the level */
+            for (int y = 0; y < 4 && by + y < l->height; y++) {
+                for (int x = 0; x < 4 && bx + x < l->width; x++)
+                    memcpy(rgba + ((size_t) (by + y) * l->width + bx + x) * 4, pixels[x * 4 + y], 4);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+KTX 1.1 and KTX 2.0 texture containers, memory mapped so the mip levels can
+be uploaded straight from the page cache, plus a CPU decoder for ETC1/ETC2
+as fallback on drivers without ETC2 texture support
+ */
+
+#ifndef _KTX_H
+#define _KTX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define KTX_MAX_LEVELS 16
+
+/* GL internal formats found in KTX files; GLES 3.0 glad only knows the ETC2 ones */
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#define GL_COMPRESSED_SRGB8_ETC2 0x9275
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#define GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9277
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC 0x9279
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0      /* ..0x93BD for 5x4 up to 12x12 */
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
+#endif
+
+struct ktx_level {
+    const uint8_t* data;        /* inside the mapping */
+    size_t size;
+    int width, height;
+};
+
+struct ktx {
+    void* map;
+    size_t map_size;
+    int version;                /* 1 or 2 */
+    uint32_t internal_format;
+    uint32_t format, type;      /* uncompressed data only, 0 for compressed formats */
+    int block_width, block_height, block_size;
+    int width, height;
+    int num_levels;
+    bool generate_mipmaps;      /* the file has only the base level and asks for a chain */
+    struct ktx_level levels[KTX_MAX_LEVELS];
+};
+
+/* Map and validate a 2D texture: no arrays, cube maps, 3D or supercompression */
+int ktx_open(struct ktx* ktx, const char* path);
+void ktx_close(struct ktx* ktx);
+
+/* Tell the kernel an uploaded level's pages are no longer needed */
+void ktx_release_level(struct ktx* ktx, int level);
+
+bool ktx_is_etc(uint32_t internal_format);
+bool ktx_is_astc(uint32_t internal_format);
+bool ktx_is_srgb(uint32_t internal_format);
+
+/* Decode an ETC1/ETC2/EAC level to width * height RGBA8 pixels */
+int ktx_decode_etc(const struct ktx* ktx, int level, uint8_t* rgba);
+
+#endif /* _KTX_H */
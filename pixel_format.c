@@ -0,0 +1,46 @@
+/*
+Scanout pixel formats selectable at runtime
+ */
+
+#include "pixel_format.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <libdrm/drm_fourcc.h>
+
+static const struct pixel_format pixel_formats[] = {
+    { "XRGB8888",    DRM_FORMAT_XRGB8888,    8,  8,  8,  0, 32 },
+    { "ARGB8888",    DRM_FORMAT_ARGB8888,    8,  8,  8,  8, 32 },
+    /* half the scanout and render bandwidth, for low-end SoCs */
+    { "RGB565",      DRM_FORMAT_RGB565,      5,  6,  5,  0, 16 },
+    /* 10 bits per channel for HDR-capable or banding-sensitive output */
+    { "XRGB2101010", DRM_FORMAT_XRGB2101010, 10, 10, 10, 0, 32 },
+};
+
+#define NUM_PIXEL_FORMATS (sizeof(pixel_formats) / sizeof(pixel_formats[0]))
+
+const struct pixel_format* pixel_format_by_name(const char* name) {
+    for (unsigned i = 0; i < NUM_PIXEL_FORMATS; i++) {
+        if (strcasecmp(pixel_formats[i].name, name) == 0)
+            return &pixel_formats[i];
+    }
+    return NULL;
+}
+
+const struct pixel_format* pixel_format_by_fourcc(uint32_t fourcc) {
+    for (unsigned i = 0; i < NUM_PIXEL_FORMATS; i++) {
+        if (pixel_formats[i].fourcc == fourcc)
+            return &pixel_formats[i];
+    }
+    return NULL;
+}
+
+const char* pixel_format_names(void) {
+    static char names[64];
+
+    if (!names[0]) {
+        for (unsigned i = 0; i < NUM_PIXEL_FORMATS; i++)
+            snprintf(names + strlen(names), sizeof(names) - strlen(names), "%s%s", i ? ", " : "", pixel_formats[i].name);
+    }
+    return names;
+}
@@ -0,0 +1,25 @@
+/*
+Scanout pixel formats selectable at runtime, with the EGL config channel
+sizes that render to them
+ */
+
+#ifndef _PIXEL_FORMAT_H
+#define _PIXEL_FORMAT_H
+
+#include <stdint.h>
+
+struct pixel_format {
+    const char* name;
+    uint32_t fourcc;            /* DRM_FORMAT_*, also the EGL native visual id */
+    int red, green, blue, alpha;
+    int bpp;
+};
+
+/* NULL if the format is not supported, names are matched case-insensitively */
+const struct pixel_format* pixel_format_by_name(const char* name);
+const struct pixel_format* pixel_format_by_fourcc(uint32_t fourcc);
+
+/* "XRGB8888, ARGB8888, ..." for usage texts */
+const char* pixel_format_names(void);
+
+#endif /* _PIXEL_FORMAT_H */
@@ -0,0 +1,73 @@
+/*
+Target profiles: what a platform's display and GPU are known to do, as compile-time
+constants. The library tests them in plain if statements, so on a known target the
+compiler drops the branches for hardware it does not have and the runtime checks for
+what it always has. Without a target macro the generic profile asks the driver.
+ */
+
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+/* a feature the driver has to be asked about */
+#define PROFILE_DETECT -1
+
+/* The profile's value for feature, or detected when the profile does not know */
+#define profile_has(feature, detected) ((feature) == PROFILE_DETECT ? (detected) : (feature))
+
+/*
+ * PROFILE_API           context API init_egl() takes for GL_API_AUTO
+ * PROFILE_FORMAT        default scanout format
+ * PROFILE_MODIFIERS     0: implicit buffer layouts only, 1: format modifiers
+ * PROFILE_FB_PLANES     memory planes (dma-buf fds) of a scanout buffer, not KMS planes
+ * PROFILE_BUFFER_AGE    back buffers keep their contents (partial redraws with -d)
+ * PROFILE_DAMAGE_CLIPS  primary plane takes FB_DAMAGE_CLIPS (atomic flips with -d)
+ *
+ * There is no buffering mode knob: every target runs the same loop, one flip in
+ * flight per output, and GBM picks how many buffers the surface cycles through.
+ * There is no knob for the number of KMS planes either: the overlay and cursor
+ * planes are looked up per CRTC by find_plane_for_format() and find_plane(),
+ * and whether one is free depends on the CRTC and on the other DRM clients,
+ * which a constant cannot know. No branch would fold away.
+ */
+#if defined(STEAMDECK)
+/* AMD APU: Mesa radeonsi, DCC compressed scanout buffers */
+#define PROFILE_NAME "steamdeck"
+#define PROFILE_API GL_API_AUTO
+#define PROFILE_FORMAT DRM_FORMAT_ARGB8888
+#define PROFILE_MODIFIERS 1
+#define PROFILE_FB_PLANES PROFILE_DETECT    /* 1 to 3 with DCC, depends on the modifier */
+#define PROFILE_BUFFER_AGE 1
+#define PROFILE_DAMAGE_CLIPS PROFILE_DETECT
+#elif defined(RPI4)
+/* Broadcom V3D renders, VC4 scans out: full OpenGL is 2.1 only, GLES is 3.1 */
+#define PROFILE_NAME "rpi4"
+#define PROFILE_API GL_API_GLES
+#define PROFILE_FORMAT DRM_FORMAT_ARGB8888
+#define PROFILE_MODIFIERS 1
+#define PROFILE_FB_PLANES 1                 /* RGB, T-tiled or linear */
+#define PROFILE_BUFFER_AGE 1
+#define PROFILE_DAMAGE_CLIPS PROFILE_DETECT
+#elif defined(RG353P)
+/* Rockchip RK3566: the Mali blob's GBM allocates implicit layouts, the VOP ignores damage */
+#define PROFILE_NAME "rg353p"
+#define PROFILE_API GL_API_GLES
+#define PROFILE_FORMAT DRM_FORMAT_XRGB8888
+#define PROFILE_MODIFIERS 0
+#define PROFILE_FB_PLANES 1
+#define PROFILE_BUFFER_AGE PROFILE_DETECT
+#define PROFILE_DAMAGE_CLIPS 0
+#else
+#define PROFILE_NAME "generic"
+#define PROFILE_API GL_API_AUTO
+#ifdef DRM_FORMAT_USE_NO_TRANSPARENCY
+#define PROFILE_FORMAT DRM_FORMAT_XRGB8888
+#else
+#define PROFILE_FORMAT DRM_FORMAT_ARGB8888
+#endif
+#define PROFILE_MODIFIERS PROFILE_DETECT
+#define PROFILE_FB_PLANES PROFILE_DETECT
+#define PROFILE_BUFFER_AGE PROFILE_DETECT
+#define PROFILE_DAMAGE_CLIPS PROFILE_DETECT
+#endif
+
+#endif /* _PROFILE_H */
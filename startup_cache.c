@@ -0,0 +1,193 @@
+/*
+On-disk cache of the last chosen connector/CRTC/mode and EGL configs per DRM device
+
+The cache is a small text file, one "output" line per device and one "config"
+line per device and config request, most recently used first. Its location is $KMSDRM_CACHE, else $XDG_CACHE_HOME or
+$HOME/.cache, else /tmp. Setting KMSDRM_CACHE to an empty string disables it.
+Entries are only hints: init_drm() validates them against the hardware.
+ */
+
+#include "startup_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CACHE_FILE_NAME "kmsdrm_basic.cache"
+#define CACHE_MAX_LINES 16
+#define CACHE_LINE_LEN 512
+
+static bool cache_path(char* path, size_t len) {
+    const char* env = getenv("KMSDRM_CACHE");
+
+    if (env) {
+        if (!*env)
+            return false;
+        snprintf(path, len, "%s", env);
+    } else if ((env = getenv("XDG_CACHE_HOME")) && *env) {
+        snprintf(path, len, "%s/" CACHE_FILE_NAME, env);
+    } else if ((env = getenv("HOME")) && *env) {
+        snprintf(path, len, "%s/.cache/" CACHE_FILE_NAME, env);
+    } else {
+        snprintf(path, len, "/tmp/" CACHE_FILE_NAME);
+    }
+    return true;
+}
+
+static bool parse_output(const char* line, struct startup_cache_output* out) {
+    drmModeModeInfo* m = &out->mode;
+    unsigned int hdisplay, hsync_start, hsync_end, htotal, hskew;
+    unsigned int vdisplay, vsync_start, vsync_end, vtotal, vscan;
+    char name[DRM_DISPLAY_MODE_LEN];
+
+    memset(out, 0, sizeof(*out));
+    if (sscanf(line, "output %255s %u %u %u %u %u %u %u %u %u %u %u %u %u %u %u %u %31s",
+        out->device, &out->connector_id, &out->crtc_id, &m->clock,
+        &hdisplay, &hsync_start, &hsync_end, &htotal, &hskew,
+        &vdisplay, &vsync_start, &vsync_end, &vtotal, &vscan,
+        &m->vrefresh, &m->flags, &m->type, name) != 18)
+        return false;
+
+    m->hdisplay = hdisplay; m->hsync_start = hsync_start; m->hsync_end = hsync_end;
+    m->htotal = htotal; m->hskew = hskew;
+    m->vdisplay = vdisplay; m->vsync_start = vsync_start; m->vsync_end = vsync_end;
+    m->vtotal = vtotal; m->vscan = vscan;
+    if (strcmp(name, "-") != 0)
+        snprintf(m->name, sizeof(m->name), "%s", name);
+    return true;
+}
+
+static void format_output(char* line, size_t len, const struct startup_cache_output* out) {
+    const drmModeModeInfo* m = &out->mode;
+
+    snprintf(line, len, "output %s %u %u %u %u %u %u %u %u %u %u %u %u %u %u %u %u %s\n",
+        out->device, out->connector_id, out->crtc_id, m->clock,
+        m->hdisplay, m->hsync_start, m->hsync_end, m->htotal, m->hskew,
+        m->vdisplay, m->vsync_start, m->vsync_end, m->vtotal, m->vscan,
+        m->vrefresh, m->flags, m->type, m->name[0] ? m->name : "-");
+}
+
+bool startup_cache_load_output(const char* device, struct startup_cache_output* out) {
+    char path[STARTUP_CACHE_PATH_LEN], line[CACHE_LINE_LEN];
+    bool found = false;
+    FILE* fp;
+
+    if (!cache_path(path, sizeof(path)))
+        return false;
+    fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (!parse_output(line, out))
+            continue;
+        if (!device || strcmp(device, out->device) == 0) {
+            found = true;
+            break;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+/* Put line first, replacing the entry whose line starts with key. The other
+ * lines keep their order, whatever their kind.
+ */
+static int store_line(const char* line, const char* key) {
+    char path[STARTUP_CACHE_PATH_LEN], tmp_path[STARTUP_CACHE_PATH_LEN + 8];
+    char lines[CACHE_MAX_LINES][CACHE_LINE_LEN];
+    size_t key_len = strlen(key), kind_len = strcspn(key, " ");
+    bool first_of_kind = true;
+    int i, fd, count = 0;
+    char* slash;
+    FILE* fp;
+
+    if (!cache_path(path, sizeof(path)))
+        return 0;
+
+    snprintf(lines[count++], CACHE_LINE_LEN, "%s", line);
+    fp = fopen(path, "r");
+    if (fp) {
+        while (count < CACHE_MAX_LINES && fgets(lines[count], CACHE_LINE_LEN, fp)) {
+            if (strncmp(lines[count], key, key_len) == 0) {
+                /* nothing changed: skip the rewrite */
+                if (first_of_kind && strcmp(lines[0], lines[count]) == 0) {
+                    fclose(fp);
+                    return 0;
+                }
+                continue;
+            }
+            if (strncmp(lines[count], key, kind_len + 1) == 0)
+                first_of_kind = false;
+            count++;
+        }
+        fclose(fp);
+    }
+
+    /* ~/.cache may not exist yet on a minimal root filesystem */
+    snprintf(tmp_path, sizeof(tmp_path), "%s", path);
+    slash = strrchr(tmp_path, '/');
+    if (slash && slash != tmp_path) {
+        *slash = '\0';
+        if (mkdir(tmp_path, 0700) && errno != EEXIST)
+            return -1;
+    }
+
+    /* write to a temporary file and rename, so a crash never leaves a torn
+     * cache. mkstemp() picks a fresh name: a fixed one in /tmp could be a
+     * symlink planted by another user.
+     */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path);
+    fd = mkstemp(tmp_path);
+    if (fd < 0)
+        return -1;
+    fp = fdopen(fd, "w");
+    if (!fp) {
+        close(fd);
+        unlink(tmp_path);
+        return -1;
+    }
+    for (i = 0; i < count; i++)
+        fputs(lines[i], fp);
+    if (fclose(fp) != 0 || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+int startup_cache_store_output(const struct startup_cache_output* out) {
+    char line[CACHE_LINE_LEN], key[CACHE_LINE_LEN];
+
+    format_output(line, sizeof(line), out);
+    snprintf(key, sizeof(key), "output %s ", out->device);
+    return store_line(line, key);
+}
+
+bool startup_cache_load_config(const char* device, const char* request, int* config_id) {
+    char path[STARTUP_CACHE_PATH_LEN], line[CACHE_LINE_LEN], key[CACHE_LINE_LEN];
+    bool found = false;
+    FILE* fp;
+
+    if (!cache_path(path, sizeof(path)))
+        return false;
+    fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    snprintf(key, sizeof(key), "config %s %s ", device, request);
+    while (!found && fgets(line, sizeof(line), fp))
+        found = strncmp(line, key, strlen(key)) == 0 && sscanf(line + strlen(key), "%d", config_id) == 1;
+    fclose(fp);
+    return found;
+}
+
+int startup_cache_store_config(const char* device, const char* request, int config_id) {
+    char line[CACHE_LINE_LEN], key[CACHE_LINE_LEN];
+
+    snprintf(key, sizeof(key), "config %s %s ", device, request);
+    snprintf(line, sizeof(line), "%s%d\n", key, config_id);
+    return store_line(line, key);
+}
@@ -0,0 +1,37 @@
+/*
+On-disk cache of the last chosen connector/CRTC/mode per DRM device, used by
+init_drm() to skip connector probing on startup, and of the EGL configs
+init_egl() chose, so it can skip scoring every config
+ */
+
+#ifndef _STARTUP_CACHE_H
+#define _STARTUP_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xf86drmMode.h>
+
+#define STARTUP_CACHE_PATH_LEN 256
+
+struct startup_cache_output {
+    char device[STARTUP_CACHE_PATH_LEN];
+    uint32_t connector_id;
+    uint32_t crtc_id;
+    drmModeModeInfo mode;
+};
+
+/* Look up the entry for device, or the most recently used entry when device
+ * is NULL. Returns false when there is no usable entry.
+ */
+bool startup_cache_load_output(const char* device, struct startup_cache_output* out);
+
+/* Insert or replace the entry for out->device and make it the most recent */
+int startup_cache_store_output(const struct startup_cache_output* out);
+
+/* EGL_CONFIG_ID chosen on device for request, a string without spaces that
+ * names everything the choice depended on
+ */
+bool startup_cache_load_config(const char* device, const char* request, int* config_id);
+int startup_cache_store_config(const char* device, const char* request, int config_id);
+
+#endif /* _STARTUP_CACHE_H */
@@ -0,0 +1,126 @@
+/*
+Startup profiler
+
+Phases are kept in a fixed array in the order they begin, with their nesting
+depth, so printing them in order gives the waterfall. Times are CLOCK_MONOTONIC
+relative to a constructor that runs before main(): what exec and the dynamic
+linker cost is not included.
+ */
+
+#include "startup_trace.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WATERFALL_WIDTH 40
+
+struct startup_phase {
+    const char* name;
+    int64_t start, end;         /* ns since the origin, end 0 while open */
+    int depth;
+};
+
+static struct {
+    int64_t origin;
+    struct startup_phase phases[STARTUP_TRACE_MAX_PHASES];
+    int count;
+    int depth;                  /* open phases */
+    bool done;
+} trace;
+
+static int64_t trace_time(void) {
+    struct timespec tv;
+
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return tv.tv_sec * INT64_C(1000000000) + tv.tv_nsec - trace.origin;
+}
+
+__attribute__((constructor)) static void startup_trace_init(void) {
+    trace.origin = trace_time();
+}
+
+int startup_trace_begin(const char* name) {
+    struct startup_phase* phase;
+
+    if (trace.done || trace.count == STARTUP_TRACE_MAX_PHASES)
+        return -1;
+    phase = &trace.phases[trace.count];
+    phase->name = name;
+    phase->start = trace_time();
+    phase->end = 0;
+    phase->depth = trace.depth++;
+    return trace.count++;
+}
+
+void startup_trace_end(int phase) {
+    int64_t now;
+
+    if (phase < 0 || trace.done)
+        return;
+    /* early returns can leave inner phases open: they end here too */
+    now = trace_time();
+    for (int i = phase; i < trace.count; i++) {
+        if (!trace.phases[i].end)
+            trace.phases[i].end = now;
+    }
+    trace.depth = trace.phases[phase].depth;
+}
+
+static void print_waterfall(int64_t first_frame) {
+    printf("Startup to first frame: %.2fms\n", first_frame / 1e6);
+    for (int i = 0; i < trace.count; i++) {
+        const struct startup_phase* phase = &trace.phases[i];
+        int from = phase->start * WATERFALL_WIDTH / first_frame;
+        int to = phase->end * WATERFALL_WIDTH / first_frame;
+        char bar[WATERFALL_WIDTH + 1];
+
+        for (int x = 0; x < WATERFALL_WIDTH; x++)
+            bar[x] = x < from ? ' ' : x <= to ? '#' : ' ';
+        bar[WATERFALL_WIDTH] = '\0';
+        printf("  %*s%-*s %8.2f %8.2fms |%s|\n", 2 * phase->depth, "", 28 - 2 * phase->depth, phase->name,
+            phase->start / 1e6, (phase->end - phase->start) / 1e6, bar);
+    }
+}
+
+/* Chrome trace event format: complete events ("X") nest by time on one thread */
+static void write_trace(const char* path, int64_t first_frame) {
+    FILE* out = fopen(path, "w");
+    int pid = getpid();
+
+    if (!out) {
+        printf("startup_trace: cannot write %s\n", path);
+        return;
+    }
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < trace.count; i++) {
+        const struct startup_phase* phase = &trace.phases[i];
+
+        fprintf(out, "{\"name\":\"%s\",\"cat\":\"startup\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d},\n",
+            phase->name, phase->start / 1e3, (phase->end - phase->start) / 1e3, pid, pid);
+    }
+    fprintf(out, "{\"name\":\"first frame\",\"cat\":\"startup\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}\n]}\n",
+        first_frame / 1e3, pid, pid);
+    fclose(out);
+    printf("Startup trace written to %s\n", path);
+}
+
+void startup_trace_first_frame(void) {
+    const char* path = getenv("KMSDRM_STARTUP_TRACE");
+    int64_t first_frame;
+
+    if (trace.done)
+        return;
+    first_frame = trace_time();
+    /* whatever is still open lasted until now */
+    for (int i = 0; i < trace.count; i++) {
+        if (!trace.phases[i].end)
+            trace.phases[i].end = first_frame;
+    }
+    trace.done = true;
+    print_waterfall(first_frame);
+    if (path && *path)
+        write_trace(path, first_frame);
+}
@@ -0,0 +1,27 @@
+/*
+Startup profiler: named phases on the way to the first frame, timed from just
+before main(), printed as a waterfall when the first frame reaches the screen
+and written as a Chrome trace (chrome://tracing, Perfetto) to the file named by
+$KMSDRM_STARTUP_TRACE. Phases nest; record them from the main thread only.
+ */
+
+#ifndef _STARTUP_TRACE_H
+#define _STARTUP_TRACE_H
+
+#define STARTUP_TRACE_MAX_PHASES 64
+
+/* Start a phase, name must outlive the trace (a string literal). Returns the
+ * phase for startup_trace_end(), -1 once the first frame is shown or the trace
+ * is full.
+ */
+int startup_trace_begin(const char* name);
+
+/* End phase and every phase begun inside it that is still open */
+void startup_trace_end(int phase);
+
+/* The first frame is on screen: print the waterfall and write the trace.
+ * Only the first call does anything, later phases are not recorded.
+ */
+void startup_trace_first_frame(void);
+
+#endif /* _STARTUP_TRACE_H */
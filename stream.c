@@ -0,0 +1,257 @@
+/*
+Live frame streaming
+
+The render thread only pushes a descriptor of a mapped readback buffer into
+a single-producer single-consumer ring: two atomic indices and a semaphore
+post, no lock the encoder could hold. When the ring is full the frame is
+dropped, so a slow encoder costs frames in the recording, never frame time
+on screen. The encoder thread converts the frame to I420 and hands it to
+the encoder stage: a YUV4MPEG2 file, or the same stream piped into an
+external process that does the actual H.264 encoding.
+ */
+
+#include "stream.h"
+#include "kmsdrm.h"
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================================
+// encoder stages
+// ============================================================================================
+
+static int write_y4m_header(struct stream* stream) {
+    /* C420jpeg: full range BT.601, chroma centered between the luma samples */
+    return fprintf(stream->file, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C420jpeg\n",
+        stream->width, stream->height, stream->fps) < 0 ? -1 : 0;
+}
+
+static int y4m_write(struct stream* stream, const uint8_t* data, size_t size) {
+    if (fputs("FRAME\n", stream->file) < 0 || fwrite(data, 1, size, stream->file) != size)
+        return -1;
+    stream->bytes += size + 6;
+    return 0;
+}
+
+static int y4m_file_open(struct stream* stream, const char* target) {
+    stream->file = fopen(target, "wb");
+    if (!stream->file) {
+        printf("stream: cannot write %s\n", target);
+        return -1;
+    }
+    return write_y4m_header(stream);
+}
+
+static void y4m_file_close(struct stream* stream) {
+    fclose(stream->file);
+}
+
+static int pipe_open(struct stream* stream, const char* target) {
+    /* a dying encoder must fail the writes, not kill the renderer */
+    signal(SIGPIPE, SIG_IGN);
+    stream->file = popen(target + 1, "w");
+    if (!stream->file) {
+        printf("stream: cannot run %s\n", target + 1);
+        return -1;
+    }
+    return write_y4m_header(stream);
+}
+
+static void pipe_close(struct stream* stream) {
+    int status = pclose(stream->file);
+
+    if (status)
+        printf("stream: encoder exited with status %d\n", status);
+}
+
+static const struct stream_encoder encoders[] = {
+    { "|", pipe_open, y4m_write, pipe_close },
+    { "", y4m_file_open, y4m_write, y4m_file_close },
+};
+
+// ============================================================================================
+// conversion
+// ============================================================================================
+
+/* full range chroma of saturated colors reaches 255.5 */
+static inline uint8_t clamp_u8(int v) {
+    return v > 255 ? 255 : v;
+}
+
+/* Bottom-up RGBA/BGRA rows to top-down I420, full range BT.601 in 8.8 fixed
+ * point. Chroma is the average of each 2x2 block.
+ */
+static void convert_i420(const struct stream* stream, const uint8_t* pixels) {
+    const int w = stream->width, h = stream->height;
+    const int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    const size_t stride = (size_t) w * 4;
+    const int r = stream->bgra ? 2 : 0, b = stream->bgra ? 0 : 2;
+    uint8_t* y_plane = stream->yuv;
+    uint8_t* u_plane = y_plane + (size_t) w * h;
+    uint8_t* v_plane = u_plane + (size_t) cw * ch;
+
+    for (int y = 0; y < h; y += 2) {
+        const uint8_t* row0 = pixels + (h - 1 - y) * stride;
+        const uint8_t* row1 = y + 1 < h ? row0 - stride : row0;
+        uint8_t* y0 = y_plane + (size_t) y * w;
+        uint8_t* y1 = y + 1 < h ? y0 + w : y0;
+        uint8_t* u = u_plane + (size_t) (y / 2) * cw;
+        uint8_t* v = v_plane + (size_t) (y / 2) * cw;
+
+        for (int x = 0; x < w; x += 2) {
+            const uint8_t* p[4] = { row0 + x * 4, row1 + x * 4, row0 + x * 4, row1 + x * 4 };
+            int sr = 0, sg = 0, sb = 0;
+
+            if (x + 1 < w) {
+                p[2] += 4;
+                p[3] += 4;
+            }
+            for (int i = 0; i < 4; i++) {
+                sr += p[i][r];
+                sg += p[i][1];
+                sb += p[i][b];
+            }
+            y0[x] = (77 * p[0][r] + 150 * p[0][1] + 29 * p[0][b] + 128) >> 8;
+            y1[x] = (77 * p[1][r] + 150 * p[1][1] + 29 * p[1][b] + 128) >> 8;
+            if (x + 1 < w) {
+                y0[x + 1] = (77 * p[2][r] + 150 * p[2][1] + 29 * p[2][b] + 128) >> 8;
+                y1[x + 1] = (77 * p[3][r] + 150 * p[3][1] + 29 * p[3][b] + 128) >> 8;
+            }
+            /* sums of four samples: >> 10 averages and scales at once */
+            u[x / 2] = clamp_u8((-43 * sr - 85 * sg + 128 * sb + (128 << 10) + 512) >> 10);
+            v[x / 2] = clamp_u8((128 * sr - 107 * sg - 21 * sb + (128 << 10) + 512) >> 10);
+        }
+    }
+}
+
+// ============================================================================================
+// queue
+// ============================================================================================
+
+static void* stream_thread(void* data) {
+    struct stream* stream = data;
+
+    while (true) {
+        unsigned int head = atomic_load_explicit(&stream->head, memory_order_relaxed);
+        struct stream_frame frame;
+        int64_t t;
+
+        sem_wait(&stream->ready);
+        if (head == atomic_load_explicit(&stream->tail, memory_order_acquire)) {
+            if (atomic_load(&stream->quit))
+                break;
+            continue;
+        }
+        frame = stream->queue[head % STREAM_QUEUE];
+
+        /* after a write error keep consuming, so the producer never stalls */
+        if (!stream->failed) {
+            t = get_time_ns();
+            convert_i420(stream, frame.pixels);
+            stream->convert_ns += get_time_ns() - t;
+            t = get_time_ns();
+            if (stream->encoder->write(stream, stream->yuv, stream->yuv_size)) {
+                printf("stream: encoder write failed at frame %u, dropping the rest\n", frame.number);
+                stream->failed = true;
+            } else {
+                stream->encoded++;
+            }
+            stream->write_ns += get_time_ns() - t;
+        }
+
+        atomic_store_explicit(&stream->busy[frame.slot], false, memory_order_release);
+        atomic_store_explicit(&stream->head, head + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+int stream_start(struct stream* stream, const char* target, int width, int height, unsigned int fps, bool bgra) {
+    memset(stream, 0, sizeof(*stream));
+    stream->width = width;
+    stream->height = height;
+    stream->fps = fps ? fps : 60;
+    stream->bgra = bgra;
+    stream->yuv_size = (size_t) width * height + 2 * (size_t) ((width + 1) / 2) * ((height + 1) / 2);
+    stream->yuv = malloc(stream->yuv_size);
+    if (!stream->yuv)
+        return -1;
+
+    for (unsigned int i = 0; i < sizeof(encoders) / sizeof(encoders[0]); i++) {
+        if (!strncmp(target, encoders[i].prefix, strlen(encoders[i].prefix))) {
+            stream->encoder = &encoders[i];
+            break;
+        }
+    }
+    if (stream->encoder->open(stream, target)) {
+        if (stream->file)
+            stream->encoder->close(stream);
+        free(stream->yuv);
+        stream->yuv = NULL;
+        return -1;
+    }
+
+    sem_init(&stream->ready, 0, 0);
+    stream->start_ns = get_time_ns();
+    if (pthread_create(&stream->thread, NULL, stream_thread, stream)) {
+        printf("stream_start: failed to create encoder thread\n");
+        stream->encoder->close(stream);
+        sem_destroy(&stream->ready);
+        free(stream->yuv);
+        stream->yuv = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+bool stream_push(struct stream* stream, int slot, const void* pixels, unsigned int number) {
+    unsigned int tail = atomic_load_explicit(&stream->tail, memory_order_relaxed);
+
+    if (tail - atomic_load_explicit(&stream->head, memory_order_acquire) >= STREAM_QUEUE) {
+        stream->dropped++;
+        return false;
+    }
+    stream->queue[tail % STREAM_QUEUE] = (struct stream_frame) { slot, pixels, number };
+    atomic_store_explicit(&stream->busy[slot], true, memory_order_relaxed);
+    atomic_store_explicit(&stream->tail, tail + 1, memory_order_release);
+    sem_post(&stream->ready);
+    return true;
+}
+
+void stream_skip(struct stream* stream) {
+    stream->skipped++;
+}
+
+bool stream_busy(struct stream* stream, int slot) {
+    return atomic_load_explicit(&stream->busy[slot], memory_order_acquire);
+}
+
+void stream_drain(struct stream* stream) {
+    const struct timespec pause = { 0, 1000000 };
+
+    while (atomic_load_explicit(&stream->head, memory_order_acquire) !=
+        atomic_load_explicit(&stream->tail, memory_order_relaxed))
+        nanosleep(&pause, NULL);
+}
+
+void stream_stop(struct stream* stream) {
+    double secs;
+
+    if (!stream->yuv)
+        return;
+    atomic_store(&stream->quit, true);
+    sem_post(&stream->ready);
+    pthread_join(stream->thread, NULL);
+    secs = (get_time_ns() - stream->start_ns) / 1e9;
+    stream->encoder->close(stream);
+    sem_destroy(&stream->ready);
+    free(stream->yuv);
+    stream->yuv = NULL;
+
+    printf("stream: %u frames encoded, %u dropped (%u queue full, %u readback busy), %.1f fps, %.1f MB/s\n",
+        stream->encoded, stream->dropped + stream->skipped, stream->dropped, stream->skipped,
+        stream->encoded / secs, stream->bytes / 1e6 / secs);
+    if (stream->encoded)
+        printf("stream: convert %.3f ms/frame, encoder write %.3f ms/frame (encoder thread)\n",
+            stream->convert_ns / 1e6 / stream->encoded, stream->write_ns / 1e6 / stream->encoded);
+}
@@ -0,0 +1,87 @@
+/*
+Live frame streaming: read back frames travel through a bounded lock-free
+queue to an encoder thread that writes a YUV4MPEG2 stream to a file or
+pipes it into an external encoder (ffmpeg, gst-launch) for H.264
+ */
+
+#ifndef _STREAM_H
+#define _STREAM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+/* frames in flight, one per pixel pack buffer of the readback ring */
+#define STREAM_QUEUE 4
+
+struct stream;
+
+/* Encoder stage: consumes I420 frames on the encoder thread */
+struct stream_encoder {
+    const char* prefix;         /* selects the encoder from the target string */
+    int (*open)(struct stream* stream, const char* target);
+    int (*write)(struct stream* stream, const uint8_t* data, size_t size);
+    void (*close)(struct stream* stream);
+};
+
+struct stream_frame {
+    int slot;
+    const void* pixels;
+    unsigned int number;
+};
+
+struct stream {
+    const struct stream_encoder* encoder;
+    FILE* file;
+    int width, height;
+    unsigned int fps;
+    bool bgra;
+    uint8_t* yuv;               /* I420 frame being encoded */
+    size_t yuv_size;
+
+    /* single producer (render thread), single consumer (encoder thread) */
+    struct stream_frame queue[STREAM_QUEUE];
+    atomic_uint head, tail;
+    atomic_bool busy[STREAM_QUEUE];
+    sem_t ready;
+    atomic_bool quit;
+    pthread_t thread;
+
+    /* statistics */
+    unsigned int dropped;       /* render thread: queue full */
+    unsigned int skipped;       /* render thread: never read back, see stream_skip() */
+    unsigned int encoded;       /* encoder thread */
+    bool failed;
+    uint64_t bytes;
+    int64_t start_ns, convert_ns, write_ns;
+};
+
+/* target is a file name for a .y4m stream, or "|command" to pipe the stream
+ * into an encoder, e.g. "|ffmpeg -f yuv4mpegpipe -i - -c:v libx264 out.mkv"
+ */
+int stream_start(struct stream* stream, const char* target, int width, int height, unsigned int fps, bool bgra);
+
+/* Flush the queue, close the encoder and print the throughput */
+void stream_stop(struct stream* stream);
+
+/* Queue the pixels of readback slot (below STREAM_QUEUE; bottom-up RGBA or
+ * BGRA rows). Returns false, counting a dropped frame, when the encoder is
+ * behind and the queue is full. Never blocks.
+ */
+bool stream_push(struct stream* stream, int slot, const void* pixels, unsigned int number);
+
+/* Count a frame the producer skipped before it reached the queue, e.g. because
+ * its readback slot was still being encoded. Shown with the drops at the end.
+ */
+void stream_skip(struct stream* stream);
+
+/* Whether the encoder still reads the pixels queued for slot */
+bool stream_busy(struct stream* stream, int slot);
+
+/* Wait until the encoder has consumed every queued frame */
+void stream_drain(struct stream* stream);
+
+#endif /* _STREAM_H */
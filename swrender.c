@@ -0,0 +1,489 @@
+/*
+Software rendering backend: DRM dumb buffers + CPU rasterizer
+
+Primitives are recorded into a command list and rasterized by sw_flush(),
+which splits the frame into horizontal bands of scanlines, one per thread.
+Every thread walks the whole command list clipped to its band, so no locking
+is needed while drawing. Span kernels use SSE2 or NEON when available.
+ */
+
+#include "swrender.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <libdrm/drm_fourcc.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifdef DEBUG
+#define debug_printf printf
+#else
+#define debug_printf (void)
+#endif
+
+// ============================================================================================
+// span kernels
+// ============================================================================================
+
+/* exact x / 255 for x <= 255 * 255, after adding the rounding bias */
+static inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t blend_pixel(uint32_t dst, uint32_t src, uint32_t a) {
+    uint32_t inv = 255 - a;
+    uint32_t r = div255(((src >> 16) & 0xff) * a + ((dst >> 16) & 0xff) * inv);
+    uint32_t g = div255(((src >> 8) & 0xff) * a + ((dst >> 8) & 0xff) * inv);
+    uint32_t b = div255((src & 0xff) * a + (dst & 0xff) * inv);
+    return 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+static void span_fill(uint32_t* dst, int n, uint32_t color) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i c = _mm_set1_epi32(color);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i*) (dst + i), c);
+#elif defined(__ARM_NEON)
+    const uint32x4_t c = vdupq_n_u32(color);
+    for (; i + 4 <= n; i += 4)
+        vst1q_u32(dst + i, c);
+#endif
+    for (; i < n; i++)
+        dst[i] = color;
+}
+
+/* dst = color * a + dst * (1 - a), a taken from the color's alpha */
+static void span_blend(uint32_t* dst, int n, uint32_t color) {
+    const uint32_t a = color >> 24;
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i inv = _mm_set1_epi16(255 - a);
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    /* color * a per channel, for two pixels */
+    const __m128i src = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(color), zero),
+        _mm_set1_epi16(a)), bias);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*) (dst + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), alpha_mask));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x8_t inv = vdup_n_u8(255 - a);
+    const uint16x8_t sb = vdupq_n_u16((color & 0xff) * a);
+    const uint16x8_t sg = vdupq_n_u16(((color >> 8) & 0xff) * a);
+    const uint16x8_t sr = vdupq_n_u16(((color >> 16) & 0xff) * a);
+
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t d = vld4_u8((const uint8_t*) (dst + i));
+        uint16x8_t b = vmlal_u8(sb, d.val[0], inv);
+        uint16x8_t g = vmlal_u8(sg, d.val[1], inv);
+        uint16x8_t r = vmlal_u8(sr, d.val[2], inv);
+        d.val[0] = vrshrn_n_u16(vrsraq_n_u16(b, b, 8), 8);
+        d.val[1] = vrshrn_n_u16(vrsraq_n_u16(g, g, 8), 8);
+        d.val[2] = vrshrn_n_u16(vrsraq_n_u16(r, r, 8), 8);
+        d.val[3] = vdup_n_u8(0xff);
+        vst4_u8((uint8_t*) (dst + i), d);
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = blend_pixel(dst[i], color, a);
+}
+
+/* dst = src * src.a + dst * (1 - src.a), per pixel */
+static void span_blend_src(uint32_t* dst, const uint32_t* src, int n) {
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(255);
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*) (dst + i));
+        __m128i s_lo = _mm_unpacklo_epi8(s, zero), s_hi = _mm_unpackhi_epi8(s, zero);
+        /* broadcast each pixel's alpha (word 3) to its four channels */
+        __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xff), 0xff);
+        __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xff), 0xff);
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, a_lo),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(ones, a_lo)));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, a_hi),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(ones, a_hi)));
+        lo = _mm_add_epi16(lo, bias);
+        hi = _mm_add_epi16(hi, bias);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), alpha_mask));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t s = vld4_u8((const uint8_t*) (src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t*) (dst + i));
+        uint8x8_t inv = vmvn_u8(s.val[3]);
+        for (int c = 0; c < 3; c++) {
+            uint16x8_t x = vmlal_u8(vmull_u8(s.val[c], s.val[3]), d.val[c], inv);
+            d.val[c] = vrshrn_n_u16(vrsraq_n_u16(x, x, 8), 8);
+        }
+        d.val[3] = vdup_n_u8(0xff);
+        vst4_u8((uint8_t*) (dst + i), d);
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = blend_pixel(dst[i], src[i], src[i] >> 24);
+}
+
+// ============================================================================================
+// band rasterization
+// ============================================================================================
+
+/* x range covered by the triangle on the scanline through pixel centers at yc */
+static bool triangle_span(const float* v, float yc, int* x0, int* x1) {
+    float xmin = 1e30f, xmax = -1e30f;
+    int hits = 0;
+
+    for (int e = 0; e < 3; e++) {
+        float ax = v[e * 2], ay = v[e * 2 + 1];
+        float bx = v[((e + 1) % 3) * 2], by = v[((e + 1) % 3) * 2 + 1];
+
+        if (ay > by) {
+            float t;
+            t = ax; ax = bx; bx = t;
+            t = ay; ay = by; by = t;
+        }
+        /* top-left style rule: include the top end, exclude the bottom */
+        if (yc < ay || yc >= by)
+            continue;
+        float x = ax + (yc - ay) * (bx - ax) / (by - ay);
+        if (x < xmin) xmin = x;
+        if (x > xmax) xmax = x;
+        hits++;
+    }
+    if (hits < 2)
+        return false;
+    /* pixels whose center lies in [xmin, xmax) */
+    *x0 = (int) __builtin_ceilf(xmin - 0.5f);
+    *x1 = (int) __builtin_ceilf(xmax - 0.5f);
+    return *x1 > *x0;
+}
+
+static void render_band(struct swrender* sw, int band_y0, int band_y1) {
+    const struct sw_surface* dst = &sw->shadow;
+
+    for (int c = 0; c < sw->num_cmds; c++) {
+        const struct sw_cmd* cmd = &sw->cmds[c];
+        int y0 = cmd->y0 > band_y0 ? cmd->y0 : band_y0;
+        int y1 = cmd->y1 < band_y1 ? cmd->y1 : band_y1;
+
+        for (int y = y0; y < y1; y++) {
+            uint32_t* row = dst->pixels + (size_t) y * dst->stride;
+            const uint32_t* src_row = NULL;
+            int x0 = cmd->x0, x1 = cmd->x1;
+
+            if (cmd->type == SW_CMD_TRIANGLE) {
+                if (!triangle_span(cmd->v, y + 0.5f, &x0, &x1))
+                    continue;
+                if (x0 < cmd->x0) x0 = cmd->x0;
+                if (x1 > cmd->x1) x1 = cmd->x1;
+                if (x1 <= x0)
+                    continue;
+            }
+            if (cmd->src) {
+                /* cmd->x0/y0 are clipped: recover the source offset from the unclipped origin */
+                src_row = cmd->src->pixels + (size_t) (y - (int) cmd->v[1]) * cmd->src->stride + (x0 - (int) cmd->v[0]);
+            }
+
+            switch (cmd->type) {
+            case SW_CMD_FILL:
+            case SW_CMD_TRIANGLE:
+                span_fill(row + x0, x1 - x0, cmd->color);
+                break;
+            case SW_CMD_BLEND:
+                span_blend(row + x0, x1 - x0, cmd->color);
+                break;
+            case SW_CMD_BLIT:
+                memcpy(row + x0, src_row, (size_t) (x1 - x0) * 4);
+                break;
+            case SW_CMD_BLIT_BLEND:
+                span_blend_src(row + x0, src_row, x1 - x0);
+                break;
+            }
+        }
+    }
+
+    if (!sw->present)
+        return;
+    /* stream the finished band into the (write-combined) dumb buffer */
+    const struct dumb_buffer* buf = &sw->buffers[sw->back];
+    for (int y = band_y0; y < band_y1; y++)
+        memcpy((uint8_t*) buf->map + (size_t) y * buf->pitch, dst->pixels + (size_t) y * dst->stride, (size_t) sw->width * 4);
+}
+
+static void band_range(const struct swrender* sw, int band, int* y0, int* y1) {
+    int bands = sw->num_threads + 1;
+    *y0 = sw->height * band / bands;
+    *y1 = sw->height * (band + 1) / bands;
+}
+
+static void* worker_main(void* data) {
+    struct swrender* sw = data;
+    unsigned int seen = 0;
+    int band, y0, y1;
+
+    pthread_mutex_lock(&sw->lock);
+    band = ++sw->pending;       /* bands 1..num_threads, band 0 is the caller's */
+    pthread_cond_signal(&sw->done_cond);
+    while (true) {
+        while (sw->generation == seen && !sw->quit)
+            pthread_cond_wait(&sw->start_cond, &sw->lock);
+        if (sw->quit)
+            break;
+        seen = sw->generation;
+        pthread_mutex_unlock(&sw->lock);
+
+        band_range(sw, band, &y0, &y1);
+        render_band(sw, y0, y1);
+
+        pthread_mutex_lock(&sw->lock);
+        if (--sw->pending == 0)
+            pthread_cond_signal(&sw->done_cond);
+    }
+    pthread_mutex_unlock(&sw->lock);
+    return NULL;
+}
+
+// ============================================================================================
+// dumb buffers
+// ============================================================================================
+
+static int create_dumb_buffer(int fd, int width, int height, struct dumb_buffer* buf) {
+    struct drm_mode_create_dumb create = { .width = width, .height = height, .bpp = 32 };
+    struct drm_mode_map_dumb map = { 0 };
+    uint32_t handles[4] = { 0 }, pitches[4] = { 0 }, offsets[4] = { 0 };
+
+    if (drmIoctl(fd, DRM_IOCTL_MODE_CREATE_DUMB, &create)) {
+        printf("create_dumb_buffer: DRM_IOCTL_MODE_CREATE_DUMB failed: %s\n", strerror(errno));
+        return -1;
+    }
+    buf->handle = create.handle;
+    buf->pitch = create.pitch;
+    buf->size = create.size;
+
+    handles[0] = buf->handle;
+    pitches[0] = buf->pitch;
+    if (drmModeAddFB2(fd, width, height, DRM_FORMAT_XRGB8888, handles, pitches, offsets, &buf->fb_id, 0)) {
+        printf("create_dumb_buffer: drmModeAddFB2 failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    map.handle = buf->handle;
+    if (drmIoctl(fd, DRM_IOCTL_MODE_MAP_DUMB, &map)) {
+        printf("create_dumb_buffer: DRM_IOCTL_MODE_MAP_DUMB failed: %s\n", strerror(errno));
+        return -1;
+    }
+    buf->map = mmap(NULL, buf->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, map.offset);
+    if (buf->map == MAP_FAILED) {
+        printf("create_dumb_buffer: mmap failed: %s\n", strerror(errno));
+        buf->map = NULL;
+        return -1;
+    }
+    memset(buf->map, 0, buf->size);
+    debug_printf("create_dumb_buffer: %dx%d pitch=%u fb_id=%u\n", width, height, buf->pitch, buf->fb_id);
+    return 0;
+}
+
+static void destroy_dumb_buffer(int fd, struct dumb_buffer* buf) {
+    struct drm_mode_destroy_dumb destroy = { .handle = buf->handle };
+
+    if (buf->map)
+        munmap(buf->map, buf->size);
+    if (buf->fb_id)
+        drmModeRmFB(fd, buf->fb_id);
+    if (buf->handle)
+        drmIoctl(fd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+    memset(buf, 0, sizeof(*buf));
+}
+
+int init_dumb(struct swrender* sw, int drm_fd, int width, int height, int num_threads) {
+    memset(sw, 0, sizeof(*sw));
+    sw->fd = drm_fd;
+    sw->width = width;
+    sw->height = height;
+    pthread_mutex_init(&sw->lock, NULL);
+    pthread_cond_init(&sw->start_cond, NULL);
+    pthread_cond_init(&sw->done_cond, NULL);
+
+    for (int i = 0; i < 2; i++) {
+        if (create_dumb_buffer(drm_fd, width, height, &sw->buffers[i]))
+            return -1;
+    }
+
+    sw->shadow.width = width;
+    sw->shadow.height = height;
+    sw->shadow.stride = (width + 3) & ~3;   /* keep rows 16-byte aligned */
+    if (posix_memalign((void**) &sw->shadow.pixels, 64, (size_t) sw->shadow.stride * height * 4))
+        return -1;
+
+    /* the calling thread renders band 0 */
+    if (num_threads < 1)
+        num_threads = 1;
+    if (num_threads > SW_MAX_THREADS)
+        num_threads = SW_MAX_THREADS;
+
+    pthread_mutex_lock(&sw->lock);
+    for (int i = 0; i < num_threads - 1; i++) {
+        if (pthread_create(&sw->threads[i], NULL, worker_main, sw))
+            break;
+        sw->num_threads++;
+    }
+    /* wait until every worker picked its band number */
+    while (sw->pending != sw->num_threads)
+        pthread_cond_wait(&sw->done_cond, &sw->lock);
+    sw->pending = 0;
+    pthread_mutex_unlock(&sw->lock);
+
+    printf("init_dumb: %dx%d software rendering on %d thread(s)\n", width, height, sw->num_threads + 1);
+    return 0;
+}
+
+void destroy_dumb(struct swrender* sw) {
+    pthread_mutex_lock(&sw->lock);
+    sw->quit = true;
+    pthread_cond_broadcast(&sw->start_cond);
+    pthread_mutex_unlock(&sw->lock);
+    for (int i = 0; i < sw->num_threads; i++)
+        pthread_join(sw->threads[i], NULL);
+    pthread_cond_destroy(&sw->start_cond);
+    pthread_cond_destroy(&sw->done_cond);
+    pthread_mutex_destroy(&sw->lock);
+
+    for (int i = 0; i < 2; i++)
+        destroy_dumb_buffer(sw->fd, &sw->buffers[i]);
+    free(sw->shadow.pixels);
+    sw->shadow.pixels = NULL;
+}
+
+/* Rasterize the queued commands into the shadow on all threads and empty the
+ * list; present also copies the shadow to the back buffer
+ */
+static void run_cmds(struct swrender* sw, bool present) {
+    int y0, y1;
+
+    pthread_mutex_lock(&sw->lock);
+    sw->present = present;
+    sw->pending = sw->num_threads;
+    sw->generation++;
+    pthread_cond_broadcast(&sw->start_cond);
+    pthread_mutex_unlock(&sw->lock);
+
+    band_range(sw, 0, &y0, &y1);
+    render_band(sw, y0, y1);
+
+    pthread_mutex_lock(&sw->lock);
+    while (sw->pending)
+        pthread_cond_wait(&sw->done_cond, &sw->lock);
+    pthread_mutex_unlock(&sw->lock);
+
+    sw->num_cmds = 0;
+}
+
+// ============================================================================================
+// recording
+// ============================================================================================
+
+/* queue a command clipped to the surface; returns NULL when fully clipped */
+static struct sw_cmd* push_cmd(struct swrender* sw, enum sw_cmd_type type, int x, int y, int w, int h) {
+    struct sw_cmd* cmd;
+    int x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+    int x1 = x + w > sw->width ? sw->width : x + w;
+    int y1 = y + h > sw->height ? sw->height : y + h;
+
+    if (x1 <= x0 || y1 <= y0)
+        return NULL;
+    if (sw->num_cmds == SW_MAX_CMDS) {
+        /* the shadow keeps what is drawn so far, the frame goes on from there */
+        debug_printf("push_cmd: command list full, flushing early\n");
+        run_cmds(sw, false);
+    }
+    cmd = &sw->cmds[sw->num_cmds++];
+    *cmd = (struct sw_cmd) { .type = type, .x0 = x0, .y0 = y0, .x1 = x1, .y1 = y1 };
+    cmd->v[0] = x;
+    cmd->v[1] = y;
+    return cmd;
+}
+
+void sw_fill_rect(struct swrender* sw, int x, int y, int w, int h, uint32_t color) {
+    struct sw_cmd* cmd = push_cmd(sw, SW_CMD_FILL, x, y, w, h);
+    if (cmd)
+        cmd->color = color;
+}
+
+void sw_blend_rect(struct swrender* sw, int x, int y, int w, int h, uint32_t argb) {
+    struct sw_cmd* cmd;
+
+    if ((argb >> 24) == 0xff) {
+        sw_fill_rect(sw, x, y, w, h, argb);
+        return;
+    }
+    if ((argb >> 24) == 0)
+        return;
+    cmd = push_cmd(sw, SW_CMD_BLEND, x, y, w, h);
+    if (cmd)
+        cmd->color = argb;
+}
+
+void sw_blit(struct swrender* sw, int x, int y, const struct sw_surface* src) {
+    struct sw_cmd* cmd = push_cmd(sw, SW_CMD_BLIT, x, y, src->width, src->height);
+    if (cmd)
+        cmd->src = src;
+}
+
+void sw_blit_blend(struct swrender* sw, int x, int y, const struct sw_surface* src) {
+    struct sw_cmd* cmd = push_cmd(sw, SW_CMD_BLIT_BLEND, x, y, src->width, src->height);
+    if (cmd)
+        cmd->src = src;
+}
+
+void sw_fill_triangle(struct swrender* sw, const float v[6], uint32_t color) {
+    float xmin = v[0], xmax = v[0], ymin = v[1], ymax = v[1];
+    struct sw_cmd* cmd;
+
+    for (int i = 1; i < 3; i++) {
+        if (v[i * 2] < xmin) xmin = v[i * 2];
+        if (v[i * 2] > xmax) xmax = v[i * 2];
+        if (v[i * 2 + 1] < ymin) ymin = v[i * 2 + 1];
+        if (v[i * 2 + 1] > ymax) ymax = v[i * 2 + 1];
+    }
+    cmd = push_cmd(sw, SW_CMD_TRIANGLE, (int) xmin, (int) ymin,
+        (int) __builtin_ceilf(xmax) - (int) xmin + 1, (int) __builtin_ceilf(ymax) - (int) ymin + 1);
+    if (!cmd)
+        return;
+    cmd->color = color;
+    memcpy(cmd->v, v, sizeof(cmd->v));
+}
+
+uint32_t sw_flush(struct swrender* sw) {
+    uint32_t fb_id = sw->buffers[sw->back].fb_id;
+
+    run_cmds(sw, true);
+    sw->back ^= 1;
+    return fb_id;
+}
@@ -0,0 +1,89 @@
+/*
+Software rendering backend: DRM dumb buffers + CPU rasterizer
+for boards where the GPU driver is broken or absent
+ */
+
+#ifndef _SWRENDER_H
+#define _SWRENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define SW_MAX_THREADS 8
+#define SW_MAX_CMDS 1024
+
+/* 32bpp pixels, 0xAARRGGBB in native order (DRM_FORMAT_ARGB8888/XRGB8888) */
+struct sw_surface {
+    uint32_t* pixels;
+    int width, height;
+    int stride;                 /* in pixels */
+};
+
+struct dumb_buffer {
+    uint32_t handle;
+    uint32_t pitch;
+    uint64_t size;
+    uint32_t fb_id;
+    void* map;
+};
+
+enum sw_cmd_type {
+    SW_CMD_FILL,                /* opaque rectangle */
+    SW_CMD_BLEND,               /* rectangle blended with the color's alpha */
+    SW_CMD_BLIT,                /* opaque copy of an image */
+    SW_CMD_BLIT_BLEND,          /* copy of an image blended with its per-pixel alpha */
+    SW_CMD_TRIANGLE,            /* opaque flat shaded triangle */
+};
+
+struct sw_cmd {
+    enum sw_cmd_type type;
+    int x0, y0, x1, y1;         /* destination bounds, x1/y1 exclusive */
+    uint32_t color;
+    const struct sw_surface* src;
+    float v[6];                 /* triangle vertices in pixels */
+};
+
+struct swrender {
+    int fd;
+    int width, height;
+    struct dumb_buffer buffers[2];
+    int back;                   /* index of the buffer to render into */
+
+    /* Rendering goes to a cached shadow surface: dumb buffer mappings are
+     * usually write-combined, so reading them back for blending is slow.
+     * Each band is copied to the dumb buffer once it is finished.
+     */
+    struct sw_surface shadow;
+    struct sw_cmd cmds[SW_MAX_CMDS];
+    int num_cmds;
+
+    /* worker threads, each rasterizing its own band of scanlines */
+    pthread_t threads[SW_MAX_THREADS];
+    int num_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t start_cond, done_cond;
+    unsigned int generation;
+    int pending;
+    bool present;               /* copy the bands to the back buffer, else only the shadow */
+    bool quit;
+};
+
+int init_dumb(struct swrender* sw, int drm_fd, int width, int height, int num_threads);
+void destroy_dumb(struct swrender* sw);
+
+/* Recording: primitives are queued and rasterized by sw_flush(), or earlier
+ * when SW_MAX_CMDS are queued
+ */
+void sw_fill_rect(struct swrender* sw, int x, int y, int w, int h, uint32_t color);
+void sw_blend_rect(struct swrender* sw, int x, int y, int w, int h, uint32_t argb);
+void sw_blit(struct swrender* sw, int x, int y, const struct sw_surface* src);
+void sw_blit_blend(struct swrender* sw, int x, int y, const struct sw_surface* src);
+void sw_fill_triangle(struct swrender* sw, const float v[6], uint32_t color);
+
+/* Rasterize the queued primitives into the back buffer on all threads.
+ * Returns the fb_id to flip to; the next frame renders into the other buffer.
+ */
+uint32_t sw_flush(struct swrender* sw);
+
+#endif /* _SWRENDER_H */
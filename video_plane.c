@@ -0,0 +1,159 @@
+/*
+Direct scanout of dma-buf video frames on a KMS plane
+
+Frames are imported into the DRM device with PRIME and wrapped as
+framebuffers by add_fb(), the same multi-plane path used for GBM buffers,
+then put on an overlay (or primary) plane with drmModeSetPlane(). The GPU
+never touches the pixels. Framebuffers are cached per dma-buf, since
+decoders cycle through a small pool of buffers.
+ */
+
+#include "video_plane.h"
+#include "drm_plane.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+int init_video_plane(struct video_plane* vp, int fd, uint32_t crtc_id, int crtc_index,
+    uint32_t format, uint64_t modifier, bool allow_primary) {
+    memset(vp, 0, sizeof(*vp));
+    vp->fd = fd;
+    vp->crtc_id = crtc_id;
+    vp->format = format;
+    vp->modifier = modifier;
+
+    /* overlays and the primary plane are only listed for universal plane clients */
+    drmSetClientCap(fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+    vp->plane_id = find_plane_for_format(fd, crtc_id, crtc_index, format, modifier, allow_primary);
+    if (!vp->plane_id) {
+        printf("init_video_plane: no plane scans out %.4s, modifier 0x%" PRIx64 "\n", (const char*) &format, modifier);
+        return -1;
+    }
+    printf("init_video_plane: %.4s frames on plane %u\n", (const char*) &format, vp->plane_id);
+    return 0;
+}
+
+static void release_fb(struct video_plane* vp, struct video_fb* entry) {
+    if (entry->fb_id)
+        drmModeRmFB(vp->fd, entry->fb_id);
+    memset(entry, 0, sizeof(*entry));
+}
+
+void destroy_video_plane(struct video_plane* vp) {
+    if (vp->plane_id && vp->shown_fb)
+        drmModeSetPlane(vp->fd, vp->plane_id, vp->crtc_id, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    vp->shown_fb = 0;
+    for (int i = 0; i < VIDEO_FB_CACHE_SIZE; i++) {
+        if (vp->cache[i].fb_id)
+            release_fb(vp, &vp->cache[i]);
+    }
+}
+
+static void close_handles(int fd, const uint32_t handles[DMABUF_MAX_PLANES]) {
+    for (int i = 0; i < DMABUF_MAX_PLANES && handles[i]; i++) {
+        bool seen = false;
+
+        /* planes sharing one dma-buf share the handle */
+        for (int j = 0; j < i; j++)
+            seen |= handles[j] == handles[i];
+        if (!seen)
+            drmIoctl(fd, DRM_IOCTL_GEM_CLOSE, &(struct drm_gem_close) { .handle = handles[i] });
+    }
+}
+
+static uint32_t create_fb(struct video_plane* vp, const struct dmabuf_desc* desc) {
+    uint32_t handles[4] = { 0 }, pitches[4] = { 0 }, offsets[4] = { 0 };
+    uint32_t fb_id = 0;
+    int ret = 0;
+
+    for (int i = 0; i < desc->num_planes && i < DMABUF_MAX_PLANES && !ret; i++) {
+        ret = drmPrimeFDToHandle(vp->fd, desc->fds[i], &handles[i]);
+        pitches[i] = desc->pitches[i];
+        offsets[i] = desc->offsets[i];
+    }
+    if (!ret)
+        ret = add_fb(vp->fd, desc->width, desc->height, desc->format, handles, pitches, offsets, desc->modifier, &fb_id);
+    if (ret)
+        printf("video_plane_show: failed to create fb: %s\n", strerror(errno));
+
+    /* The framebuffer holds its own reference to the buffer. The handles are
+     * not needed anymore, and must not outlive it: once the producer frees the
+     * buffer a new import could get the same handle numbers.
+     */
+    close_handles(vp->fd, handles);
+    return ret ? 0 : fb_id;
+}
+
+static struct video_fb* lookup(struct video_plane* vp, const struct stat* st, const struct dmabuf_desc* desc) {
+    for (int i = 0; i < VIDEO_FB_CACHE_SIZE; i++) {
+        struct video_fb* entry = &vp->cache[i];
+
+        if (entry->fb_id && entry->dev == st->st_dev && entry->ino == st->st_ino &&
+            entry->offset == desc->offsets[0])
+            return entry;
+    }
+    return NULL;
+}
+
+static struct video_fb* evict(struct video_plane* vp) {
+    struct video_fb* victim = NULL;
+
+    for (int i = 0; i < VIDEO_FB_CACHE_SIZE; i++) {
+        struct video_fb* entry = &vp->cache[i];
+
+        if (!entry->fb_id)
+            return entry;
+        /* removing the framebuffer on screen would switch the plane off */
+        if (entry->fb_id != vp->shown_fb && (!victim || entry->last_used < victim->last_used))
+            victim = entry;
+    }
+    release_fb(vp, victim);
+    return victim;
+}
+
+int video_plane_show(struct video_plane* vp, const struct dmabuf_desc* desc, int x, int y, int w, int h) {
+    struct video_fb* entry;
+    struct stat st;
+
+    if (desc->num_planes < 1 || fstat(desc->fds[0], &st))
+        return -1;
+
+    vp->clock++;
+    entry = lookup(vp, &st, desc);
+    if (!entry) {
+        entry = evict(vp);
+        entry->fb_id = create_fb(vp, desc);
+        if (!entry->fb_id)
+            return -1;
+        entry->dev = st.st_dev;
+        entry->ino = st.st_ino;
+        entry->offset = desc->offsets[0];
+    }
+    entry->last_used = vp->clock;
+
+    /* source rectangle in 16.16 fixed point */
+    if (drmModeSetPlane(vp->fd, vp->plane_id, vp->crtc_id, entry->fb_id, 0, x, y, w, h,
+        0, 0, (uint32_t) desc->width << 16, (uint32_t) desc->height << 16)) {
+        printf("video_plane_show: drmModeSetPlane failed: %s\n", strerror(errno));
+        return -1;
+    }
+    vp->shown_fb = entry->fb_id;
+    return 0;
+}
+
+void video_plane_forget(struct video_plane* vp, int fd) {
+    struct stat st;
+
+    if (fstat(fd, &st))
+        return;
+    for (int i = 0; i < VIDEO_FB_CACHE_SIZE; i++) {
+        struct video_fb* entry = &vp->cache[i];
+
+        if (entry->fb_id && entry->fb_id != vp->shown_fb && entry->dev == st.st_dev && entry->ino == st.st_ino)
+            release_fb(vp, entry);
+    }
+}
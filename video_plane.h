@@ -0,0 +1,58 @@
+/*
+Direct scanout of dma-buf video frames (NV12, P010, ...) on a KMS plane,
+bypassing GL composition when the display engine can read the format
+ */
+
+#ifndef _VIDEO_PLANE_H
+#define _VIDEO_PLANE_H
+
+#include "dmabuf.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define VIDEO_FB_CACHE_SIZE 8
+
+/* A frame wrapped as DRM framebuffer, keyed by the dma-buf inode like the
+ * GL import cache
+ */
+struct video_fb {
+    dev_t dev;
+    ino_t ino;
+    uint32_t offset;
+    uint32_t fb_id;
+    unsigned int last_used;
+};
+
+struct video_plane {
+    int fd;
+    uint32_t crtc_id;
+    uint32_t plane_id;
+    uint32_t format;
+    uint64_t modifier;
+    uint32_t shown_fb;          /* on screen, never evicted */
+    struct video_fb cache[VIDEO_FB_CACHE_SIZE];
+    unsigned int clock;
+};
+
+/* Find a plane of the CRTC that scans out format/modifier. Overlays are
+ * preferred; the primary plane is only considered with allow_primary, for
+ * callers that stop flipping GL frames while video is shown. Returns a
+ * negative value if there is no such plane: use the GL import path instead.
+ */
+int init_video_plane(struct video_plane* vp, int fd, uint32_t crtc_id, int crtc_index,
+    uint32_t format, uint64_t modifier, bool allow_primary);
+
+/* Disable the plane and release every framebuffer */
+void destroy_video_plane(struct video_plane* vp);
+
+/* Show the frame in the CRTC rectangle x, y, w, h, scaled if the plane can.
+ * Returns a negative value if the kernel rejects it (bad layout, no scaling):
+ * the frame then has to go through GL.
+ */
+int video_plane_show(struct video_plane* vp, const struct dmabuf_desc* desc, int x, int y, int w, int h);
+
+/* Drop the framebuffer of the buffer behind fd before its producer frees it */
+void video_plane_forget(struct video_plane* vp, int fd);
+
+#endif /* _VIDEO_PLANE_H */